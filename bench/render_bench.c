@@ -0,0 +1,274 @@
+/**
+ * render_bench.c
+ *
+ * Headless rendering benchmark for the Theseus and the Minotaur Game. The real
+ * rendering path (win_layout, draw_wall, place_win, win_draw_sprite and the movement
+ * functions) is run through a terminal created with newterm() on /dev/null with a
+ * fixed TERM, while a scripted sequence of turns is played. The benchmark reports
+ * frames per second, write system calls per frame and bytes emitted per frame. With
+ * -a, the board is drawn with the raw ANSI backend instead of ncurses. With -b, the game
+ * is also broadcast to a number of local spectators (which implies -a).
+ *
+ * Usage: render_bench [-a] [-b spectators] [-l level_file] [-t turns] [-s LINESxCOLS] [-T term]
+ */
+
+#include "broadcast.h"
+#include "game.h"
+#include "iostat.h"
+
+#include <time.h>
+
+#define DEFAULT_LEVEL "./Levels/level5.txt"
+#define DEFAULT_TURNS 20000
+#define DEFAULT_TERM "xterm-256color"
+#define DEFAULT_SIZE "60x260"
+
+// Seconds elapsed on the monotonic clock
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+// Spectators connected to the broadcast, and a thread reading everything sent to them
+static int num_readers = 0;
+static int *reader_fds = NULL;
+static volatile bool readers_stop = false;
+static unsigned long long reader_bytes = 0;
+
+// Read (and throw away) everything sent to the spectators until told to stop
+static void *drain_spectators(void *arg) {
+	struct epoll_event events[64];
+	static char buffer[65536];
+	int poll_fd = epoll_create1(EPOLL_CLOEXEC);
+	(void)arg;
+
+	for(int i = 0; i < num_readers; i++) {
+		struct epoll_event event;
+		event.events = EPOLLIN;
+		event.data.fd = reader_fds[i];
+		epoll_ctl(poll_fd, EPOLL_CTL_ADD, reader_fds[i], &event);
+	}
+
+	while (!readers_stop) {
+		int num_events = epoll_wait(poll_fd, events, 64, 100);
+
+		for(int i = 0; i < num_events; i++) {
+			ssize_t length = read(events[i].data.fd, buffer, sizeof(buffer));
+			if (length > 0) reader_bytes += length;
+		}
+	}
+	close(poll_fd);
+
+	return NULL;
+}
+
+// Pick the next scripted move (fixed seed so that every run plays the same game)
+static int next_move(unsigned int *seed) {
+	*seed = (*seed * 1103515245u) + 12345u;
+
+	return (*seed >> 16) % (NUM_MOVES + 1);		/* NUM_MOVES means "skip turn" */
+}
+
+int main(int argc, char *argv[]) {
+	const char *level_path = DEFAULT_LEVEL;
+	const char *term = DEFAULT_TERM;
+	const char *size = DEFAULT_SIZE;
+	long turns = DEFAULT_TURNS;
+	bool use_ansi = false;
+	int spectators = 0;
+
+	// Parse the command line options
+	for(int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-a") == 0)
+			use_ansi = true;
+		else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+			spectators = atoi(argv[++i]);
+			use_ansi = true;
+		}
+		else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+			level_path = argv[++i];
+		else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			turns = atol(argv[++i]);
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			size = argv[++i];
+		else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc)
+			term = argv[++i];
+		else {
+			fprintf(stderr, "Usage: %s [-a] [-b spectators] [-l level_file] [-t turns] [-s LINESxCOLS] [-T term]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// Load the level once and remember the starting positions for restarts
+	struct stats board_stats;
+	board_stats.walls = NULL;
+	if (read_level_file(level_path, &board_stats) != 0) {
+		fprintf(stderr, "render_bench: could not load level file '%s'\n", level_path);
+		return 1;
+	}
+	cell_pos theseus_start = board_stats.theseus;
+	cell_pos minotaur_starts[MAX_MINOTAURS];
+	memcpy(minotaur_starts, board_stats.minotaurs, sizeof(minotaur_starts));
+
+	// Give the virtual terminal a fixed size, large enough for the biggest boards
+	char lines[16], cols[16];
+	if (sscanf(size, "%15[0-9]x%15[0-9]", lines, cols) != 2) {
+		fprintf(stderr, "render_bench: invalid screen size '%s'\n", size);
+		return 1;
+	}
+	setenv("LINES", lines, 1);
+	setenv("COLUMNS", cols, 1);
+
+	// Create the terminal on /dev/null so that no person (or real terminal) is needed
+	FILE *out = fopen("/dev/null", "w");
+	FILE *in = fopen("/dev/null", "r");
+	if (out == NULL || in == NULL) {
+		fprintf(stderr, "render_bench: could not open /dev/null\n");
+		return 1;
+	}
+
+	SCREEN *screen = newterm(term, out, in);
+	if (screen == NULL) {
+		fprintf(stderr, "render_bench: unknown terminal type '%s'\n", term);
+		return 1;
+	}
+	set_term(screen);
+	start_color();
+	curs_set(0);
+
+	if (use_ansi) {
+		if (!ansi_init(fileno(out), LINES, COLS)) {
+			fprintf(stderr, "render_bench: could not set up the ANSI backend\n");
+			return 1;
+		}
+		render_backend = BACKEND_ANSI;
+	}
+
+	// Connect the spectators to a broadcast on a temporary socket
+	char socket_path[64];
+	pthread_t drain_thread;
+	if (spectators > 0) {
+		struct sockaddr_un address;
+
+		snprintf(socket_path, sizeof(socket_path), "/tmp/render_bench.%d.sock", (int)getpid());
+		if (!broadcast_start(socket_path, -1, LINES, COLS)) {
+			endwin();
+			perror("render_bench: could not start the broadcast");
+			return 1;
+		}
+
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		strcpy(address.sun_path, socket_path);
+
+		reader_fds = malloc(sizeof(int) * spectators);
+		for(num_readers = 0; num_readers < spectators; num_readers++) {
+			reader_fds[num_readers] = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			if (connect(reader_fds[num_readers], (struct sockaddr *)&address, sizeof(address)) < 0) {
+				close(reader_fds[num_readers]);
+				break;
+			}
+		}
+		pthread_create(&drain_thread, NULL, drain_spectators, NULL);
+	}
+
+	int num_squares = board_stats.size.num_rows * board_stats.size.num_cols;
+	board_square *wins = malloc(sizeof(board_square) * num_squares);
+	WINDOW *exit_win;
+	short theseus_win_pair, minotaur_win_pairs[MAX_MINOTAURS];
+
+	struct io_counters io_start, io_end;
+	bool have_io = read_io_counters(&io_start);
+	unsigned long frames_start = frames_flushed;
+	unsigned int seed = 1;
+	long games = 1;
+	int theseus_moves = 0;
+
+	double start_time = now();
+
+	exit_win = draw_board(&board_stats, wins, &theseus_win_pair, minotaur_win_pairs);
+
+	// Play the scripted sequence of turns, restarting the level whenever the game ends
+	for(long turn = 0; turn < turns; turn++) {
+		int move = next_move(&seed);
+		int result = (move == NUM_MOVES) ? 1 : move_theseus(&board_stats, wins, exit_win, &theseus_win_pair, move);
+		bool game_over = (result == 2 || result == 3);
+
+		// The Minotaurs move once Theseus has made all of his moves for the turn
+		if (result == 1 && ++theseus_moves >= board_stats.rules.theseus_steps) {
+			theseus_moves = 0;
+			for(int i = 0; i < board_stats.num_minotaurs && result != 2; i++) {
+				result = 1;
+				for(int step = 0; step < board_stats.rules.minotaur_steps && result == 1; step++)
+					result = move_minotaur(&board_stats, wins, i, &minotaur_win_pairs[i]);
+			}
+
+			game_over = (result == 2);
+		}
+
+		if (game_over) {
+			for(int i = 0; i < num_squares; i++)
+				delwin(wins[i].win);
+			delwin(exit_win);
+			clear();
+
+			board_stats.theseus = theseus_start;
+			memcpy(board_stats.minotaurs, minotaur_starts, sizeof(minotaur_starts));
+			theseus_moves = 0;
+			exit_win = draw_board(&board_stats, wins, &theseus_win_pair, minotaur_win_pairs);
+			games++;
+		}
+	}
+
+	double elapsed = now() - start_time;
+	unsigned long frames = frames_flushed - frames_start;
+	have_io = have_io && read_io_counters(&io_end);
+
+	struct broadcast_stats bc_stats;
+	if (spectators > 0) {
+		broadcast_get_stats(&bc_stats);
+		broadcast_stop();
+
+		readers_stop = true;
+		pthread_join(drain_thread, NULL);
+		for(int i = 0; i < num_readers; i++)
+			close(reader_fds[i]);
+		free(reader_fds);
+	}
+
+	// Leave curses mode before printing the results
+	for(int i = 0; i < num_squares; i++)
+		delwin(wins[i].win);
+	delwin(exit_win);
+	free(wins);
+	endwin();
+	delscreen(screen);
+	ansi_end();
+	fclose(out);
+	fclose(in);
+	free_walls(board_stats.walls);
+
+	printf("level:              %s (%dx%d)\n", level_path, board_stats.size.num_rows, board_stats.size.num_cols);
+	printf("terminal:           %s, %sx%s (%s)\n", term, lines, cols, use_ansi ? "ANSI backend" : "ncurses");
+	printf("turns:              %ld (%ld games)\n", turns, games);
+	printf("frames:             %lu in %.3f s\n", frames, elapsed);
+	printf("frames/sec:         %.0f\n", frames / elapsed);
+	printf("usec/frame:         %.2f\n", (elapsed * 1e6) / frames);
+
+	if (have_io) {
+		printf("write calls/frame:  %.2f\n", (double)(io_end.write_calls - io_start.write_calls) / frames);
+		printf("bytes/frame:        %.1f\n", (double)(io_end.bytes_written - io_start.bytes_written) / frames);
+	}
+	else printf("write calls/frame:  n/a (/proc/self/io not available)\n");
+
+	if (spectators > 0) {
+		printf("spectators:         %d connected, %llu keyframes (%llu sent)\n", num_readers, bc_stats.keyframes, bc_stats.resyncs);
+		printf("fan-out:            %.2f writev calls/frame, %.1f bytes/frame to all spectators\n",
+		       (double)bc_stats.write_calls / frames, (double)bc_stats.bytes / frames);
+		printf("spectator bytes:    %llu read\n", reader_bytes);
+	}
+
+	return 0;
+}
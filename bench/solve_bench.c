@@ -0,0 +1,244 @@
+/**
+ * solve_bench.c
+ *
+ * Solver benchmark for the Theseus and the Minotaur Game. Random mazes far larger than
+ * the game allows are generated (a depth-first maze with a share of its walls knocked
+ * down, so that there is more than one way around), and every maze is solved with each
+ * search method of the solver: plain breadth-first search, A* and the bidirectional
+ * search. The benchmark reports, for each method, the states expanded, the states visited,
+ * the most memory used by the search's tables and the wall time, and checks that all
+ * methods agree on the length of the solution and that every solution found escapes when
+ * played through the engine.
+ *
+ * Usage: solve_bench [-n mazes] [-s ROWSxCOLS[,ROWSxCOLS...]] [-r <steps><h|v><moves>] [-w percent] [-x seed]
+ */
+
+#include "latency.h"
+#include "solver.h"
+
+#define DEFAULT_MAZES 5
+#define DEFAULT_SIZES "20x20,40x40,60x60"
+#define DEFAULT_RULES "2h1"
+#define DEFAULT_BRAID 15	/* Percent of the maze's remaining walls knocked down */
+#define MAX_SIZES 16
+#define NUM_METHODS 3
+
+static const char *method_names[NUM_METHODS] = {"bfs", "astar", "bidir"};
+
+// Pick a random number below 'limit' (fixed seed so that every run builds the same mazes)
+static int next_random(unsigned long long *seed, int limit) {
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 7;
+	*seed ^= *seed << 17;
+
+	return (int)(*seed % limit);
+}
+
+// Add a wall on one side of a square to the front of a list of walls
+static bool add_wall(cell_rel **walls, int row, int col, short location) {
+	cell_rel *wall = malloc(sizeof(cell_rel));
+	if (wall == NULL) return false;
+
+	wall->relation.row = row;
+	wall->relation.col = col;
+	wall->location = location;
+	wall->next = *walls;
+	*walls = wall;
+
+	return true;
+}
+
+/*
+ * Generate a random maze into a stats structure: carve a perfect maze with a depth-first
+ * search, knock down 'braid' percent of the walls that are left, then put the exit on the
+ * right side and Theseus and the Minotaur on random squares.
+ */
+static bool generate_maze(struct stats *board, int nrows, int ncols, int braid, unsigned long long *seed) {
+	int num_cells = nrows * ncols;
+	unsigned char *open = calloc(num_cells, 1);	/* Bit-mask of the moves carved out of each square */
+	int *stack = malloc(sizeof(int) * num_cells);
+	bool ok = (open != NULL && stack != NULL);
+
+	board->size.num_rows = nrows;
+	board->size.num_cols = ncols;
+	board->walls = NULL;
+	board->num_minotaurs = 1;
+
+	if (ok) {
+		int depth = 0;
+		stack[depth++] = next_random(seed, num_cells);
+		open[stack[0]] = 0x10;		/* Visited, nothing carved yet */
+
+		while (depth > 0) {
+			int cell = stack[depth - 1], row = cell / ncols, col = cell % ncols;
+			int options[NUM_MOVES], num_options = 0;
+
+			if (col > 0 && !open[cell - 1]) options[num_options++] = LEFT;
+			if (col < ncols - 1 && !open[cell + 1]) options[num_options++] = RIGHT;
+			if (row > 0 && !open[cell - ncols]) options[num_options++] = UP;
+			if (row < nrows - 1 && !open[cell + ncols]) options[num_options++] = DOWN;
+
+			if (num_options == 0) {
+				depth--;
+				continue;
+			}
+
+			int move = options[next_random(seed, num_options)];
+			int next = (move == LEFT) ? cell - 1 : (move == RIGHT) ? cell + 1 : (move == UP) ? cell - ncols : cell + ncols;
+			static const int opposite[NUM_MOVES] = {RIGHT, LEFT, DOWN, UP};
+
+			open[cell] |= moves[move];
+			open[next] |= moves[opposite[move]] | 0x10;
+			stack[depth++] = next;
+		}
+
+		// Keep the walls that weren't carved or knocked down (only right and bottom sides, to list each once)
+		for(int cell = 0; cell < num_cells && ok; cell++) {
+			int row = cell / ncols, col = cell % ncols;
+
+			if (col < ncols - 1 && !(open[cell] & moves[RIGHT]) && next_random(seed, 100) >= braid)
+				ok = add_wall(&board->walls, row, col, RIGHT);
+			if (row < nrows - 1 && !(open[cell] & moves[DOWN]) && next_random(seed, 100) >= braid && ok)
+				ok = add_wall(&board->walls, row, col, DOWN);
+		}
+
+		board->exit.relation.row = next_random(seed, nrows);
+		board->exit.relation.col = ncols - 1;
+		board->exit.location = RIGHT;
+
+		board->theseus.row = next_random(seed, nrows);
+		board->theseus.col = next_random(seed, ncols / 2);
+		do {
+			board->minotaurs[0].row = next_random(seed, nrows);
+			board->minotaurs[0].col = next_random(seed, ncols);
+		} while (board->minotaurs[0].row == board->theseus.row && board->minotaurs[0].col == board->theseus.col);
+	}
+
+	free(open);
+	free(stack);
+
+	return ok;
+}
+
+// Play a solution through the engine: returns true if Theseus escapes with the last move
+static bool replay_solution(const struct engine_level *level, const char *moves_string) {
+	struct engine_state state;
+	engine_result result = ENGINE_MOVED;
+
+	engine_reset(level, &state);
+	for(const char *c = moves_string; *c != '\0' && result == ENGINE_MOVED; c++)
+		result = engine_turn(level, &state, (short)(strchr("LRUDS", *c) - "LRUDS"));
+
+	return (result == ENGINE_ESCAPED);
+}
+
+int main(int argc, char *argv[]) {
+	int num_mazes = DEFAULT_MAZES, braid = DEFAULT_BRAID;
+	const char *sizes = DEFAULT_SIZES, *rules_arg = DEFAULT_RULES;
+	unsigned long long seed = 88172645463325252ULL;
+
+	// Parse the command line options
+	for(int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			num_mazes = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			sizes = argv[++i];
+		else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+			rules_arg = argv[++i];
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+			braid = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc)
+			seed = strtoull(argv[++i], NULL, 10) | 1;
+		else {
+			fprintf(stderr, "Usage: %s [-n mazes] [-s ROWSxCOLS[,ROWSxCOLS...]] [-r <steps><h|v><moves>] [-w percent] [-x seed]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	struct rules rules;
+	char preference;
+	if (sscanf(rules_arg, "%hd%c%hd", &rules.minotaur_steps, &preference, &rules.theseus_steps) != 3
+	    || rules.minotaur_steps < 1 || rules.minotaur_steps > MAX_MINOTAUR_STEPS
+	    || rules.theseus_steps < 1 || rules.theseus_steps > MAX_THESEUS_STEPS || (preference != 'h' && preference != 'v')) {
+		fprintf(stderr, "solve_bench: invalid rules '%s'\n", rules_arg);
+		return 1;
+	}
+	rules.vertical_first = (preference == 'v');
+
+	// Parse the list of maze sizes
+	int rows[MAX_SIZES], cols[MAX_SIZES], num_sizes = 0;
+	for(const char *p = sizes; *p != '\0' && num_sizes < MAX_SIZES; ) {
+		int consumed;
+		if (sscanf(p, "%dx%d%n", &rows[num_sizes], &cols[num_sizes], &consumed) != 2 || rows[num_sizes] < 2 || cols[num_sizes] < 2) {
+			fprintf(stderr, "solve_bench: invalid maze size in '%s'\n", sizes);
+			return 1;
+		}
+		num_sizes++;
+		p += consumed;
+		if (*p == ',') p++;
+	}
+
+	printf("rules %d %c %d, %d mazes per size, %d%% of the walls knocked down\n\n",
+	       rules.minotaur_steps, preference, rules.theseus_steps, num_mazes, braid);
+	printf("%-9s %-6s %9s %14s %14s %12s %12s\n", "size", "method", "solvable", "expanded", "states", "memory (KB)", "time (ms)");
+
+	for(int z = 0; z < num_sizes; z++) {
+		long expanded[NUM_METHODS] = {0}, states[NUM_METHODS] = {0};
+		int solvable[NUM_METHODS] = {0};
+		size_t memory[NUM_METHODS] = {0};
+		unsigned long long usecs[NUM_METHODS] = {0};
+
+		for(int n = 0; n < num_mazes; n++) {
+			struct stats board;
+			struct engine_level level;
+
+			board.rules = rules;
+			if (!generate_maze(&board, rows[z], cols[z], braid, &seed) || !engine_load(&level, &board)) {
+				fprintf(stderr, "solve_bench: out of memory\n");
+				return 1;
+			}
+			free_walls(board.walls);
+
+			// Solve the maze with every method, and make sure they agree
+			int turns = -1;
+			for(int m = 0; m < NUM_METHODS; m++) {
+				struct solution sol;
+				unsigned long long start_time = lat_now();
+
+				if (!solve_level(&level, (search_method)m, &sol)) {
+					fprintf(stderr, "solve_bench: out of memory\n");
+					return 1;
+				}
+				usecs[m] += lat_now() - start_time;
+				expanded[m] += sol.expanded;
+				states[m] += sol.states;
+				if (sol.memory > memory[m]) memory[m] = sol.memory;
+
+				int found = sol.solvable ? sol.turns : 0;
+				if (sol.solvable && !replay_solution(&level, sol.moves)) {
+					fprintf(stderr, "solve_bench: %s found a solution that doesn't escape (maze %d of %dx%d)\n",
+						method_names[m], n, rows[z], cols[z]);
+					return 1;
+				}
+				if (m == 0) turns = found;
+				else if (found != turns) {
+					fprintf(stderr, "solve_bench: %s found %d turns, bfs found %d (maze %d of %dx%d)\n",
+						method_names[m], found, turns, n, rows[z], cols[z]);
+					return 1;
+				}
+				solvable[m] += sol.solvable;
+				free_solution(&sol);
+			}
+			engine_free(&level);
+		}
+
+		for(int m = 0; m < NUM_METHODS; m++) {
+			char size[32];
+			snprintf(size, sizeof(size), "%dx%d", rows[z], cols[z]);
+			printf("%-9s %-6s %5d/%-3d %14ld %14ld %12zu %12.1f\n", (m == 0) ? size : "", method_names[m],
+			       solvable[m], num_mazes, expanded[m], states[m], (memory[m] + 1023) / 1024, usecs[m] / 1e3);
+		}
+	}
+
+	return 0;
+}
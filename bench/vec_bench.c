@@ -0,0 +1,199 @@
+/**
+ * vec_bench.c
+ *
+ * Vectorized environment benchmark for the Theseus and the Minotaur Game. It is linked
+ * against libtheseus only (no ncurses): the levels of a level list are loaded from memory,
+ * and a number of threads each step their own th_vec environment with random moves,
+ * the way a reinforcement-learning job would. The benchmark reports the steps per second
+ * (one step is one move in one game), the games finished, and how they ended.
+ *
+ * Usage: vec_bench [-l level_list] [-n games] [-s steps] [-m max_steps] [-t threads]
+ */
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libtheseus.h"
+
+#define DEFAULT_LIST "./Levels/levellist.txt"
+#define DEFAULT_GAMES 4096
+#define DEFAULT_STEPS 2000
+#define DEFAULT_MAX_STEPS 200
+#define MAX_LEVELS 64
+#define MAX_LEVEL_BYTES 8192
+#define MAX_THREADS 64
+
+// Structure to hold the work and the counts of one thread
+struct worker {
+	pthread_t thread;
+	th_level **levels;
+	int num_levels;
+	int num_games;
+	int num_steps;
+	int max_steps;
+	unsigned long long seed;
+
+	bool failed;
+	long escaped;
+	long caught;
+	long truncated;
+};
+
+// Seconds elapsed on the monotonic clock
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+// Read a level file into a level: returns false if it could not be read or loaded
+static bool load_file(const char *path, th_level **level) {
+	char buffer[MAX_LEVEL_BYTES];
+	FILE *file = fopen(path, "r");
+	if (file == NULL) return false;
+
+	size_t length = fread(buffer, 1, sizeof(buffer), file);
+	fclose(file);
+
+	return (th_level_load(buffer, length, level) == 0);
+}
+
+// Step an environment of its own with random moves
+static void *run_worker(void *arg) {
+	struct worker *work = arg;
+	size_t obs_size = th_vec_shape(work->levels, work->num_levels, NULL, NULL);
+	unsigned char *obs = malloc(obs_size * work->num_games);
+	float *rewards = malloc(sizeof(float) * work->num_games);
+	unsigned char *dones = malloc(work->num_games);
+	th_move *actions = malloc(sizeof(th_move) * work->num_games);
+	th_vec *vec = NULL;
+
+	if (obs != NULL && rewards != NULL && dones != NULL && actions != NULL)
+		vec = th_vec_new(work->levels, work->num_levels, work->num_games, work->max_steps, obs, rewards, dones);
+	work->failed = (vec == NULL);
+
+	for(int step = 0; vec != NULL && step < work->num_steps; step++) {
+		for(int i = 0; i < work->num_games; i++) {
+			work->seed ^= work->seed << 13;
+			work->seed ^= work->seed >> 7;
+			work->seed ^= work->seed << 17;
+			actions[i] = (th_move)(work->seed % (TH_SKIP + 1));
+		}
+		th_vec_step(vec, actions);
+
+		for(int i = 0; i < work->num_games; i++) {
+			if (dones[i] == TH_TRUNCATED) work->truncated++;
+			else if (dones[i] == TH_TERMINATED) {
+				if (rewards[i] > 0) work->escaped++;
+				else work->caught++;
+			}
+		}
+	}
+
+	th_vec_free(vec);
+	free(obs);
+	free(rewards);
+	free(dones);
+	free(actions);
+
+	return NULL;
+}
+
+int main(int argc, char *argv[]) {
+	const char *list_path = DEFAULT_LIST;
+	int num_games = DEFAULT_GAMES, num_steps = DEFAULT_STEPS, max_steps = DEFAULT_MAX_STEPS, num_threads = 1;
+
+	// Parse the command line options
+	for(int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+			list_path = argv[++i];
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			num_games = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+			num_steps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+			max_steps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+			num_threads = atoi(argv[++i]);
+		else {
+			fprintf(stderr, "Usage: %s [-l level_list] [-n games] [-s steps] [-m max_steps] [-t threads]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (num_threads < 1 || num_threads > MAX_THREADS) num_threads = 1;
+
+	// Load the levels of the list
+	th_level *levels[MAX_LEVELS];
+	int num_levels = 0;
+	char line[512];
+	FILE *list = fopen(list_path, "r");
+
+	if (list == NULL) {
+		fprintf(stderr, "vec_bench: %s: could not open level list\n", list_path);
+		return 1;
+	}
+	while (num_levels < MAX_LEVELS && fgets(line, sizeof(line), list) != NULL) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0') continue;
+		if (!load_file(line, &levels[num_levels])) {
+			fprintf(stderr, "vec_bench: %s: could not load level\n", line);
+			fclose(list);
+			return 1;
+		}
+		num_levels++;
+	}
+	fclose(list);
+	if (num_levels == 0 || num_games < num_levels) {
+		fprintf(stderr, "vec_bench: need at least one level and one game per level\n");
+		return 1;
+	}
+
+	int rows, cols;
+	size_t obs_size = th_vec_shape(levels, num_levels, &rows, &cols);
+	printf("%d levels, %d threads x %d games, %d steps, observations of %d planes x %dx%d (%zu bytes)\n",
+	       num_levels, num_threads, num_games, num_steps, TH_OBS_PLANES, rows, cols, obs_size);
+
+	// Step one environment per thread
+	struct worker workers[MAX_THREADS];
+	int started = 0;
+	double start_time = now();
+
+	for(int t = 0; t < num_threads; t++) {
+		workers[t] = (struct worker){.levels = levels, .num_levels = num_levels, .num_games = num_games,
+					     .num_steps = num_steps, .max_steps = max_steps, .seed = 88172645463325252ULL + (t * 2) + 1};
+		if (pthread_create(&workers[t].thread, NULL, run_worker, &workers[t]) != 0) break;
+		started++;
+	}
+
+	long escaped = 0, caught = 0, truncated = 0;
+	bool failed = (started < num_threads);
+	for(int t = 0; t < started; t++) {
+		pthread_join(workers[t].thread, NULL);
+		failed = failed || workers[t].failed;
+		escaped += workers[t].escaped;
+		caught += workers[t].caught;
+		truncated += workers[t].truncated;
+	}
+	double elapsed = now() - start_time;
+
+	for(int k = 0; k < num_levels; k++)
+		th_level_free(levels[k]);
+	if (failed) {
+		fprintf(stderr, "vec_bench: could not start every environment\n");
+		return 1;
+	}
+
+	double total_steps = (double)started * num_games * num_steps;
+	printf("%.0f steps in %.3f s: %.1f million steps/s\n", total_steps, elapsed, total_steps / elapsed / 1e6);
+	printf("games finished: %ld escaped, %ld caught, %ld truncated\n", escaped, caught, truncated);
+
+	return 0;
+}
@@ -0,0 +1,513 @@
+#include "analysis.h"
+#include "kernels.h"
+
+#define TURN_CODE_BASE (NUM_MOVES + 1)		/* A turn's moves are numbered as digits in this base */
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL	/* Fibonacci hashing of the packed states */
+#define INITIAL_NODES 1024			/* Nodes of a state graph to start with */
+#define CATALOG_LINE 512			/* Longest line of a catalog (including the newline) */
+
+#define NODE_ESCAPES 1				/* Theseus can escape from the node's state this turn */
+#define NODE_TRAP 2				/* A Minotaur stays stuck behind a wall whatever Theseus does */
+
+// Structure to hold the graph of the states of a level that can be reached
+struct state_graph {
+	uint64_t *keys;			/* Packed state of each node (in the order found) */
+	long *edge_start;		/* First edge of each node (the next node's first edge ends it) */
+	unsigned char *flags;		/* NODE_ESCAPES and NODE_TRAP for each node */
+	long num_nodes;
+	long node_capacity;
+
+	int *slots;			/* Node + 1 in each slot of an open-addressing table (0 marks an empty slot) */
+	long num_slots;			/* A power of two, at most half full */
+	int shift;			/* 64 - log2(num_slots), to take the top bits of the hash */
+
+	int *edge_to;			/* Node each edge leads to */
+	unsigned char *edge_move;	/* First move of the turn that follows each edge */
+	long num_edges;
+	long edge_capacity;
+};
+
+// Structure to hold the work shared by the threads analyzing a pack
+struct catalog_work {
+	char **paths;
+	struct level_metrics *metrics;
+	int *status;			/* 0 if analyzed, else the code of read_level_file() (2 if it couldn't be analyzed) */
+	int num_levels;
+	int next;			/* Next level to analyze (taken atomically) */
+};
+
+// Replace the table of a state graph with an empty one of a given size, then put every node back in
+static bool resize_slots(struct state_graph *graph, long num_slots) {
+	int *slots = calloc(num_slots, sizeof(int));
+	if (slots == NULL) return false;
+
+	free(graph->slots);
+	graph->slots = slots;
+	graph->num_slots = num_slots;
+	graph->shift = 64;
+	for(long s = num_slots; s > 1; s >>= 1)
+		graph->shift--;
+
+	for(long n = 0; n < graph->num_nodes; n++) {
+		long slot = (long)((graph->keys[n] * HASH_MULTIPLIER) >> graph->shift);
+
+		while (slots[slot] != 0)
+			slot = (slot + 1) & (num_slots - 1);
+		slots[slot] = n + 1;
+	}
+
+	return true;
+}
+
+// Find the node of a state, adding it if it's new: returns the node, or -1 if out of memory (or room for nodes)
+static long find_node(struct state_graph *graph, uint64_t key) {
+	long slot = (long)((key * HASH_MULTIPLIER) >> graph->shift);
+
+	while (graph->slots[slot] != 0) {
+		if (graph->keys[graph->slots[slot] - 1] == key) return graph->slots[slot] - 1;
+		slot = (slot + 1) & (graph->num_slots - 1);
+	}
+
+	if (graph->num_nodes == ANALYSIS_MAX_STATES) return -1;
+	if (graph->num_nodes == graph->node_capacity) {
+		long capacity = graph->node_capacity * 2;
+
+		uint64_t *keys = realloc(graph->keys, sizeof(uint64_t) * capacity);
+		if (keys == NULL) return -1;
+		graph->keys = keys;
+
+		long *edge_start = realloc(graph->edge_start, sizeof(long) * (capacity + 1));
+		if (edge_start == NULL) return -1;
+		graph->edge_start = edge_start;
+
+		unsigned char *flags = realloc(graph->flags, capacity);
+		if (flags == NULL) return -1;
+		graph->flags = flags;
+
+		graph->node_capacity = capacity;
+	}
+
+	long node = graph->num_nodes++;
+	graph->keys[node] = key;
+	graph->flags[node] = 0;
+	graph->slots[slot] = node + 1;
+
+	// Keep the table at most half full so that probe sequences stay short
+	if (graph->num_nodes * 2 > graph->num_slots && !resize_slots(graph, graph->num_slots * 2)) return -1;
+
+	return node;
+}
+
+// Add an edge to a state graph
+static bool add_edge(struct state_graph *graph, long to, int move) {
+	if (graph->num_edges == graph->edge_capacity) {
+		long capacity = graph->edge_capacity * 2;
+
+		int *edge_to = realloc(graph->edge_to, sizeof(int) * capacity);
+		if (edge_to == NULL) return false;
+		graph->edge_to = edge_to;
+
+		unsigned char *edge_move = realloc(graph->edge_move, capacity);
+		if (edge_move == NULL) return false;
+		graph->edge_move = edge_move;
+
+		graph->edge_capacity = capacity;
+	}
+
+	graph->edge_to[graph->num_edges] = to;
+	graph->edge_move[graph->num_edges++] = move;
+
+	return true;
+}
+
+// Free the memory held by a state graph
+static void free_graph(struct state_graph *graph) {
+	free(graph->keys);
+	free(graph->edge_start);
+	free(graph->flags);
+	free(graph->slots);
+	free(graph->edge_to);
+	free(graph->edge_move);
+}
+
+// Label the states from which Theseus can escape, and fill in the metrics that depend on them
+static bool label_graph(const struct state_graph *graph, struct level_metrics *metrics, int escape_moves) {
+	long num_nodes = graph->num_nodes;
+	long *pred_start = calloc(num_nodes + 1, sizeof(long));
+	int *preds = malloc(sizeof(int) * (graph->num_edges + 1));
+	int *distance = malloc(sizeof(int) * num_nodes);
+	int *queue = malloc(sizeof(int) * num_nodes);
+	bool ok = (pred_start != NULL && preds != NULL && distance != NULL && queue != NULL);
+
+	if (ok) {
+		// Turn the edges around (grouped by the node they lead to)
+		for(long e = 0; e < graph->num_edges; e++)
+			pred_start[graph->edge_to[e] + 1]++;
+		for(long n = 0; n < num_nodes; n++)
+			pred_start[n + 1] += pred_start[n];
+		for(long n = 0; n < num_nodes; n++)
+			for(long e = graph->edge_start[n]; e < graph->edge_start[n + 1]; e++)
+				preds[pred_start[graph->edge_to[e]]++] = n;
+		for(long n = num_nodes; n > 0; n--)
+			pred_start[n] = pred_start[n - 1];
+		pred_start[0] = 0;
+
+		// Breadth-first search backwards from the states Theseus escapes from
+		long head = 0, tail = 0;
+		for(long n = 0; n < num_nodes; n++) {
+			distance[n] = (graph->flags[n] & NODE_ESCAPES) ? 0 : -1;
+			if (distance[n] == 0) queue[tail++] = n;
+		}
+		while (head < tail) {
+			int node = queue[head++];
+
+			for(long p = pred_start[node]; p < pred_start[node + 1]; p++) {
+				if (distance[preds[p]] >= 0) continue;
+
+				distance[preds[p]] = distance[node] + 1;
+				queue[tail++] = preds[p];
+			}
+		}
+
+		metrics->dead_states = num_nodes - tail;
+		metrics->solvable = (distance[0] >= 0);
+		metrics->turns = metrics->solvable ? distance[0] + 1 : 0;
+
+		// First moves that escape right away, or lead to a state Theseus can escape from
+		int winning = escape_moves;
+		for(long e = graph->edge_start[0]; e < graph->edge_start[1]; e++)
+			if (distance[graph->edge_to[e]] >= 0) winning |= 1 << graph->edge_move[e];
+
+		metrics->winning_moves = 0;
+		for(int move = 0; move < TURN_CODE_BASE; move++)
+			metrics->winning_moves += (winning >> move) & 1;
+	}
+
+	free(pred_start);
+	free(preds);
+	free(distance);
+	free(queue);
+
+	return ok;
+}
+
+// Analyze a level for a given rule variant (see analyze_level())
+KERNEL_INLINE bool analysis_kernel(const struct engine_level *level, struct level_metrics *metrics, int minotaur_steps, bool vertical_first, int theseus_steps) {
+	struct state_graph graph;
+	int count = level->num_minotaurs;
+	int bits = 1;
+
+	memset(&graph, 0, sizeof(graph));
+	memset(metrics, 0, sizeof(*metrics));
+
+	// Each state is packed into one word: Theseus' cell, then each Minotaur's cell, 'bits' bits apiece
+	while ((1 << bits) < level->num_cells)
+		bits++;
+	uint64_t cell_mask = ((uint64_t)1 << bits) - 1;
+
+	graph.node_capacity = graph.edge_capacity = INITIAL_NODES;
+	graph.keys = malloc(sizeof(uint64_t) * graph.node_capacity);
+	graph.edge_start = malloc(sizeof(long) * (graph.node_capacity + 1));
+	graph.flags = malloc(graph.node_capacity);
+	graph.edge_to = malloc(sizeof(int) * graph.edge_capacity);
+	graph.edge_move = malloc(graph.edge_capacity);
+	bool ok = (graph.keys != NULL && graph.edge_start != NULL && graph.flags != NULL && graph.edge_to != NULL
+		   && graph.edge_move != NULL && resize_slots(&graph, INITIAL_NODES * 2));
+
+	int num_codes = (theseus_steps > 1) ? TURN_CODE_BASE * TURN_CODE_BASE : TURN_CODE_BASE;
+	int escape_moves = 0, valid_moves = 0;
+	long num_successors = 0;
+
+	if (ok) {
+		uint64_t start = level->theseus_start;
+		for(int k = 0; k < count; k++)
+			start |= (uint64_t)level->minotaur_starts[k] << (bits * (k + 1));
+		find_node(&graph, start);
+
+		for(int t = 0; t < TURN_CODE_BASE; t++)
+			if (theseus_step(level, level->theseus_start, t) != THESEUS_BLOCKED) valid_moves |= 1 << t;
+	}
+
+	// Enumerate every reachable state once, in the order found, with the states each one leads to
+	for(long node = 0; node < graph.num_nodes && ok; node++) {
+		uint64_t key = graph.keys[node];
+		int theseus = key & cell_mask;
+		int minotaurs[MAX_MINOTAURS];
+		int stuck = (1 << count) - 1;	/* Minotaurs that haven't moved after any of Theseus' turns so far */
+		bool can_move = false;
+
+		graph.edge_start[node] = graph.num_edges;
+		for(int k = 0; k < count; k++)
+			minotaurs[k] = (key >> (bits * (k + 1))) & cell_mask;
+
+		for(int code = 0; code < num_codes && ok; code++) {
+			int cell = theseus, rest = code;
+			bool alive = true;
+
+			for(int i = 0; i < theseus_steps && alive; i++, rest /= TURN_CODE_BASE) {
+				int next = theseus_step(level, cell, rest % TURN_CODE_BASE);
+
+				if (next == THESEUS_BLOCKED || on_minotaur(minotaurs, count, next)) alive = false;
+				else if (next == THESEUS_ESCAPED) {
+					graph.flags[node] |= NODE_ESCAPES;
+					if (node == 0) escape_moves |= 1 << (code % TURN_CODE_BASE);
+					alive = false;
+				}
+				else cell = next;
+			}
+			if (!alive) continue;
+
+			int next_minotaurs[MAX_MINOTAURS];
+			memcpy(next_minotaurs, minotaurs, sizeof(int) * count);
+			bool caught = minotaurs_turn(level, cell, next_minotaurs, count, minotaur_steps, vertical_first);
+
+			can_move = true;
+			for(int k = 0; k < count; k++)
+				if (next_minotaurs[k] != minotaurs[k]) stuck &= ~(1 << k);
+			if (caught) continue;
+
+			uint64_t next_key = cell;
+			for(int k = 0; k < count; k++)
+				next_key |= (uint64_t)next_minotaurs[k] << (bits * (k + 1));
+
+			long to = find_node(&graph, next_key);
+			if (to < 0 || !add_edge(&graph, to, code % TURN_CODE_BASE)) {
+				ok = false;
+				break;
+			}
+
+			// Count each different state reached once
+			long e = graph.edge_start[node];
+			while (graph.edge_to[e] != to)
+				e++;
+			if (e == graph.num_edges - 1) num_successors++;
+		}
+
+		if (can_move && stuck != 0) graph.flags[node] |= NODE_TRAP;
+	}
+
+	if (ok) {
+		graph.edge_start[graph.num_nodes] = graph.num_edges;
+		metrics->states = graph.num_nodes;
+		metrics->branching = (double)num_successors / graph.num_nodes;
+		for(long n = 0; n < graph.num_nodes; n++)
+			metrics->traps += (graph.flags[n] & NODE_TRAP) != 0;
+		for(int t = 0; t < TURN_CODE_BASE; t++)
+			metrics->first_moves += (valid_moves >> t) & 1;
+
+		ok = label_graph(&graph, metrics, escape_moves);
+	}
+
+	if (ok && metrics->solvable) {
+		double dead_fraction = (double)metrics->dead_states / metrics->states;
+		metrics->difficulty = metrics->turns * (1 + dead_fraction) * metrics->first_moves / metrics->winning_moves;
+	}
+	else metrics->difficulty = -1;
+
+	free_graph(&graph);
+
+	return ok;
+}
+
+// One specialized copy of the analysis per rule variant
+#define DEFINE_ANALYSIS(NAME, MSTEPS, VFIRST, TSTEPS) \
+	static bool analyze_##NAME(const struct engine_level *level, struct level_metrics *metrics) { \
+		return analysis_kernel(level, metrics, MSTEPS, VFIRST, TSTEPS); \
+	}
+RULE_VARIANTS(DEFINE_ANALYSIS)
+
+typedef bool (*variant_analysis)(const struct engine_level *level, struct level_metrics *metrics);
+
+#define ANALYSIS_ENTRY(NAME, MSTEPS, VFIRST, TSTEPS) analyze_##NAME,
+static const variant_analysis analyses[NUM_RULE_VARIANTS] = {RULE_VARIANTS(ANALYSIS_ENTRY)};
+
+bool analyze_level(const struct engine_level *level, struct level_metrics *metrics) {
+	return analyses[level->variant](level, metrics);
+}
+
+void catalog_path(const char *list_path, char *catalog_path, size_t size) {
+	const char *slash = strrchr(list_path, '/');
+	const char *dot = strrchr((slash != NULL) ? slash : list_path, '.');
+	int length = (dot != NULL) ? (int)(dot - list_path) : (int)strlen(list_path);
+
+	snprintf(catalog_path, size, "%.*s.catalog", length, list_path);
+}
+
+int read_catalog(const char *list_path, struct catalog_entry **entries) {
+	char path[CATALOG_LINE], line[CATALOG_LINE];
+	int count = 0, capacity = 0;
+
+	catalog_path(list_path, path, sizeof(path));
+	FILE *file = fopen(path, "r");
+	if (file == NULL) return -1;
+
+	*entries = NULL;
+	while (fgets(line, sizeof(line), file) != NULL) {
+		struct catalog_entry entry;
+		struct level_metrics *m = &entry.metrics;
+		int solvable;
+
+		if (line[0] == '#') continue;
+		line[strcspn(line, "\r\n")] = '\0';
+		if (sscanf(line, "%d %d %d %d %ld %ld %lf %ld %lf %255[^\n]", &solvable, &m->turns, &m->first_moves, &m->winning_moves,
+			   &m->states, &m->dead_states, &m->branching, &m->traps, &m->difficulty, entry.path) != 10)
+			continue;
+		m->solvable = solvable;
+
+		if (count == capacity) {
+			capacity = (capacity > 0) ? capacity * 2 : 64;
+			struct catalog_entry *larger = realloc(*entries, sizeof(struct catalog_entry) * capacity);
+			if (larger == NULL) {
+				free(*entries);
+				fclose(file);
+				return -1;
+			}
+			*entries = larger;
+		}
+		(*entries)[count++] = entry;
+	}
+	fclose(file);
+
+	return count;
+}
+
+// Catalog thread: analyze the levels of a pack, taking the next one until there are none left
+static void *catalog_worker(void *arg) {
+	struct catalog_work *work = arg;
+	int index;
+
+	while ((index = __atomic_fetch_add(&work->next, 1, __ATOMIC_RELAXED)) < work->num_levels) {
+		struct stats board;
+		struct engine_level level;
+
+		board.walls = NULL;
+		work->status[index] = read_level_file(work->paths[index], &board);
+		if (work->status[index] != 0) continue;
+
+		bool loaded = engine_load(&level, &board);
+		free_walls(board.walls);
+		if (!loaded) {
+			work->status[index] = 2;
+			continue;
+		}
+
+		if (!analyze_level(&level, &work->metrics[index])) work->status[index] = 2;
+		engine_free(&level);
+	}
+
+	return NULL;
+}
+
+// Write the metrics of a pack's levels to its catalog (through a temporary file, replaced at once)
+static bool write_catalog(const char *list_path, const struct catalog_work *work) {
+	char path[CATALOG_LINE], temp_path[CATALOG_LINE + 8];
+
+	catalog_path(list_path, path, sizeof(path));
+	snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+	FILE *file = fopen(temp_path, "w");
+	if (file == NULL) return false;
+
+	fprintf(file, "# solvable turns first_moves winning_moves states dead_states branching traps difficulty path\n");
+	for(int i = 0; i < work->num_levels; i++) {
+		const struct level_metrics *m = &work->metrics[i];
+
+		if (work->status[i] != 0) continue;
+		fprintf(file, "%d %d %d %d %ld %ld %.3f %ld %.2f %s\n", m->solvable, m->turns, m->first_moves, m->winning_moves,
+			m->states, m->dead_states, m->branching, m->traps, m->difficulty, work->paths[i]);
+	}
+
+	bool ok = (fclose(file) == 0);
+	if (ok) ok = (rename(temp_path, path) == 0);
+	else remove(temp_path);
+
+	return ok;
+}
+
+int run_catalog(const char *list_path, int num_threads) {
+	struct catalog_work work = {NULL, NULL, NULL, 0, 0};
+	struct level_list list;
+	char line[CATALOG_LINE];
+	int result = 0;
+
+	int error = read_level_list(list_path, &list);
+	if (error != 0) {
+		fprintf(stderr, "theseus: %s: %s\n", list_path, (error == 2) ? "out of memory" : "could not read level list");
+		return 1;
+	}
+
+	// Take every level file path of the list (pointing into it) that fits in a catalog line
+	work.paths = malloc(sizeof(char *) * (list.num_levels + 1));
+	if (work.paths == NULL) {
+		fprintf(stderr, "theseus: out of memory\n");
+		free_level_list(&list);
+		return 1;
+	}
+	for(int i = 0; i < list.num_levels; i++) {
+		if (strlen(list.paths[i]) >= CATALOG_PATH_LENGTH) {
+			fprintf(stderr, "theseus: %s: level file path too long\n", list.paths[i]);
+			result = 1;
+			continue;
+		}
+		work.paths[work.num_levels++] = list.paths[i];
+	}
+
+	work.metrics = calloc(work.num_levels + 1, sizeof(struct level_metrics));
+	work.status = calloc(work.num_levels + 1, sizeof(int));
+	if (work.metrics == NULL || work.status == NULL) {
+		fprintf(stderr, "theseus: out of memory\n");
+		result = 1;
+	}
+
+	// Analyze the levels on a pool of threads (the main thread is one of them)
+	else {
+		if (num_threads > work.num_levels) num_threads = work.num_levels;
+		if (num_threads < 1) num_threads = 1;
+
+		pthread_t threads[num_threads];
+		int started = 1;
+
+		for(; started < num_threads; started++)
+			if (pthread_create(&threads[started], NULL, catalog_worker, &work) != 0) break;
+		catalog_worker(&work);
+		for(int t = 1; t < started; t++)
+			pthread_join(threads[t], NULL);
+
+		printf("%-30s %9s %6s %9s %6s %7s %7s %10s\n", "level", "turns", "first", "states", "dead", "branch", "traps", "difficulty");
+		for(int i = 0; i < work.num_levels; i++) {
+			const struct level_metrics *m = &work.metrics[i];
+
+			if (work.status[i] != 0) {
+				fprintf(stderr, "theseus: %s: %s\n", work.paths[i], (work.status[i] == 1) ? "could not open level file"
+					: (work.status[i] == 2) ? "too many states to analyze (or out of memory)" : "invalid level file");
+				result = 1;
+				continue;
+			}
+
+			char turns[16], difficulty[16];
+			if (m->solvable) {
+				snprintf(turns, sizeof(turns), "%d", m->turns);
+				snprintf(difficulty, sizeof(difficulty), "%.1f", m->difficulty);
+			}
+			else {
+				snprintf(turns, sizeof(turns), "-");
+				snprintf(difficulty, sizeof(difficulty), "unsolvable");
+			}
+			printf("%-30s %9s %3d/%-2d %9ld %5.1f%% %7.2f %7ld %10s\n", work.paths[i], turns, m->winning_moves, m->first_moves,
+			       m->states, 100.0 * m->dead_states / m->states, m->branching, m->traps, difficulty);
+		}
+
+		if (!write_catalog(list_path, &work)) {
+			catalog_path(list_path, line, sizeof(line));
+			fprintf(stderr, "theseus: %s: could not write the catalog\n", line);
+			result = 1;
+		}
+	}
+
+	free(work.paths);
+	free(work.metrics);
+	free(work.status);
+	free_level_list(&list);
+
+	return result;
+}
@@ -0,0 +1,102 @@
+#ifndef _ANALYSIS_H
+#define _ANALYSIS_H
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "loader.h"
+
+#define CATALOG_THREADS 4		/* Default number of threads analyzing a pack */
+#define ANALYSIS_MAX_STATES 2000000	/* Levels with more reachable states are not analyzed */
+#define CATALOG_PATH_LENGTH 256		/* Longest level file path kept in a catalog */
+
+#define EASY_DIFFICULTY 30		/* Levels below this difficulty are easy */
+#define HARD_DIFFICULTY 100		/* Levels from this difficulty up are hard */
+
+// Structure to hold the metrics computed for a level
+struct level_metrics {
+	bool solvable;
+	int turns;			/* Optimal number of turns (0 if unsolvable) */
+	int first_moves;		/* Moves Theseus can make on the first turn (skip included) */
+	int winning_moves;		/* First moves after which Theseus can still escape */
+	long states;			/* States that can be reached (Theseus to move) */
+	long dead_states;		/* Reachable states from which Theseus can no longer escape */
+	double branching;		/* Different states reached in one turn, on average */
+	long traps;			/* Reachable states in which a Minotaur can't move whatever Theseus does */
+	double difficulty;		/* Score combining the above (see analyze_level()), -1 if unsolvable */
+};
+
+// Structure to hold one level of a catalog
+struct catalog_entry {
+	char path[CATALOG_PATH_LENGTH];
+	struct level_metrics metrics;
+};
+
+/**
+ * Compute the metrics of a level. Every state Theseus can reach (at the start of a turn)
+ * is enumerated once, with the states it leads to in one turn, and the states from which
+ * Theseus can escape are then labelled backwards from the ones he escapes from. Every
+ * other reachable state is dead: he may still be alive there, but he is bound to be caught.
+ *
+ * The difficulty of a solvable level is its optimal number of turns, scaled up by the
+ * fraction of dead states and by how few of the first moves still win:
+ *
+ *	difficulty = turns * (1 + dead_states / states) * first_moves / winning_moves
+ *
+ * 'level' specifies the level to analyze.
+ * 'metrics' receives the metrics.
+ *
+ * Return Values:
+ *	true - The level was analyzed.
+ *	false - The level has more than ANALYSIS_MAX_STATES reachable states, or memory
+ *		for the analysis could not be allocated.
+ */
+bool analyze_level(const struct engine_level *level, struct level_metrics *metrics);
+
+/**
+ * Find the file path of the catalog kept with a level list: the list's path with its
+ * extension replaced by ".catalog" (i.e Levels/levellist.catalog).
+ *
+ * 'list_path' specifies the file path of the level list.
+ * 'catalog_path' receives the file path of the catalog.
+ * 'size' specifies the size of the 'catalog_path' buffer.
+ */
+void catalog_path(const char *list_path, char *catalog_path, size_t size);
+
+/**
+ * Read the catalog kept with a level list.
+ *
+ * 'list_path' specifies the file path of the level list.
+ * 'entries' receives an array of catalog entries (free it with free()), in list order.
+ *
+ * Return Value:
+ *	The function returns the number of entries read, or -1 if there is no catalog
+ *	or it could not be read.
+ */
+int read_catalog(const char *list_path, struct catalog_entry **entries);
+
+/**
+ * Compute the metrics of every level of a pack (a level list like Levels/levellist.txt:
+ * one level file path per line) on a pool of threads, and store them in the catalog kept
+ * with the list (see catalog_path()). The metrics are also printed as a table. A level
+ * that can't be read is left out of the catalog and reported.
+ *
+ * 'list_path' specifies the file path of the level list.
+ * 'num_threads' specifies the number of threads analyzing levels.
+ *
+ * Return Values:
+ *	0 - The catalog was written.
+ *	1 - The list could not be read, a level could not be analyzed, or the catalog
+ *	    could not be written.
+ */
+int run_catalog(const char *list_path, int num_threads);
+
+#endif	    // _ANALYSIS_H
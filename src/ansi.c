@@ -0,0 +1,306 @@
+#include "broadcast.h"
+
+// The screen buffer being drawn to, and a copy of what the terminal currently shows
+static struct ansi_cell *screen = NULL;
+static struct ansi_cell *shown = NULL;
+static int screen_lines = 0, screen_cols = 0;
+static int out_fd = -1;
+
+// Range of rows changed since the last frame (only these rows are compared when flushing)
+static int dirty_top = 0, dirty_bottom = -1;
+
+// Mark rows of the screen buffer as changed
+static void mark_dirty(int top, int bottom) {
+	if (top < dirty_top || dirty_bottom < dirty_top) dirty_top = top;
+	if (bottom > dirty_bottom) dirty_bottom = bottom;
+
+	return;
+}
+
+// Output buffer for one frame of escape sequences (grows as needed, never shrinks)
+static struct ansi_buffer frame = {NULL, 0, 0, false};
+
+// Append bytes to a buffer of escape sequences (once bytes are left out for want of memory, the buffer is marked failed and nothing more is added)
+static void buffer_append(struct ansi_buffer *out, const char *bytes, size_t length) {
+	if (out->failed) return;
+	if (out->length + length > out->capacity) {
+		size_t new_cap = (out->capacity) ? out->capacity * 2 : 4096;
+		while (new_cap < out->length + length) new_cap *= 2;
+
+		char *new_data = realloc(out->data, new_cap);
+		if (new_data == NULL) {
+			out->failed = true;
+			return;
+		}
+
+		out->data = new_data;
+		out->capacity = new_cap;
+	}
+	memcpy(out->data + out->length, bytes, length);
+	out->length += length;
+
+	return;
+}
+
+// Append a decimal number to a buffer (faster than snprintf for the hot path)
+static void buffer_number(struct ansi_buffer *out, int value) {
+	char digits[12];
+	int i = sizeof(digits);
+
+	do {
+		digits[--i] = '0' + (value % 10);
+		value /= 10;
+	} while (value > 0);
+
+	buffer_append(out, digits + i, sizeof(digits) - i);
+
+	return;
+}
+
+// Encode the cells of rows 'top' to 'bottom' that differ from 'shown' (or from a blank screen
+// if 'shown' is NULL), updating 'shown' to match. Returns the number of cells encoded.
+static int encode_cells(struct ansi_buffer *out, const struct ansi_cell *cells, struct ansi_cell *shown_cells, int cols, int top, int bottom) {
+	const struct ansi_cell blank = {' ', ANSI_DEFAULT, ANSI_DEFAULT};
+	int cur_y = -1, cur_x = -1;		/* Where the terminal's cursor is (unknown at first) */
+	int cur_fg = -1, cur_bg = -1;		/* Current colors of the terminal (unknown at first) */
+	int changed = 0;
+
+	for(int i = top; i <= bottom; i++) {
+		for(int j = 0; j < cols; j++) {
+			const struct ansi_cell *cell = &cells[(i * cols) + j];
+			const struct ansi_cell *old = (shown_cells != NULL) ? &shown_cells[(i * cols) + j] : &blank;
+
+			if (cell->ch == old->ch && cell->fg == old->fg && cell->bg == old->bg) continue;
+
+			// Move the cursor unless it's already there from the last changed cell
+			if (i != cur_y || j != cur_x) {
+				buffer_append(out, "\033[", 2);
+				buffer_number(out, i + 1);
+				buffer_append(out, ";", 1);
+				buffer_number(out, j + 1);
+				buffer_append(out, "H", 1);
+			}
+
+			if (cell->fg != cur_fg || cell->bg != cur_bg) {
+				buffer_append(out, "\033[3", 3);
+				buffer_number(out, cell->fg);
+				buffer_append(out, ";4", 2);
+				buffer_number(out, cell->bg);
+				buffer_append(out, "m", 1);
+
+				cur_fg = cell->fg;
+				cur_bg = cell->bg;
+			}
+
+			buffer_append(out, &cell->ch, 1);
+			if (shown_cells != NULL) shown_cells[(i * cols) + j] = *cell;
+			cur_y = i;
+			cur_x = j + 1;
+			changed++;
+		}
+	}
+
+	return changed;
+}
+
+/**
+ * Set up the raw ANSI rendering backend. The backend keeps its own buffer of character
+ * cells for the whole screen, and a copy of what was last sent to the terminal, so that
+ * each frame only sends the cells that changed. The terminal must understand the basic
+ * ANSI/VT100 escape sequences (cursor position, 8-color SGR, save/restore cursor).
+ *
+ * 'fd' specifies the file descriptor to write frames to.
+ * 'lines' specifies the height of the screen.
+ * 'cols' specifies the width of the screen.
+ *
+ * Return Values:
+ *	true - The backend is ready.
+ *	false - Memory for the screen buffers could not be allocated.
+ */
+bool ansi_init(int fd, int lines, int cols) {
+	ansi_end();
+
+	screen = malloc(sizeof(struct ansi_cell) * lines * cols);
+	shown = malloc(sizeof(struct ansi_cell) * lines * cols);
+	if (screen == NULL || shown == NULL) {
+		ansi_end();
+		return false;
+	}
+
+	out_fd = fd;
+	screen_lines = lines;
+	screen_cols = cols;
+
+	// The screen starts out blank, and the terminal's contents are unknown
+	ansi_clear();
+	ansi_invalidate();
+
+	return true;
+}
+
+/**
+ * Free the screen buffers of the ANSI backend.
+ */
+void ansi_end(void) {
+	free(screen);
+	free(shown);
+	free(frame.data);
+
+	screen = shown = NULL;
+	frame.data = NULL;
+	frame.length = frame.capacity = 0;
+	screen_lines = screen_cols = 0;
+	dirty_top = 0;
+	dirty_bottom = -1;
+
+	return;
+}
+
+/**
+ * Fill a rectangle of the screen buffer with blank cells of one background color.
+ * Parts of the rectangle that fall off the screen are ignored.
+ *
+ * 'y', 'x' specify the top left corner of the rectangle.
+ * 'height', 'width' specify the size of the rectangle.
+ * 'bg' specifies the background color.
+ */
+void ansi_fill(int y, int x, int height, int width, short bg) {
+	mark_dirty((y < 0) ? 0 : y, (y + height > screen_lines) ? screen_lines - 1 : y + height - 1);
+
+	for(int i = (y < 0) ? 0 : y; i < y + height && i < screen_lines; i++) {
+		for(int j = (x < 0) ? 0 : x; j < x + width && j < screen_cols; j++) {
+			struct ansi_cell *cell = &screen[(i * screen_cols) + j];
+
+			cell->ch = ' ';
+			cell->fg = bg;
+			cell->bg = bg;
+		}
+	}
+
+	return;
+}
+
+/**
+ * Write a string of characters into the screen buffer, starting at a given position.
+ * Characters that fall off the screen are ignored.
+ *
+ * 'y', 'x' specify the position of the first character.
+ * 'text' specifies the characters to write.
+ * 'length' specifies the number of characters to write.
+ * 'fg', 'bg' specify the foreground and background colors of the characters.
+ */
+void ansi_put(int y, int x, const char *text, int length, short fg, short bg) {
+	if (y < 0 || y >= screen_lines) return;
+	mark_dirty(y, y);
+
+	for(int j = 0; j < length; j++) {
+		if (x + j < 0 || x + j >= screen_cols) continue;
+
+		struct ansi_cell *cell = &screen[(y * screen_cols) + x + j];
+		cell->ch = text[j];
+		cell->fg = fg;
+		cell->bg = bg;
+	}
+
+	return;
+}
+
+/**
+ * Forget what was last sent to the terminal, so that the next frame repaints every
+ * cell (i.e after something else has drawn over the screen).
+ */
+void ansi_invalidate(void) {
+	for(int i = 0; i < screen_lines * screen_cols; i++)
+		shown[i].ch = '\0';			/* Never drawn, so it never matches */
+	mark_dirty(0, screen_lines - 1);
+
+	return;
+}
+
+/**
+ * Blank the screen buffer, and assume the terminal has been blanked as well (i.e right
+ * after ncurses has cleared the screen), so that nothing is sent for the blank cells.
+ */
+void ansi_clear(void) {
+	for(int i = 0; i < screen_lines * screen_cols; i++) {
+		screen[i].ch = ' ';
+		screen[i].fg = screen[i].bg = ANSI_DEFAULT;
+		shown[i] = screen[i];
+	}
+
+	// Spectators have to be told to clear their screens too
+	broadcast_clear();
+
+	return;
+}
+
+/**
+ * Compare the screen buffer with what was last sent to the terminal, and send only the
+ * changed cells as a minimal stream of escape sequences, with a single write() call.
+ * The cursor position and attributes of the terminal are saved and restored around the
+ * frame, so the backend can share the screen with ncurses. Nothing is written if no
+ * cell changed. The encoded frame is also handed to the spectator broadcast, if one is
+ * running (see broadcast.h). A frame that could not be encoded in full (for want of
+ * memory) is not sent, and one the terminal didn't take in full (a write error) is cut
+ * short: either way, the next frame repaints every cell (see ansi_invalidate()).
+ *
+ * Return Value:
+ *	The function returns the number of bytes sent for the frame.
+ */
+size_t ansi_flush(void) {
+	int top = dirty_top, bottom = dirty_bottom;
+
+	// Save the cursor and attributes around the changes of the frame
+	frame.length = 0;
+	frame.failed = false;
+	buffer_append(&frame, "\0337", 2);
+	int changed = encode_cells(&frame, screen, shown, screen_cols, top, bottom);
+	buffer_append(&frame, "\0338", 2);
+
+	dirty_top = 0;
+	dirty_bottom = -1;
+
+	if (changed == 0) return 0;
+
+	// A cut-off frame would leave half an escape sequence on the screen, so send none and repaint next time
+	if (frame.failed) {
+		ansi_invalidate();
+		return 0;
+	}
+
+	// Send the whole frame at once
+	size_t sent = 0;
+	while (sent < frame.length) {
+		ssize_t result = write(out_fd, frame.data + sent, frame.length - sent);
+		if (result < 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+		sent += result;
+	}
+
+	// The terminal didn't get all of the changes that 'shown' now holds
+	if (sent < frame.length) ansi_invalidate();
+
+	// Hand the same encoded frame to any spectators
+	broadcast_frame(frame.data, frame.length, screen, top, bottom);
+
+	return frame.length;
+}
+
+/**
+ * Encode a complete picture of a screen buffer (a keyframe): the screen is cleared and
+ * every cell that isn't blank is drawn. A keyframe brings a terminal in any state up to
+ * date, so it can be followed by the frames sent after it.
+ *
+ * 'cells' specifies the screen buffer to encode.
+ * 'lines', 'cols' specify the size of the screen buffer.
+ * 'out' specifies the buffer to append the escape sequences to.
+ */
+void ansi_encode_keyframe(const struct ansi_cell *cells, int lines, int cols, struct ansi_buffer *out) {
+	buffer_append(out, ANSI_CLEAR_SCREEN, strlen(ANSI_CLEAR_SCREEN));
+	encode_cells(out, cells, NULL, cols, 0, lines - 1);
+	buffer_append(out, "\033[0m", 4);
+
+	return;
+}
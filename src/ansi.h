@@ -0,0 +1,109 @@
+#ifndef _ANSI_H
+#define _ANSI_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ANSI_DEFAULT 9		/* Color number that selects the terminal's default color (SGR 39/49) */
+
+// Escape sequences that reset the attributes, hide the cursor and clear the screen
+#define ANSI_CLEAR_SCREEN "\033[0m\033[?25l\033[H\033[2J"
+
+// Structure to hold one character cell of the ANSI backend's screen buffer
+struct ansi_cell {
+	char ch;
+	unsigned char fg;	/* Foreground color (ncurses color number 0-7, or ANSI_DEFAULT) */
+	unsigned char bg;	/* Background color (ncurses color number 0-7, or ANSI_DEFAULT) */
+};
+
+// Structure to hold a growable buffer of escape sequences
+struct ansi_buffer {
+	char *data;
+	size_t length;
+	size_t capacity;
+	bool failed;		/* Bytes were left out for want of memory (the escape sequences are cut short) */
+};
+
+/**
+ * Set up the raw ANSI rendering backend. The backend keeps its own buffer of character
+ * cells for the whole screen, and a copy of what was last sent to the terminal, so that
+ * each frame only sends the cells that changed. The terminal must understand the basic
+ * ANSI/VT100 escape sequences (cursor position, 8-color SGR, save/restore cursor).
+ *
+ * 'fd' specifies the file descriptor to write frames to.
+ * 'lines' specifies the height of the screen.
+ * 'cols' specifies the width of the screen.
+ *
+ * Return Values:
+ *	true - The backend is ready.
+ *	false - Memory for the screen buffers could not be allocated.
+ */
+bool ansi_init(int fd, int lines, int cols);
+
+/**
+ * Free the screen buffers of the ANSI backend.
+ */
+void ansi_end(void);
+
+/**
+ * Fill a rectangle of the screen buffer with blank cells of one background color.
+ * Parts of the rectangle that fall off the screen are ignored.
+ *
+ * 'y', 'x' specify the top left corner of the rectangle.
+ * 'height', 'width' specify the size of the rectangle.
+ * 'bg' specifies the background color.
+ */
+void ansi_fill(int y, int x, int height, int width, short bg);
+
+/**
+ * Write a string of characters into the screen buffer, starting at a given position.
+ * Characters that fall off the screen are ignored.
+ *
+ * 'y', 'x' specify the position of the first character.
+ * 'text' specifies the characters to write.
+ * 'length' specifies the number of characters to write.
+ * 'fg', 'bg' specify the foreground and background colors of the characters.
+ */
+void ansi_put(int y, int x, const char *text, int length, short fg, short bg);
+
+/**
+ * Forget what was last sent to the terminal, so that the next frame repaints every
+ * cell (i.e after something else has drawn over the screen).
+ */
+void ansi_invalidate(void);
+
+/**
+ * Blank the screen buffer, and assume the terminal has been blanked as well (i.e right
+ * after ncurses has cleared the screen), so that nothing is sent for the blank cells.
+ */
+void ansi_clear(void);
+
+/**
+ * Compare the screen buffer with what was last sent to the terminal, and send only the
+ * changed cells as a minimal stream of escape sequences, with a single write() call.
+ * The cursor position and attributes of the terminal are saved and restored around the
+ * frame, so the backend can share the screen with ncurses. Nothing is written if no
+ * cell changed. The encoded frame is also handed to the spectator broadcast, if one is
+ * running (see broadcast.h).
+ *
+ * Return Value:
+ *	The function returns the number of bytes sent for the frame.
+ */
+size_t ansi_flush(void);
+
+/**
+ * Encode a complete picture of a screen buffer (a keyframe): the screen is cleared and
+ * every cell that isn't blank is drawn. A keyframe brings a terminal in any state up to
+ * date, so it can be followed by the frames sent after it.
+ *
+ * 'cells' specifies the screen buffer to encode.
+ * 'lines', 'cols' specify the size of the screen buffer.
+ * 'out' specifies the buffer to append the escape sequences to.
+ */
+void ansi_encode_keyframe(const struct ansi_cell *cells, int lines, int cols, struct ansi_buffer *out);
+
+#endif	    // _ANSI_H
@@ -1,5 +1,6 @@
 #include "board.h"
 #include "movement.h"
+#include "latency.h"
 
 // ASCII character image display for Theseus
 const char *theseus_image[THESEUS_SIZE] = {
@@ -27,6 +28,16 @@ const char *eraser[ERASER_SIZE] = {
 	"          "
 };
 
+// Sprites pre-rendered for each background color of the board (see bake_sprites())
+static struct sprite_tile sprite_tiles[NUM_SPRITES][NUM_BACKGROUNDS];
+
+// Which backend the board is rendered with (WINDOWs are still created in both cases for
+// their positions and colors, but with BACKEND_ANSI they are never drawn by ncurses)
+backends_t render_backend = BACKEND_CURSES;
+
+// Number of frames that have been flushed to the terminal with flush_frame()
+unsigned long frames_flushed = 0;
+
 /**
  * Create a grid of WINDOWs centered on the screen. The WINDOWs can be set to
  * have alternating background colors by using init_pair() function to initialize
@@ -48,12 +59,20 @@ void win_layout(board_square *win_grid, short rows, short cols, short win_height
 		for(int j = 0; j < cols; j++) {
 
 			// Initialize WINDOW with specified height/width at next position on the screen
-			win_grid[(i * cols) + j].win = newwin(win_height, win_width, (LINES - ((rows - (2 * i)) * win_height)) / 2, (COLS - ((cols - (2 * j)) * win_width)) / 2);
+			int start_y = (LINES - ((rows - (2 * i)) * win_height)) / 2;
+			int start_x = (COLS - ((cols - (2 * j)) * win_width)) / 2;
+
+			win_grid[(i * cols) + j].win = newwin(win_height, win_width, start_y, start_x);
 			wbkgd(win_grid[(i * cols) + j].win, COLOR_PAIR(cur_pair));
 
 			win_grid[(i * cols) + j].move_mask = (moves[LEFT] | moves[RIGHT] | moves[UP] | moves[DOWN]);	/* Set default of move_mask element (all moves valid) */
 
-			wnoutrefresh(win_grid[(i * cols) + j].win);		/* Update virtual screen only (causes only one burst of output -- when finished) */
+			if (render_backend == BACKEND_ANSI) {
+				short fg, bg;
+				pair_content(cur_pair, &fg, &bg);
+				ansi_fill(start_y, start_x, win_height, win_width, bg);
+			}
+			else wnoutrefresh(win_grid[(i * cols) + j].win);	/* Update virtual screen only (causes only one burst of output -- when finished) */
 			
 			if ((cols & 1) || j != (cols - 1))
 				cur_pair = (cur_pair == PAIR_1) ? PAIR_2 : PAIR_1;
@@ -63,6 +82,75 @@ void win_layout(board_square *win_grid, short rows, short cols, short win_height
 	return;
 }
 
+/**
+ * Move the WINDOWs of a board created by win_layout(), and its exit WINDOW, to the places
+ * win_layout() would give them on the screen as it is now (i.e after the terminal has been
+ * resized). The WINDOWs are moved with mvwin() and keep their contents, so nothing on the
+ * board has to be drawn again (no WINDOW is created, and no wall or sprite is drawn). The
+ * WINDOWs are not copied to the virtual screen. Nothing is done if the board is still
+ * centered, and the board is never moved partly off the screen: if it doesn't fit, it stays
+ * where it is.
+ *
+ * 'win_grid' specifies the array of board_square structures for the board.
+ * 'rows' specifies the number of rows of WINDOWs.
+ * 'cols' specifies the number of columns of WINDOWs in each row.
+ * 'win_height' specifies the height of each WINDOW.
+ * 'win_width' specifies the width of each WINDOW.
+ * 'exit' specifies the exit WINDOW of the board.
+ *
+ * Return Values:
+ *	0 - The board was already in place, or doesn't fit on the screen (nothing was moved).
+ *	1 - The board was moved.
+ *	2 - The resize cut the board's WINDOWs, or some of them could never be created (the
+ *	    board has to be drawn again from scratch).
+ */
+int win_relayout(board_square *win_grid, short rows, short cols, short win_height, short win_width, WINDOW *exit) {
+	int num_squares = rows * cols;
+	int beg_y, beg_x, exit_y, exit_x, max_y, max_x;
+
+	if (win_grid[0].win == NULL || exit == NULL) return 2;
+	getbegyx(win_grid[0].win, beg_y, beg_x);
+	getbegyx(exit, exit_y, exit_x);
+
+	// A resize that cut or shifted a WINDOW (or a board that never fit the screen) can't be moved back into shape
+	for(int i = 0; i < num_squares; i++) {
+		int y, x;
+		if (win_grid[i].win == NULL) return 2;
+
+		getbegyx(win_grid[i].win, y, x);
+		getmaxyx(win_grid[i].win, max_y, max_x);
+		if (max_y != win_height || max_x != win_width || y != beg_y + ((i / cols) * win_height) || x != beg_x + ((i % cols) * win_width))
+			return 2;
+	}
+	getmaxyx(exit, max_y, max_x);
+	if (max_y != win_height || max_x != win_width || (exit_y - beg_y) % win_height != 0 || (exit_x - beg_x) % win_width != 0)
+		return 2;
+
+	// Find how far the board has to move (the same start as win_layout() gives the first WINDOW)
+	int move_y = ((LINES - (rows * win_height)) / 2) - beg_y;
+	int move_x = ((COLS - (cols * win_width)) / 2) - beg_x;
+
+	if (move_y == 0 && move_x == 0) return 0;
+
+	// The whole board, with the exit just off its edge, has to fit on the screen
+	int top = beg_y + move_y, left = beg_x + move_x;
+	int bottom = top + (rows * win_height), right = left + (cols * win_width);
+	if (exit_y + move_y < top) top = exit_y + move_y;
+	if (exit_x + move_x < left) left = exit_x + move_x;
+	if (exit_y + move_y + win_height > bottom) bottom = exit_y + move_y + win_height;
+	if (exit_x + move_x + win_width > right) right = exit_x + move_x + win_width;
+	if (top < 0 || left < 0 || bottom > LINES || right > COLS) return 0;
+
+	// Move every WINDOW with its contents
+	for(int i = 0; i < num_squares; i++) {
+		getbegyx(win_grid[i].win, beg_y, beg_x);
+		mvwin(win_grid[i].win, beg_y + move_y, beg_x + move_x);
+	}
+	mvwin(exit, exit_y + move_y, exit_x + move_x);
+
+	return 1;
+}
+
 /**
  * Create a "wall" by reversing the foreground and background colors of
  * a specified position of a WINDOW. The "wall" is basically just a color
@@ -82,6 +170,22 @@ void draw_wall(WINDOW *win, short placement) {
 	int max_y, max_x, y_val, x_val;
 	getmaxyx(win, max_y, max_x);	    /* Get the maximum coordinates of the current WINDOW */
 
+	// With the ANSI backend, a wall is a line of cells in the reversed colors of the WINDOW
+	if (render_backend == BACKEND_ANSI) {
+		int beg_y, beg_x;
+		short fg, bg;
+
+		getbegyx(win, beg_y, beg_x);
+		pair_content(PAIR_NUMBER(getbkgd(win)), &fg, &bg);
+
+		if (placement == LEFT || placement == RIGHT)
+			ansi_fill(beg_y, beg_x + ((placement == LEFT) ? 0 : max_x - 1), max_y, 1, fg);
+		else if (placement == UP || placement == DOWN)
+			ansi_fill(beg_y + ((placement == UP) ? 0 : max_y - 1), beg_x, 1, max_x, fg);
+
+		return;
+	}
+
 	// Perform necessary loop based on specified placement
 	if (placement == LEFT || placement == RIGHT) {
 		x_val = (placement == LEFT) ? 0 : max_x - 1;
@@ -103,51 +207,97 @@ void draw_wall(WINDOW *win, short placement) {
 }
 
 /**
- * Take in an array of strings, print those strings to a WINDOW, and center them 
- * vertically and horizontally. Note that only as many characters will be printed to the
- * WINDOW as can fit inside a one-character width padding on each side of the WINDOW.
- * All other characters in the inputted array of strings will be disregarded. A color pair
- * for the inputted array of strings to be formatted in can be specified by assigning the
- * 'pair' argument a value of an already initialized color pair. Only the foreground color
- * of the 'pair' argument is used. The background color comes from the 'win_pair' color
- * pair argument.
+ * Pre-render every sprite (Theseus, the Minotaur, the exit and the eraser) for both
+ * background colors of the board, as lines of chtype cells ready to be copied into a
+ * WINDOW. Each sprite gets a dedicated color pair per background color (its own foreground
+ * color on the background of PAIR_1 or PAIR_2), so drawing a sprite never has to change
+ * the color table. The eraser is drawn in the WINDOW's own color pair. Must be called
+ * after PAIR_1, PAIR_2 and the sprites' color pairs have been initialized, and before any
+ * sprite is drawn with win_draw_sprite().
+ */
+void bake_sprites(void) {
+	static const short sprite_pairs[NUM_SPRITES] = {THESEUS_PAIR, MINOTAUR_PAIR, EXIT_PAIR, 0};
+	static const short sprite_heights[NUM_SPRITES] = {THESEUS_SIZE, MINOTAUR_SIZE, EXIT_SIZE, ERASER_SIZE};
+	const char **sprite_images[NUM_SPRITES] = {theseus_image, minotaur_image, exit_image, eraser};
+
+	for(int s = 0; s < NUM_SPRITES; s++) {
+		for(int b = 0; b < NUM_BACKGROUNDS; b++) {
+			struct sprite_tile *tile = &sprite_tiles[s][b];
+			short win_pair = PAIR_1 + b, pair = win_pair;
+			short win_fg, win_bg, fg, bg;
+
+			// Give the sprite its own color pair on this background (the eraser uses the WINDOW's pair)
+			pair_content(win_pair, &win_fg, &win_bg);
+			fg = win_fg;
+			if (sprite_pairs[s] != 0) {
+				pair_content(sprite_pairs[s], &fg, &bg);
+				pair = SPRITE_PAIR_BASE + (s * NUM_BACKGROUNDS) + b;
+				init_pair(pair, fg, win_bg);
+			}
+
+			tile->image = sprite_images[s];
+			tile->height = sprite_heights[s];
+			tile->fg = fg;
+			tile->bg = win_bg;
+			for(int i = 0; i < tile->height; i++) {
+				int length = strlen(tile->image[i]);
+				if (length > MAX_SPRITE_WIDTH) length = MAX_SPRITE_WIDTH;
+
+				for(int k = 0; k < length; k++)
+					tile->cells[i][k] = (unsigned char)tile->image[i][k] | COLOR_PAIR(pair);
+				tile->lengths[i] = length;
+			}
+		}
+	}
+
+	return;
+}
+
+/**
+ * Draw a sprite pre-rendered by bake_sprites() on a WINDOW, centered vertically and
+ * horizontally. Only as many characters are drawn as can fit inside a one-character width
+ * padding on each side of the WINDOW. Every line of the sprite is copied with a single
+ * call, without any allocation or change to the color table.
  *
- * 'win' specifies the WINDOW to print the image on.
- * 'image' specifies an array of strings to print to the WINDOW.
- * 'img_height' is the number of lines in the array of strings.
- * 'pair' specifies which color pair to format the image in.
- * 'win_pair' is the color pair for the WINDOW (used to find the background color).
+ * 'win' specifies the WINDOW to draw the sprite on.
+ * 'sprite' specifies which sprite to draw.
+ * 'win_pair' is the color pair for the WINDOW (PAIR_1 or PAIR_2), which picks the tile
+ *	baked for its background color.
  */
-void win_draw_image(WINDOW *win, const char **image, short img_height, short pair, short win_pair) {
-	int max_y, max_x, start_y, end_y, start_x;
+void win_draw_sprite(WINDOW *win, sprite_t sprite, short win_pair) {
+	const struct sprite_tile *tile = &sprite_tiles[sprite][(win_pair == PAIR_2) ? 1 : 0];
+	int max_y, max_x, start_y, end_y, start_x, length;
+
+	getmaxyx(win, max_y, max_x);
+
+	// Get interval of current WINDOW's rows to print the sprite lines on (center sprite vertically)
+	start_y = (tile->height < (max_y - 1)) ? (max_y - tile->height) / 2 : 1;
+	end_y = ((start_y + tile->height) < max_y) ? start_y + tile->height : max_y - 1;
+
+	// With the ANSI backend, copy the sprite's text straight into the cell buffer
+	if (render_backend == BACKEND_ANSI) {
+		int beg_y, beg_x;
+		getbegyx(win, beg_y, beg_x);
 
-	// Adjust background color for Theseus and Minotaur pairs
-	if (pair == THESEUS_PAIR || pair == MINOTAUR_PAIR || pair == EXIT_PAIR) {
-		short win_fg, win_bg, pair_fg, pair_bg;
+		for(int i = 0, cur_y = start_y; cur_y < end_y; i++, cur_y++) {
+			length = tile->lengths[i];
+			start_x = (length < (max_x - 1)) ? (max_x - length) / 2 : 1;
+			if (length > max_x - 3) length = max_x - 3;	/* Same one-character padding as below */
 
-		pair_content(win_pair, &win_fg, &win_bg);	/* Extract the foreground and background colors from the WINDOW's color pair */
-		pair_content(pair, &pair_fg, &pair_bg);
+			ansi_put(beg_y + cur_y, beg_x + start_x, tile->image[i], length, tile->fg, tile->bg);
+		}
 
-		init_pair(pair, pair_fg, win_bg);
+		return;
 	}
 
-	getmaxyx(win, max_y, max_x);
-	char *img_line = malloc(sizeof(char) * (max_x - 1));
-
-	// Get interval of current WINDOW's rows to print the image lines on (center image vertically)
-	start_y = (img_height < (max_y - 1)) ? (max_y - img_height) / 2 : 1;
-	end_y = ((start_y + img_height) < max_y) ? start_y + img_height : max_y - 1;
-	
-	// Print as many lines of the image as possible given the dimensions of the current WINDOW
-	wattron(win, COLOR_PAIR(pair));
+	// Copy as many lines of the sprite as fit given the dimensions of the current WINDOW
 	for(int i = 0, cur_y = start_y; cur_y < end_y; i++, cur_y++) {
-		start_x = (strlen(image[i]) < (max_x - 1)) ? (max_x - strlen(image[i])) / 2 : 1;
+		length = tile->lengths[i];
+		start_x = (length < (max_x - 1)) ? (max_x - length) / 2 : 1;
+		if (length > max_x - 3) length = max_x - 3;
 
-		snprintf(img_line, max_x - 2, "%s", image[i]);	    /* Copy a maximum number of characters into a buffer to be printed to the current WINDOW */
-		mvwprintw(win, cur_y, start_x, "%s", img_line);
+		mvwaddchnstr(win, cur_y, start_x, tile->cells[i], length);
 	}
-	wattroff(win, COLOR_PAIR(pair));
-	free(img_line);
 
 	wnoutrefresh(win);	/* Copy the WINDOW image to the virtual screen only */
 
@@ -214,7 +364,33 @@ WINDOW *place_win(WINDOW *neighbor, short placement, short win_height, short win
 	// Create the new WINDOW and print it to the screen
 	WINDOW *win = newwin(win_height, win_width, new_start_y, new_start_x);
 	wbkgd(win, COLOR_PAIR(win_pair));
-	wnoutrefresh(win);		    /* Copy the WINDOW only to the virtual screen */
+
+	if (render_backend == BACKEND_ANSI) {
+		short fg, bg;
+		pair_content(win_pair, &fg, &bg);
+		ansi_fill(new_start_y, new_start_x, win_height, win_width, bg);
+	}
+	else wnoutrefresh(win);		    /* Copy the WINDOW only to the virtual screen */
 
 	return win;
 }
+
+/**
+ * Copy everything that has been drawn to the virtual screen out to the terminal,
+ * completing one frame of output. All drawing functions for the board only update
+ * the virtual screen, so this is the one place where a frame actually reaches the
+ * terminal. The 'frames_flushed' counter is incremented for every call, and the
+ * output of the frame is measured when latency instrumentation is turned on. With the
+ * ANSI backend, ncurses first sends whatever other WINDOWs (i.e messages and the latency
+ * HUD) have been copied to the virtual screen, and the changed cells of the board are
+ * then sent with one write().
+ */
+void flush_frame(void) {
+	lat_frame(false);
+	doupdate();
+	if (render_backend == BACKEND_ANSI) ansi_flush();
+	lat_frame(true);
+	frames_flushed++;
+
+	return;
+}
@@ -7,6 +7,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "ansi.h"
+
 #define HEIGHT 5
 #define WIDTH 12
 
@@ -15,11 +17,41 @@
 #define THESEUS_PAIR 3
 #define MINOTAUR_PAIR 4
 #define EXIT_PAIR 5
+#define SPRITE_PAIR_BASE 6	/* First of the color pairs baked for each sprite and background color */
+#define NUM_BACKGROUNDS 2	/* Background colors of the board (those of PAIR_1 and PAIR_2) */
 
 #define THESEUS_SIZE 3
 #define MINOTAUR_SIZE 3
 #define EXIT_SIZE 1
 #define ERASER_SIZE 3
+#define MAX_SPRITE_HEIGHT 3
+#define MAX_SPRITE_WIDTH 10
+
+// Enumerated values representing the ways the board can be rendered
+typedef enum {
+	BACKEND_CURSES,		/* Draw through ncurses WINDOWs (default) */
+	BACKEND_ANSI		/* Draw into the raw ANSI backend's cell buffer (see ansi.h) */
+}
+backends_t;
+
+// Enumerated values representing the sprites drawn on the board
+typedef enum {
+	SPRITE_THESEUS,
+	SPRITE_MINOTAUR,
+	SPRITE_EXIT,
+	SPRITE_ERASER,		/* Blank lines that erase another sprite */
+	NUM_SPRITES
+}
+sprite_t;
+
+// Structure to hold a sprite pre-rendered for one background color
+struct sprite_tile {
+	const char **image;				/* The sprite's lines of text */
+	short height;
+	short lengths[MAX_SPRITE_HEIGHT];
+	chtype cells[MAX_SPRITE_HEIGHT][MAX_SPRITE_WIDTH];	/* The lines with the sprite's color pair */
+	short fg, bg;					/* Colors for the ANSI backend */
+};
 
 // Structure to hold a WINDOW in the board and a bit-mask of valid moves
 typedef struct {
@@ -40,6 +72,13 @@ extern const char *exit_image[];
 // An array of blank strings with which to erase WINDOW images
 extern const char *eraser[];
 
+// Which backend the board is rendered with (WINDOWs are still created in both cases for
+// their positions and colors, but with BACKEND_ANSI they are never drawn by ncurses)
+extern backends_t render_backend;
+
+// Number of frames that have been flushed to the terminal with flush_frame()
+extern unsigned long frames_flushed;
+
 /**
  * Create a grid of WINDOWs centered on the screen. The WINDOWs can be set to
  * have alternating background colors by using init_pair() function to initialize
@@ -55,6 +94,30 @@ extern const char *eraser[];
  */
 void win_layout(board_square *win_grid, short rows, short cols, short win_height, short win_width);
 
+/**
+ * Move the WINDOWs of a board created by win_layout(), and its exit WINDOW, to the places
+ * win_layout() would give them on the screen as it is now (i.e after the terminal has been
+ * resized). The WINDOWs are moved with mvwin() and keep their contents, so nothing on the
+ * board has to be drawn again (no WINDOW is created, and no wall or sprite is drawn). The
+ * WINDOWs are not copied to the virtual screen. Nothing is done if the board is still
+ * centered, and the board is never moved partly off the screen: if it doesn't fit, it stays
+ * where it is.
+ *
+ * 'win_grid' specifies the array of board_square structures for the board.
+ * 'rows' specifies the number of rows of WINDOWs.
+ * 'cols' specifies the number of columns of WINDOWs in each row.
+ * 'win_height' specifies the height of each WINDOW.
+ * 'win_width' specifies the width of each WINDOW.
+ * 'exit' specifies the exit WINDOW of the board.
+ *
+ * Return Values:
+ *	0 - The board was already in place, or doesn't fit on the screen (nothing was moved).
+ *	1 - The board was moved.
+ *	2 - The resize cut the board's WINDOWs, or some of them could never be created (the
+ *	    board has to be drawn again from scratch).
+ */
+int win_relayout(board_square *win_grid, short rows, short cols, short win_height, short win_width, WINDOW *exit);
+
 /**
  * Create a "wall" by reversing the foreground and background colors of
  * a specified position of a WINDOW. The "wall" is basically just a color
@@ -73,22 +136,28 @@ void win_layout(board_square *win_grid, short rows, short cols, short win_height
 void draw_wall(WINDOW *win, short placement);
 
 /**
-* Take in an array of strings, print those strings to a WINDOW, and center them 
-* vertically and horizontally. Note that only as many characters will be printed to the
-* WINDOW as can fit inside a one-character width padding on each side of the WINDOW.
-* All other characters in the inputted array of strings will be disregarded. A color pair
-* for the inputted array of strings to be formatted in can be specified by assigning the
-* 'pair' argument a value of an already initialized color pair. Only the foreground color
-* of the 'pair' argument is used. The background color comes from the 'win_pair' color
-* pair argument.
-*
-* 'win' specifies the WINDOW to print the image on.
-* 'image' specifies an array of strings to print to the WINDOW.
-* 'img_height' is the number of lines in the array of strings.
-* 'pair' specifies which color pair to format the image in.
-* 'win_pair' is the color pair for the WINDOW (used to find the background color).
-*/
-void win_draw_image(WINDOW *win, const char **image, short img_height, short pair, short win_pair);
+ * Pre-render every sprite (Theseus, the Minotaur, the exit and the eraser) for both
+ * background colors of the board, as lines of chtype cells ready to be copied into a
+ * WINDOW. Each sprite gets a dedicated color pair per background color (its own foreground
+ * color on the background of PAIR_1 or PAIR_2), so drawing a sprite never has to change
+ * the color table. The eraser is drawn in the WINDOW's own color pair. Must be called
+ * after PAIR_1, PAIR_2 and the sprites' color pairs have been initialized, and before any
+ * sprite is drawn with win_draw_sprite().
+ */
+void bake_sprites(void);
+
+/**
+ * Draw a sprite pre-rendered by bake_sprites() on a WINDOW, centered vertically and
+ * horizontally. Only as many characters are drawn as can fit inside a one-character width
+ * padding on each side of the WINDOW. Every line of the sprite is copied with a single
+ * call, without any allocation or change to the color table.
+ *
+ * 'win' specifies the WINDOW to draw the sprite on.
+ * 'sprite' specifies which sprite to draw.
+ * 'win_pair' is the color pair for the WINDOW (PAIR_1 or PAIR_2), which picks the tile
+ *	baked for its background color.
+ */
+void win_draw_sprite(WINDOW *win, sprite_t sprite, short win_pair);
 
 /**
  * Place a new WINDOW on a specified side of a WINDOW currently on the board. The color
@@ -109,4 +178,16 @@ void win_draw_image(WINDOW *win, const char **image, short img_height, short pai
  */
 WINDOW *place_win(WINDOW *neighbor, short placement, short win_height, short win_width);
 
+/**
+ * Copy everything that has been drawn to the virtual screen out to the terminal,
+ * completing one frame of output. All drawing functions for the board only update
+ * the virtual screen, so this is the one place where a frame actually reaches the
+ * terminal. The 'frames_flushed' counter is incremented for every call, and the
+ * output of the frame is measured when latency instrumentation is turned on. With the
+ * ANSI backend, ncurses first sends whatever other WINDOWs (i.e messages and the latency
+ * HUD) have been copied to the virtual screen, and the changed cells of the board are
+ * then sent with one write().
+ */
+void flush_frame(void);
+
 #endif    // _BOARD_H
@@ -0,0 +1,584 @@
+#include "broadcast.h"
+
+// Structure to hold one spectator (owned by the broadcast thread)
+struct spectator {
+	int fd;
+	struct bc_frame *current;		/* Frame being sent (a reference is held), NULL between frames */
+	size_t offset;				/* Bytes of the current frame already sent */
+	unsigned long long next_seq;		/* Next frame of the ring to send */
+	unsigned long long position;		/* Bytes of the published stream sent (or skipped) so far */
+	bool needs_keyframe;
+	bool blocked;				/* The last write would block (waiting for EPOLLOUT) */
+};
+
+// Markers for the epoll events that don't belong to a spectator
+static int listen_marker, wake_marker;
+
+static bool broadcasting = false;
+static volatile bool broadcast_stop_flag = false;
+static pthread_t broadcast_thread;
+static int listen_fd = -1, wake_fd = -1, poll_fd = -1;
+static char listen_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+// Spectators (only touched by the broadcast thread)
+static struct spectator *spectators[BROADCAST_MAX_SPECTATORS];
+static int num_spectators = 0;
+
+// State shared between the game and the broadcast thread (protected by 'ring_lock')
+static pthread_mutex_t ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct bc_frame *ring[BROADCAST_RING];	/* Frame number 's' is kept in ring[s % BROADCAST_RING] */
+static unsigned long long published = 0;	/* Frames published so far */
+static unsigned long long published_bytes = 0;	/* Bytes published so far */
+static struct ansi_cell *mirror = NULL;		/* The screen as of the last published frame (for keyframes) */
+static int mirror_lines = 0, mirror_cols = 0;
+static bool keyframe_wanted = false;
+static struct broadcast_stats stats;
+
+// Whether the broadcast thread is (about to be) waiting in epoll, so the game has to wake it
+static bool broadcast_idle = false;
+static unsigned long long round_head = 0;	/* Frames published as of the last round (broadcast thread only) */
+
+// Allocate a frame holding a copy of some encoded bytes (with one reference)
+static struct bc_frame *frame_new(const char *data, size_t length) {
+	struct bc_frame *frame = malloc(sizeof(struct bc_frame) + length);
+	if (frame == NULL) return NULL;
+
+	frame->refs = 1;
+	frame->length = length;
+	memcpy(frame->data, data, length);
+
+	return frame;
+}
+
+// Take another reference to a frame
+static struct bc_frame *frame_ref(struct bc_frame *frame) {
+	__atomic_add_fetch(&frame->refs, 1, __ATOMIC_RELAXED);
+
+	return frame;
+}
+
+// Drop a reference to a frame, freeing it with the last one
+static void frame_unref(struct bc_frame *frame) {
+	if (frame != NULL && __atomic_sub_fetch(&frame->refs, 1, __ATOMIC_ACQ_REL) == 0)
+		free(frame);
+
+	return;
+}
+
+// Wake the broadcast thread up
+static void wake_broadcast(void) {
+	uint64_t one = 1;
+	ssize_t result = write(wake_fd, &one, sizeof(one));
+	(void)result;
+
+	return;
+}
+
+// Append a frame to the ring, dropping the oldest frame if the ring is full (lock must be held)
+static void ring_push(struct bc_frame *frame) {
+	struct bc_frame **slot = &ring[published % BROADCAST_RING];
+
+	frame_unref(*slot);
+	*slot = frame;
+	__atomic_store_n(&published, published + 1, __ATOMIC_SEQ_CST);
+	published_bytes += frame->length;
+	stats.frames++;
+
+	return;
+}
+
+// Start following the broadcast with a new spectator
+static void add_spectator(int fd) {
+	struct spectator *spec;
+
+	if (num_spectators >= BROADCAST_MAX_SPECTATORS || (spec = calloc(1, sizeof(struct spectator))) == NULL) {
+		close(fd);
+		return;
+	}
+	spec->fd = fd;
+	spec->needs_keyframe = true;
+
+	struct epoll_event event;
+	event.events = EPOLLIN | EPOLLRDHUP;		/* Only to notice when the spectator goes away */
+	event.data.ptr = spec;
+	epoll_ctl(poll_fd, EPOLL_CTL_ADD, fd, &event);
+
+	spectators[num_spectators++] = spec;
+
+	return;
+}
+
+// Disconnect a spectator
+static void drop_spectator(int index) {
+	struct spectator *spec = spectators[index];
+
+	epoll_ctl(poll_fd, EPOLL_CTL_DEL, spec->fd, NULL);
+	close(spec->fd);
+	frame_unref(spec->current);
+	free(spec);
+
+	spectators[index] = spectators[--num_spectators];
+
+	return;
+}
+
+// Wait (or stop waiting) for a spectator's socket to become writable
+static void set_blocked(struct spectator *spec, bool blocked) {
+	if (spec->blocked == blocked) return;
+	spec->blocked = blocked;
+
+	struct epoll_event event;
+	event.events = EPOLLIN | EPOLLRDHUP | (blocked ? EPOLLOUT : 0);
+	event.data.ptr = spec;
+	epoll_ctl(poll_fd, EPOLL_CTL_MOD, spec->fd, &event);
+
+	return;
+}
+
+// Send as much as possible to a spectator from the current frame and the snapshot of the ring
+// (frames 'first' to 'head' - 1), counting the bytes and calls in 'round' (returns false if the
+// spectator has to be dropped)
+static bool send_spectator(struct spectator *spec, struct bc_frame **snapshot, unsigned long long first, unsigned long long head, struct broadcast_stats *round) {
+	struct iovec iov[BROADCAST_IOVECS];
+	int iov_count = 0;
+	size_t wanted = 0;
+
+	if (spec->current != NULL) {
+		iov[iov_count].iov_base = spec->current->data + spec->offset;
+		iov[iov_count++].iov_len = spec->current->length - spec->offset;
+	}
+	for(unsigned long long seq = spec->next_seq; seq >= first && seq < head && iov_count < BROADCAST_IOVECS; seq++) {
+		struct bc_frame *frame = snapshot[seq % BROADCAST_RING];
+		iov[iov_count].iov_base = frame->data;
+		iov[iov_count++].iov_len = frame->length;
+	}
+	if (iov_count == 0) return true;
+
+	for(int i = 0; i < iov_count; i++)
+		wanted += iov[i].iov_len;
+
+	ssize_t sent = writev(spec->fd, iov, iov_count);
+	round->write_calls++;
+	if (sent < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+			set_blocked(spec, true);
+			return true;
+		}
+		return false;
+	}
+	round->bytes += sent;
+
+	// Account for the bytes sent: finish the current frame, then move through the ring
+	size_t left = sent;
+	if (spec->current != NULL) {
+		size_t remaining = spec->current->length - spec->offset;
+		if (left < remaining) {
+			spec->offset += left;
+			left = 0;
+		}
+		else {
+			left -= remaining;
+			frame_unref(spec->current);
+			spec->current = NULL;
+		}
+	}
+	while (spec->current == NULL && spec->next_seq < head) {
+		struct bc_frame *frame = snapshot[spec->next_seq % BROADCAST_RING];
+		if (left == 0) break;
+
+		spec->next_seq++;
+		spec->position += frame->length;
+
+		if (left < frame->length) {
+			spec->current = frame_ref(frame);	/* Keep the rest of the frame even if it leaves the ring */
+			spec->offset = left;
+			left = 0;
+		}
+		else left -= frame->length;
+	}
+
+	set_blocked(spec, (size_t)sent < wanted);
+
+	return true;
+}
+
+// Send the frames published so far to every spectator that isn't blocked
+static void send_round(void) {
+	static struct bc_frame *snapshot[BROADCAST_RING];
+	struct bc_frame *keyframe = NULL;
+	struct broadcast_stats round = {0};
+	unsigned long long head, oldest, first, total_bytes, key_position = 0;
+	bool want_keyframe = false;
+
+	// Take references to the frames any spectator still needs (and a keyframe if one was asked for)
+	first = ~0ULL;
+	for(int i = 0; i < num_spectators; i++) {
+		if (!spectators[i]->needs_keyframe && spectators[i]->next_seq < first) first = spectators[i]->next_seq;
+	}
+
+	pthread_mutex_lock(&ring_lock);
+	head = round_head = published;
+	oldest = (head > BROADCAST_RING) ? head - BROADCAST_RING : 0;
+	total_bytes = published_bytes;
+	if (first < oldest) first = oldest;
+	for(unsigned long long seq = first; seq < head; seq++)
+		snapshot[seq % BROADCAST_RING] = frame_ref(ring[seq % BROADCAST_RING]);
+
+	if (keyframe_wanted) {
+		struct ansi_buffer buffer = {NULL, 0, 0, false};
+		ansi_encode_keyframe(mirror, mirror_lines, mirror_cols, &buffer);
+
+		// A keyframe cut short for want of memory is asked for again next round
+		if (!buffer.failed) {
+			keyframe = frame_new(buffer.data, buffer.length);
+			key_position = total_bytes;
+			keyframe_wanted = false;
+			stats.keyframes++;
+		}
+		free(buffer.data);
+	}
+	pthread_mutex_unlock(&ring_lock);
+
+	for(int i = 0; i < num_spectators; i++) {
+		struct spectator *spec = spectators[i];
+
+		// Between frames, a new or lagging spectator skips ahead to a keyframe
+		if (spec->current == NULL && (spec->needs_keyframe || spec->next_seq < oldest || total_bytes - spec->position > BROADCAST_MAX_BACKLOG)) {
+			if (keyframe == NULL) {
+				want_keyframe = true;
+				continue;
+			}
+			spec->current = frame_ref(keyframe);
+			spec->offset = 0;
+			spec->next_seq = head;
+			spec->position = key_position;
+			spec->needs_keyframe = false;
+			round.resyncs++;
+		}
+
+		if (spec->blocked) continue;
+		if (!send_spectator(spec, snapshot, first, head, &round)) drop_spectator(i--);
+	}
+
+	for(unsigned long long seq = first; seq < head; seq++)
+		frame_unref(snapshot[seq % BROADCAST_RING]);
+	frame_unref(keyframe);
+
+	// Update the counters, and have a keyframe made (from the latest screen) on the next round
+	pthread_mutex_lock(&ring_lock);
+	stats.resyncs += round.resyncs;
+	stats.bytes += round.bytes;
+	stats.write_calls += round.write_calls;
+	stats.spectators = num_spectators;
+	if (want_keyframe) keyframe_wanted = true;
+	pthread_mutex_unlock(&ring_lock);
+
+	if (want_keyframe) wake_broadcast();
+
+	return;
+}
+
+// Broadcast thread: accept spectators, notice when they leave, and send them the frames
+static void *broadcast_worker(void *arg) {
+	struct epoll_event events[BROADCAST_MAX_EVENTS];
+	(void)arg;
+
+	while (!broadcast_stop_flag) {
+		// Only sleep if no frame was published since the last round (the game wakes us otherwise)
+		__atomic_store_n(&broadcast_idle, true, __ATOMIC_SEQ_CST);
+		bool behind = (__atomic_load_n(&published, __ATOMIC_SEQ_CST) != round_head);
+		if (behind) __atomic_store_n(&broadcast_idle, false, __ATOMIC_SEQ_CST);
+
+		int num_events = epoll_wait(poll_fd, events, BROADCAST_MAX_EVENTS, behind ? 0 : -1);
+		__atomic_store_n(&broadcast_idle, false, __ATOMIC_SEQ_CST);
+
+		for(int i = 0; i < num_events; i++) {
+			if (events[i].data.ptr == &listen_marker) {
+				int fd;
+				while ((fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+					add_spectator(fd);
+			}
+			else if (events[i].data.ptr == &wake_marker) {
+				uint64_t count;
+				ssize_t result = read(wake_fd, &count, sizeof(count));
+				(void)result;
+			}
+			else {
+				struct spectator *spec = events[i].data.ptr;
+				char discard[256];
+
+				if (events[i].events & EPOLLOUT) set_blocked(spec, false);
+
+				// Spectators are read-only; anything they send is ignored, and EOF means they left
+				if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+					ssize_t length = read(spec->fd, discard, sizeof(discard));
+
+					if (length == 0 || (length < 0 && errno != EAGAIN && errno != EINTR) ||
+					    (events[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+						for(int j = 0; j < num_spectators; j++) {
+							if (spectators[j] == spec) {
+								drop_spectator(j);
+								break;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		send_round();
+	}
+
+	return NULL;
+}
+
+/**
+ * Start streaming the game to read-only spectators. The frames encoded by the ANSI backend
+ * are published once into a ring of reference-counted buffers, and a broadcast thread sends
+ * them to every spectator with writev(), so the cost of a frame for the game doesn't grow
+ * with the number of spectators. A spectator that connects, or that falls too far behind,
+ * is sent a keyframe of the current screen instead of the frames it missed.
+ *
+ * 'socket_path' specifies a Unix domain socket to accept spectators on (NULL for none).
+ * 'pipe_fd' specifies an already open file descriptor (i.e a pipe) to stream to (-1 for none).
+ * 'lines', 'cols' specify the size of the ANSI backend's screen.
+ *
+ * Return Values:
+ *	true - The broadcast is running.
+ *	false - The socket or the broadcast thread could not be set up.
+ */
+bool broadcast_start(const char *socket_path, int pipe_fd, int lines, int cols) {
+	struct epoll_event event;
+
+	if (broadcasting) return true;
+
+	mirror = malloc(sizeof(struct ansi_cell) * lines * cols);
+	poll_fd = epoll_create1(EPOLL_CLOEXEC);
+	wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (mirror == NULL || poll_fd < 0 || wake_fd < 0) goto failed;
+
+	mirror_lines = lines;
+	mirror_cols = cols;
+	for(int i = 0; i < lines * cols; i++) {
+		mirror[i].ch = ' ';
+		mirror[i].fg = mirror[i].bg = ANSI_DEFAULT;
+	}
+
+	event.events = EPOLLIN;
+	event.data.ptr = &wake_marker;
+	epoll_ctl(poll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+
+	// Listen for spectators (replacing a stale socket file from an earlier run)
+	if (socket_path != NULL) {
+		struct sockaddr_un address;
+
+		if (strlen(socket_path) >= sizeof(address.sun_path)) {
+			errno = ENAMETOOLONG;
+			goto failed;
+		}
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		strcpy(address.sun_path, socket_path);
+		unlink(socket_path);
+
+		listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(listen_fd, SOMAXCONN) < 0)
+			goto failed;
+		strcpy(listen_path, socket_path);
+
+		event.events = EPOLLIN;
+		event.data.ptr = &listen_marker;
+		epoll_ctl(poll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+	}
+
+	// A pipe is just a spectator that never connected
+	if (pipe_fd >= 0) {
+		fcntl(pipe_fd, F_SETFL, fcntl(pipe_fd, F_GETFL) | O_NONBLOCK);
+		add_spectator(pipe_fd);
+	}
+
+	signal(SIGPIPE, SIG_IGN);		/* Spectators that leave are noticed by writev() failing */
+
+	broadcast_stop_flag = false;
+	if (pthread_create(&broadcast_thread, NULL, broadcast_worker, NULL) != 0) goto failed;
+	broadcasting = true;
+
+	return true;
+
+failed:
+	if (listen_fd >= 0) {
+		close(listen_fd);
+		if (listen_path[0] != '\0') unlink(listen_path);
+	}
+	if (poll_fd >= 0) close(poll_fd);
+	if (wake_fd >= 0) close(wake_fd);
+	free(mirror);
+
+	listen_fd = poll_fd = wake_fd = -1;
+	listen_path[0] = '\0';
+	mirror = NULL;
+
+	return false;
+}
+
+/**
+ * Stop the spectator broadcast, disconnect every spectator and remove the socket.
+ */
+void broadcast_stop(void) {
+	if (!broadcasting) return;
+
+	broadcast_stop_flag = true;
+	wake_broadcast();
+	pthread_join(broadcast_thread, NULL);
+	broadcasting = false;
+
+	while (num_spectators > 0) drop_spectator(0);
+	for(int i = 0; i < BROADCAST_RING; i++) {
+		frame_unref(ring[i]);
+		ring[i] = NULL;
+	}
+
+	if (listen_fd >= 0) {
+		close(listen_fd);
+		unlink(listen_path);
+	}
+	close(poll_fd);
+	close(wake_fd);
+	free(mirror);
+
+	listen_fd = poll_fd = wake_fd = -1;
+	listen_path[0] = '\0';
+	mirror = NULL;
+
+	return;
+}
+
+/**
+ * Publish a frame encoded by the ANSI backend to the spectators. Only one copy of the frame
+ * is made, no matter how many spectators there are. Nothing is done if no broadcast is
+ * running.
+ *
+ * 'data', 'length' specify the encoded frame.
+ * 'screen' specifies the ANSI backend's screen buffer after the frame.
+ * 'top', 'bottom' specify the range of rows of the screen buffer the frame changed.
+ */
+void broadcast_frame(const char *data, size_t length, const struct ansi_cell *screen, int top, int bottom) {
+	if (!broadcasting) return;
+
+	struct bc_frame *frame = frame_new(data, length);
+	if (frame == NULL) return;
+
+	if (bottom >= mirror_lines) bottom = mirror_lines - 1;
+
+	pthread_mutex_lock(&ring_lock);
+	if (top <= bottom)
+		memcpy(&mirror[top * mirror_cols], &screen[top * mirror_cols], sizeof(struct ansi_cell) * (bottom - top + 1) * mirror_cols);
+	ring_push(frame);
+	pthread_mutex_unlock(&ring_lock);
+
+	if (__atomic_exchange_n(&broadcast_idle, false, __ATOMIC_SEQ_CST)) wake_broadcast();
+
+	return;
+}
+
+/**
+ * Tell the spectators that the screen was cleared (i.e when a new level is drawn).
+ * Nothing is done if no broadcast is running.
+ */
+void broadcast_clear(void) {
+	if (!broadcasting) return;
+
+	struct bc_frame *frame = frame_new(ANSI_CLEAR_SCREEN, strlen(ANSI_CLEAR_SCREEN));
+	if (frame == NULL) return;
+
+	pthread_mutex_lock(&ring_lock);
+	for(int i = 0; i < mirror_lines * mirror_cols; i++) {
+		mirror[i].ch = ' ';
+		mirror[i].fg = mirror[i].bg = ANSI_DEFAULT;
+	}
+	ring_push(frame);
+	pthread_mutex_unlock(&ring_lock);
+
+	if (__atomic_exchange_n(&broadcast_idle, false, __ATOMIC_SEQ_CST)) wake_broadcast();
+
+	return;
+}
+
+/**
+ * Copy the counters of the spectator broadcast.
+ *
+ * 'copy' specifies the structure to copy the counters to.
+ */
+void broadcast_get_stats(struct broadcast_stats *copy) {
+	pthread_mutex_lock(&ring_lock);
+	*copy = stats;
+	pthread_mutex_unlock(&ring_lock);
+
+	return;
+}
+
+// Leave the watch loop on SIGINT
+static volatile sig_atomic_t watch_stop = 0;
+static void watch_handler(int signum) {
+	(void)signum;
+	watch_stop = 1;
+
+	return;
+}
+
+/**
+ * Watch a game being broadcast: connect to its socket and copy the stream to the terminal
+ * until the game ends or SIGINT is received.
+ *
+ * 'socket_path' specifies the Unix domain socket of the broadcast.
+ *
+ * Return Values:
+ *	0 - The broadcast ended.
+ *	1 - The broadcast could not be reached.
+ */
+int watch_broadcast(const char *socket_path) {
+	struct sockaddr_un address;
+	char buffer[65536];
+	ssize_t length;
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, socket_path, sizeof(address.sun_path) - 1);
+
+	if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+		perror("theseus: could not connect to broadcast");
+		if (fd >= 0) close(fd);
+		return 1;
+	}
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = watch_handler;		/* No SA_RESTART, so read() returns on SIGINT */
+	sigaction(SIGINT, &action, NULL);
+
+	while (!watch_stop && (length = read(fd, buffer, sizeof(buffer))) != 0) {
+		if (length < 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+		for(ssize_t sent = 0, result; sent < length; sent += result) {
+			if ((result = write(STDOUT_FILENO, buffer + sent, length - sent)) < 0) {
+				if (errno == EINTR) {
+					result = 0;
+					continue;
+				}
+				close(fd);
+				return 0;
+			}
+		}
+	}
+	close(fd);
+
+	// Give the terminal back in a usable state
+	const char *reset = "\033[0m\033[?25h\n";
+	ssize_t result = write(STDOUT_FILENO, reset, strlen(reset));
+	(void)result;
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+#ifndef _BROADCAST_H
+#define _BROADCAST_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "ansi.h"
+
+#define BROADCAST_RING 1024			/* Frames kept for spectators that fall behind */
+#define BROADCAST_MAX_BACKLOG (256 * 1024)	/* Bytes a spectator may fall behind before it's resent a keyframe */
+#define BROADCAST_MAX_SPECTATORS 1024		/* Spectators connected at once */
+#define BROADCAST_IOVECS 64			/* Frames sent per writev() call */
+#define BROADCAST_MAX_EVENTS 64			/* Events taken from epoll per wake-up */
+
+// Structure to hold one encoded frame shared by every spectator (freed with the last reference)
+struct bc_frame {
+	unsigned int refs;
+	size_t length;
+	char data[];
+};
+
+// Structure to hold the counters of a spectator broadcast
+struct broadcast_stats {
+	unsigned long long frames;		/* Frames published by the game */
+	unsigned long long keyframes;		/* Keyframes encoded */
+	unsigned long long resyncs;		/* Keyframes sent (new or lagging spectators) */
+	unsigned long long bytes;		/* Bytes sent to all spectators */
+	unsigned long long write_calls;		/* writev() calls made for the spectators */
+	int spectators;				/* Spectators currently connected */
+};
+
+/**
+ * Start streaming the game to read-only spectators. The frames encoded by the ANSI backend
+ * are published once into a ring of reference-counted buffers, and a broadcast thread sends
+ * them to every spectator with writev(), so the cost of a frame for the game doesn't grow
+ * with the number of spectators. A spectator that connects, or that falls too far behind,
+ * is sent a keyframe of the current screen instead of the frames it missed.
+ *
+ * 'socket_path' specifies a Unix domain socket to accept spectators on (NULL for none).
+ * 'pipe_fd' specifies an already open file descriptor (i.e a pipe) to stream to (-1 for none).
+ * 'lines', 'cols' specify the size of the ANSI backend's screen.
+ *
+ * Return Values:
+ *	true - The broadcast is running.
+ *	false - The socket or the broadcast thread could not be set up.
+ */
+bool broadcast_start(const char *socket_path, int pipe_fd, int lines, int cols);
+
+/**
+ * Stop the spectator broadcast, disconnect every spectator and remove the socket.
+ */
+void broadcast_stop(void);
+
+/**
+ * Publish a frame encoded by the ANSI backend to the spectators. Only one copy of the frame
+ * is made, no matter how many spectators there are. Nothing is done if no broadcast is
+ * running.
+ *
+ * 'data', 'length' specify the encoded frame.
+ * 'screen' specifies the ANSI backend's screen buffer after the frame.
+ * 'top', 'bottom' specify the range of rows of the screen buffer the frame changed.
+ */
+void broadcast_frame(const char *data, size_t length, const struct ansi_cell *screen, int top, int bottom);
+
+/**
+ * Tell the spectators that the screen was cleared (i.e when a new level is drawn).
+ * Nothing is done if no broadcast is running.
+ */
+void broadcast_clear(void);
+
+/**
+ * Copy the counters of the spectator broadcast.
+ *
+ * 'copy' specifies the structure to copy the counters to.
+ */
+void broadcast_get_stats(struct broadcast_stats *copy);
+
+/**
+ * Watch a game being broadcast: connect to its socket and copy the stream to the terminal
+ * until the game ends or SIGINT is received.
+ *
+ * 'socket_path' specifies the Unix domain socket of the broadcast.
+ *
+ * Return Values:
+ *	0 - The broadcast ended.
+ *	1 - The broadcast could not be reached.
+ */
+int watch_broadcast(const char *socket_path);
+
+#endif	    // _BROADCAST_H
@@ -0,0 +1,587 @@
+#include "cache.h"
+
+#define FNV_OFFSET 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+// Round a record length up to the alignment of the records in the file
+static size_t record_size(int32_t length) {
+	return (sizeof(struct cache_record) + length + 7) & ~(size_t)7;
+}
+
+// Add some bytes to a 64-bit FNV-1a hash
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t length) {
+	const unsigned char *bytes = data;
+
+	for(size_t i = 0; i < length; i++)
+		hash = (hash ^ bytes[i]) * FNV_PRIME;
+
+	return hash;
+}
+
+// Add a number to a 64-bit FNV-1a hash
+static uint64_t hash_int(uint64_t hash, int64_t value) {
+	return hash_bytes(hash, &value, sizeof(value));
+}
+
+// Checksum of a record (everything after the checksum field) and of the moves that follow it
+static uint32_t record_checksum(const struct cache_record *record) {
+	const char *start = (const char *)&record->turns;
+	size_t length = sizeof(struct cache_record) - (start - (const char *)record) + record->length;
+	uint64_t hash = hash_bytes(FNV_OFFSET, start, length);
+
+	return (uint32_t)(hash ^ (hash >> 32));
+}
+
+// Allocate an empty index with a number of slots (a power of two)
+static struct cache_index *index_new(size_t num_slots) {
+	struct cache_index *index = calloc(1, sizeof(struct cache_index) + sizeof(struct cache_slot) * num_slots);
+	if (index != NULL) index->num_slots = num_slots;
+
+	return index;
+}
+
+// Put a key into an index (the record is set before the key is published, for the readers)
+static void index_insert(struct cache_index *index, uint64_t key, uint32_t offset) {
+	size_t mask = index->num_slots - 1;
+	size_t slot = (size_t)(key * HASH_MULTIPLIER) & mask;
+
+	while (index->slots[slot].key != 0) {
+		if (index->slots[slot].key == key) return;
+		slot = (slot + 1) & mask;
+	}
+
+	index->slots[slot].offset = offset;
+	__atomic_store_n(&index->slots[slot].key, key, __ATOMIC_RELEASE);
+}
+
+// Find the record of a key in an index: returns its offset, or 0 if the key isn't there
+static uint32_t index_find(const struct cache_index *index, uint64_t key) {
+	size_t mask = index->num_slots - 1;
+	size_t slot = (size_t)(key * HASH_MULTIPLIER) & mask;
+
+	while (true) {
+		uint64_t found = __atomic_load_n(&index->slots[slot].key, __ATOMIC_ACQUIRE);
+
+		if (found == key) return index->slots[slot].offset;
+		if (found == 0) return 0;
+		slot = (slot + 1) & mask;
+	}
+}
+
+// Add a record to the index of a cache, swapping in a larger index first if it's half full
+static bool cache_index_add(struct result_cache *cache, uint64_t key, uint32_t offset) {
+	struct cache_index *index = cache->index;
+
+	if ((cache->num_keys + 1) * 2 > index->num_slots) {
+		struct cache_index *larger = index_new(index->num_slots * 2);
+		if (larger == NULL) return false;
+
+		for(size_t i = 0; i < index->num_slots; i++)
+			if (index->slots[i].key != 0) index_insert(larger, index->slots[i].key, index->slots[i].offset);
+
+		// Readers may still be probing the old index, so it's only freed with the cache
+		larger->retired = index;
+		__atomic_store_n(&cache->index, larger, __ATOMIC_RELEASE);
+		index = larger;
+	}
+
+	index_insert(index, key, offset);
+	cache->num_keys++;
+
+	return true;
+}
+
+// Index the complete records between the end of the indexed ones and 'size' (with the cache's write lock held)
+static bool index_records(struct result_cache *cache, size_t size) {
+	size_t offset = cache->indexed_end;
+
+	while (offset + sizeof(struct cache_record) <= size) {
+		const struct cache_record *record = (const struct cache_record *)(cache->map + offset);
+
+		if (record->key == 0 || record->length < 0 || record->length > (int32_t)(size - offset)
+		    || offset + record_size(record->length) > size || record->checksum != record_checksum(record))
+			break;
+		if (!cache_index_add(cache, record->key, (uint32_t)offset)) return false;
+
+		offset += record_size(record->length);
+	}
+	cache->indexed_end = offset;
+
+	return true;
+}
+
+// Index the records other processes have appended since the cache was last indexed (with the write lock and a file lock held)
+static bool index_appended(struct result_cache *cache) {
+	struct stat info;
+
+	if (fstat(cache->fd, &info) != 0) return false;
+
+	size_t size = (size_t)info.st_size;
+	if (size > CACHE_MAP_BYTES) size = CACHE_MAP_BYTES;
+
+	return (size <= cache->indexed_end) || index_records(cache, size);
+}
+
+/**
+ * Compute the key of a level: a 64-bit hash of the level once normalized into its engine
+ * form (the board size, the valid moves of every square, the exit, the starting squares
+ * and the rules). Level files that only differ in layout, comments or the order of their
+ * walls get the same key.
+ *
+ * 'level' specifies the level.
+ *
+ * Return Value:
+ *	The function returns the key (never 0).
+ */
+uint64_t cache_key(const struct engine_level *level) {
+	uint64_t hash = hash_int(FNV_OFFSET, CACHE_VERSION);
+
+	hash = hash_int(hash, level->num_rows);
+	hash = hash_int(hash, level->num_cols);
+	hash = hash_bytes(hash, level->masks, level->num_cells);
+	hash = hash_int(hash, level->exit_cell);
+	hash = hash_int(hash, level->exit_dir);
+	hash = hash_int(hash, level->theseus_start);
+	hash = hash_int(hash, level->num_minotaurs);
+	for(int k = 0; k < level->num_minotaurs; k++)
+		hash = hash_int(hash, level->minotaur_starts[k]);
+	hash = hash_int(hash, level->rules.minotaur_steps);
+	hash = hash_int(hash, level->rules.vertical_first);
+	hash = hash_int(hash, level->rules.theseus_steps);
+
+	return (hash != 0) ? hash : 1;
+}
+
+// Add a number to a hash in one step (for the canonical keys, which are computed in bulk)
+static uint64_t hash_word(uint64_t hash, uint64_t word) {
+	hash = (hash ^ word) * HASH_MULTIPLIER;
+
+	return hash ^ (hash >> 29);
+}
+
+// Add a block of bytes to a hash, eight at a time
+static uint64_t hash_block(uint64_t hash, const unsigned char *data, size_t length) {
+	size_t i = 0;
+
+	for(; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+		uint64_t word;
+
+		memcpy(&word, data + i, sizeof(word));
+		hash = hash_word(hash, word);
+	}
+
+	return hash_bytes(hash, data + i, length - i);
+}
+
+// Map a cell of a level through a symmetry (bit 0: mirror the columns, bit 1: mirror the rows, bit 2: transpose first)
+static int symmetry_cell(const struct engine_level *level, int symmetry, int cell) {
+	int row = cell / level->num_cols, col = cell % level->num_cols;
+	int nrows = level->num_rows, ncols = level->num_cols;
+
+	if (symmetry & 4) {
+		int swap = row;
+		row = col;
+		col = swap;
+		nrows = level->num_cols;
+		ncols = level->num_rows;
+	}
+	if (symmetry & 1) col = ncols - 1 - col;
+	if (symmetry & 2) row = nrows - 1 - row;
+
+	return (row * ncols) + col;
+}
+
+// Map a move through a symmetry
+static int symmetry_move(int symmetry, int move) {
+	static const int transposed[NUM_MOVES] = {UP, DOWN, LEFT, RIGHT};
+
+	if (symmetry & 4) move = transposed[move];
+	if ((symmetry & 1) && (move == LEFT || move == RIGHT)) move = (move == LEFT) ? RIGHT : LEFT;
+	if ((symmetry & 2) && (move == UP || move == DOWN)) move = (move == UP) ? DOWN : UP;
+
+	return move;
+}
+
+// Map a bit-mask of moves through a symmetry
+static int symmetry_mask(int symmetry, int mask) {
+	if (symmetry & 4) mask = ((mask & 3) << 2) | ((mask >> 2) & 3);		/* LEFT <-> UP, RIGHT <-> DOWN */
+	if (symmetry & 1) mask = (mask & 12) | ((mask & 1) << 1) | ((mask >> 1) & 1);	/* LEFT <-> RIGHT */
+	if (symmetry & 2) mask = (mask & 3) | ((mask & 4) << 1) | ((mask >> 1) & 4);	/* UP <-> DOWN */
+
+	return mask;
+}
+
+// Hash a level as seen through a symmetry ('scratch' holds one byte per cell)
+static uint64_t symmetry_hash(const struct engine_level *level, int symmetry, unsigned char *scratch) {
+	unsigned char mask_map[1 << NUM_MOVES];
+	bool transposed = (symmetry & 4);
+
+	for(int mask = 0; mask < (1 << NUM_MOVES); mask++)
+		mask_map[mask] = symmetry_mask(symmetry, mask);
+
+	// Walk the level's cells in order, stepping through the image's cells with two strides
+	int origin = symmetry_cell(level, symmetry, 0);
+	int col_step = symmetry_cell(level, symmetry, 1) - origin;
+	int row_step = symmetry_cell(level, symmetry, level->num_cols) - origin;
+	const unsigned char *masks = level->masks;
+
+	for(int row = 0; row < level->num_rows; row++) {
+		int image = origin + (row * row_step);
+
+		for(int col = 0; col < level->num_cols; col++, image += col_step)
+			scratch[image] = mask_map[*masks++];
+	}
+
+	uint64_t hash = hash_word(FNV_OFFSET, transposed ? level->num_cols : level->num_rows);
+	hash = hash_word(hash, transposed ? level->num_rows : level->num_cols);
+	hash = hash_block(hash, scratch, level->num_cells);
+	hash = hash_word(hash, symmetry_cell(level, symmetry, level->exit_cell));
+	hash = hash_word(hash, symmetry_move(symmetry, level->exit_dir));
+	hash = hash_word(hash, symmetry_cell(level, symmetry, level->theseus_start));
+	hash = hash_word(hash, level->num_minotaurs);
+	for(int k = 0; k < level->num_minotaurs; k++)
+		hash = hash_word(hash, symmetry_cell(level, symmetry, level->minotaur_starts[k]));
+	hash = hash_word(hash, level->rules.minotaur_steps);
+	hash = hash_word(hash, level->rules.vertical_first != transposed);
+	hash = hash_word(hash, level->rules.theseus_steps);
+
+	return hash;
+}
+
+/**
+ * Compute the canonical key of a level: a 64-bit hash that is the same for a level and all
+ * of its mirror images and rotations, for finding duplicate levels. The Minotaur's move
+ * order makes the symmetries that swap rows and columns (transposes and quarter turns)
+ * swap the horizontal-first and vertical-first rules too, so such an image only gets the
+ * same key as the level if its rules say the opposite; the mirror images and the half
+ * turn keep the rules as they are. The Minotaurs keep their order.
+ *
+ * The level is hashed as seen through each of the eight symmetries, with every square's
+ * valid moves, the exit and the starting squares mapped, and the smallest hash is taken.
+ * Unlike cache_key(), the key must not be used to look up solutions: the moves of a
+ * mirror image are mirrored.
+ *
+ * 'level' specifies the level.
+ *
+ * Return Value:
+ *	The function returns the key (never 0), or 0 if memory could not be allocated.
+ */
+uint64_t cache_canonical_key(const struct engine_level *level) {
+	unsigned char small[CANONICAL_STACK_CELLS];
+	unsigned char *scratch = (level->num_cells <= CANONICAL_STACK_CELLS) ? small : malloc(level->num_cells);
+	uint64_t key = UINT64_MAX;
+
+	if (scratch == NULL) return 0;
+
+	// The smallest hash of the level's images is the same for every image
+	for(int symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++) {
+		uint64_t hash = symmetry_hash(level, symmetry, scratch);
+		if (hash < key) key = hash;
+	}
+
+	if (scratch != small) free(scratch);
+
+	return (key != 0) ? key : 1;
+}
+
+/**
+ * Check whether a level is the same as another one, or a mirror image or a rotation of it,
+ * by mapping the first level through each of the eight symmetries (as cache_canonical_key()
+ * does) and comparing the image with the second level square by square. Levels with the
+ * same canonical key are almost always the same, but only this tells them apart for sure.
+ *
+ * 'level' specifies the level.
+ * 'other' specifies the other level.
+ *
+ * Return Values:
+ *	true - One of the images of 'level' is 'other'.
+ *	false - The levels are different.
+ */
+bool cache_same_level(const struct engine_level *level, const struct engine_level *other) {
+	for(int symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++) {
+		bool transposed = (symmetry & 4), same = true;
+
+		if (other->num_rows != (transposed ? level->num_cols : level->num_rows) ||
+		    other->num_cols != (transposed ? level->num_rows : level->num_cols) ||
+		    other->exit_cell != symmetry_cell(level, symmetry, level->exit_cell) ||
+		    other->exit_dir != symmetry_move(symmetry, level->exit_dir) ||
+		    other->theseus_start != symmetry_cell(level, symmetry, level->theseus_start) ||
+		    other->num_minotaurs != level->num_minotaurs ||
+		    other->rules.minotaur_steps != level->rules.minotaur_steps ||
+		    other->rules.theseus_steps != level->rules.theseus_steps ||
+		    other->rules.vertical_first != (level->rules.vertical_first != transposed)) continue;
+
+		for(int k = 0; k < level->num_minotaurs && same; k++)
+			same = (other->minotaur_starts[k] == symmetry_cell(level, symmetry, level->minotaur_starts[k]));
+		for(int cell = 0; cell < level->num_cells && same; cell++)
+			same = (other->masks[symmetry_cell(level, symmetry, cell)] == symmetry_mask(symmetry, level->masks[cell]));
+		if (same) return true;
+	}
+
+	return false;
+}
+
+/**
+ * Open a result cache file, creating it if it doesn't exist. The file is mapped into
+ * memory and its records are indexed by key; a record cut short at the end of the file
+ * (by a writer that crashed) is dropped.
+ *
+ * 'cache' specifies the result_cache structure to initialize.
+ * 'path' specifies the file path of the cache.
+ *
+ * Return Values:
+ *	true - The cache was opened.
+ *	false - The file could not be opened or created, or isn't a cache file.
+ */
+bool cache_open(struct result_cache *cache, const char *path) {
+	struct stat info;
+	bool ok = false;
+
+	cache->map = MAP_FAILED;
+	cache->index = NULL;
+	cache->num_keys = 0;
+	cache->hits = cache->misses = 0;
+
+	cache->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+	if (cache->fd < 0) return false;
+
+	// Hold the file while checking it, so no other process appends to it meanwhile
+	if (flock(cache->fd, LOCK_EX) != 0 || fstat(cache->fd, &info) != 0) goto done;
+
+	// Write the header of a new cache file
+	size_t size = (size_t)info.st_size;
+	if (size == 0) {
+		struct cache_header header;
+
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+		header.version = CACHE_VERSION;
+		header.record_align = 8;
+		if (write(cache->fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) goto done;
+		size = sizeof(header);
+	}
+	if (size > CACHE_MAP_BYTES) size = CACHE_MAP_BYTES;
+
+	cache->map = mmap(NULL, CACHE_MAP_BYTES, PROT_READ, MAP_SHARED, cache->fd, 0);
+	if (cache->map == MAP_FAILED) goto done;
+
+	const struct cache_header *header = (const struct cache_header *)cache->map;
+	if (size < sizeof(*header) || memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) != 0 || header->version != CACHE_VERSION) {
+		errno = EINVAL;
+		goto done;
+	}
+
+	cache->index = index_new(CACHE_MIN_SLOTS);
+	if (cache->index == NULL) goto done;
+
+	// Index every complete record, and drop whatever follows the last one
+	cache->indexed_end = sizeof(*header);
+	if (!index_records(cache, size)) goto done;
+	if (cache->indexed_end < size && (size_t)info.st_size <= CACHE_MAP_BYTES && ftruncate(cache->fd, cache->indexed_end) != 0) goto done;
+
+	pthread_mutex_init(&cache->write_lock, NULL);
+	ok = true;
+
+done:
+	flock(cache->fd, LOCK_UN);
+	if (!ok) {
+		int error = errno;
+
+		close(cache->fd);
+		cache->fd = -1;
+		cache_close(cache);
+		errno = error;
+	}
+
+	return ok;
+}
+
+/**
+ * Close a result cache and free the memory held by it.
+ */
+void cache_close(struct result_cache *cache) {
+	for(struct cache_index *index = cache->index, *next; index != NULL; index = next) {
+		next = index->retired;
+		free(index);
+	}
+	cache->index = NULL;
+
+	if (cache->map != MAP_FAILED) munmap((void *)cache->map, CACHE_MAP_BYTES);
+	cache->map = MAP_FAILED;
+
+	if (cache->fd >= 0) {
+		close(cache->fd);
+		pthread_mutex_destroy(&cache->write_lock);
+	}
+	cache->fd = -1;
+}
+
+/**
+ * Look up the solution of a level in a cache. Lookups of indexed levels take no lock, so
+ * any number of threads can look up levels while another thread stores results. A level
+ * that isn't indexed is looked for again after indexing the records other processes have
+ * appended to the file since (under a shared lock on the file).
+ *
+ * 'cache' specifies the cache.
+ * 'key' specifies the key of the level (see cache_key()).
+ * 'sol' receives the cached solution (free it with free_solution()). Only the fields that
+ *	are kept in the cache are set: the states, expanded and memory fields are zeroed.
+ *
+ * Return Values:
+ *	true - The level was found in the cache.
+ *	false - The level is not in the cache (or memory for the moves could not be allocated).
+ */
+bool cache_lookup(struct result_cache *cache, uint64_t key, struct solution *sol) {
+	const struct cache_index *index = __atomic_load_n(&cache->index, __ATOMIC_ACQUIRE);
+	uint32_t offset = index_find(index, key);
+
+	// Another process may have stored the level since the file was last indexed
+	if (offset == 0) {
+		pthread_mutex_lock(&cache->write_lock);
+		if (flock(cache->fd, LOCK_SH) == 0) {
+			if (index_appended(cache)) offset = index_find(cache->index, key);
+			flock(cache->fd, LOCK_UN);
+		}
+		pthread_mutex_unlock(&cache->write_lock);
+	}
+	if (offset == 0) {
+		__atomic_add_fetch(&cache->misses, 1, __ATOMIC_RELAXED);
+		return false;
+	}
+
+	const struct cache_record *record = (const struct cache_record *)(cache->map + offset);
+
+	sol->solvable = record->solvable;
+	sol->turns = record->turns;
+	sol->states = sol->expanded = 0;
+	sol->memory = 0;
+	sol->moves = NULL;
+	if (record->solvable) {
+		sol->moves = malloc(record->length + 1);
+		if (sol->moves == NULL) return false;
+
+		memcpy(sol->moves, record + 1, record->length);
+		sol->moves[record->length] = '\0';
+	}
+	__atomic_add_fetch(&cache->hits, 1, __ATOMIC_RELAXED);
+
+	return true;
+}
+
+/**
+ * Append the solution of a level to a cache. The record is written to the end of the file
+ * with one write while holding an exclusive lock on the file, so several processes can
+ * share one cache file. The records other processes have appended are indexed first, and
+ * the level isn't written again if one of them already holds it.
+ *
+ * 'cache' specifies the cache.
+ * 'key' specifies the key of the level (see cache_key()).
+ * 'sol' specifies the solution to store.
+ *
+ * Return Values:
+ *	true - The solution was stored (or was already in the cache).
+ *	false - The record could not be written, or the cache file is full.
+ */
+bool cache_store(struct result_cache *cache, uint64_t key, const struct solution *sol) {
+	int32_t length = (sol->solvable) ? (int32_t)strlen(sol->moves) : 0;
+	size_t size = record_size(length);
+	struct cache_record *record = calloc(1, size);
+	bool ok = false;
+
+	if (record == NULL) return false;
+
+	record->key = key;
+	record->turns = (sol->solvable) ? sol->turns : 0;
+	record->length = length;
+	record->solvable = sol->solvable;
+	if (length > 0) memcpy(record + 1, sol->moves, length);
+	record->checksum = record_checksum(record);
+
+	pthread_mutex_lock(&cache->write_lock);
+
+	// Another thread of this process may have stored the level already
+	if (index_find(cache->index, key) != 0) ok = true;
+	else if (flock(cache->fd, LOCK_EX) == 0) {
+		struct stat info;
+
+		// Other processes may have appended records too: index them, and only append the level if none of them holds it
+		if (!index_appended(cache) || fstat(cache->fd, &info) != 0) ok = false;
+		else if (index_find(cache->index, key) != 0) ok = true;
+		else if (cache->indexed_end + size <= CACHE_MAP_BYTES && (size_t)info.st_size <= CACHE_MAP_BYTES
+			 && (cache->indexed_end == (size_t)info.st_size || ftruncate(cache->fd, cache->indexed_end) == 0)
+			 && write(cache->fd, record, size) == (ssize_t)size) {
+			ok = cache_index_add(cache, key, (uint32_t)cache->indexed_end);
+			cache->indexed_end += size;
+		}
+
+		flock(cache->fd, LOCK_UN);
+	}
+
+	pthread_mutex_unlock(&cache->write_lock);
+	free(record);
+
+	return ok;
+}
+
+// Play a cached solution through the engine: returns true if it is unsolvable, or if Theseus escapes with its last move
+static bool escapes_with(const struct engine_level *level, const struct solution *sol) {
+	static const char letters[] = "LRUDS";	/* Same order as the moves, then skip */
+	struct engine_state state;
+	engine_result result = ENGINE_MOVED;
+
+	if (!sol->solvable) return true;
+
+	const char *c = sol->moves;
+	engine_reset(level, &state);
+	for(; *c != '\0' && result == ENGINE_MOVED; c++) {
+		const char *move = strchr(letters, *c);
+
+		if (move == NULL) return false;
+		result = engine_turn(level, &state, (short)(move - letters));
+	}
+
+	return (result == ENGINE_ESCAPED && *c == '\0');
+}
+
+/**
+ * Solve a level, looking the solution up in a cache first and storing it there if it
+ * has to be searched for. A failure to store the result is not reported. A cached way
+ * out is played through the engine before it is trusted: if it doesn't make Theseus
+ * escape (another level with the same key), the level is searched for as on a miss.
+ * A record that says the level is unsolvable is taken as it is.
+ *
+ * 'cache' specifies the cache (NULL to always search).
+ * 'level' specifies the level to solve.
+ * 'method' specifies the search method (see solve_level()).
+ * 'sol' receives the solution (free it with free_solution()).
+ * 'cached' receives whether the solution came from the cache.
+ *
+ * Return Values:
+ *	true - The level was solved.
+ *	false - Memory for the search could not be allocated.
+ */
+bool cache_solve(struct result_cache *cache, const struct engine_level *level, search_method method, struct solution *sol, bool *cached) {
+	uint64_t key = 0;
+
+	*cached = false;
+	if (cache != NULL) {
+		key = cache_key(level);
+		if (cache_lookup(cache, key, sol)) {
+			if (escapes_with(level, sol)) {
+				*cached = true;
+				return true;
+			}
+
+			// The record belongs to another level whose key is the same: count it as a miss
+			free_solution(sol);
+			__atomic_sub_fetch(&cache->hits, 1, __ATOMIC_RELAXED);
+			__atomic_add_fetch(&cache->misses, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	if (!solve_level(level, method, sol)) return false;
+	if (cache != NULL) cache_store(cache, key, sol);
+
+	return true;
+}
@@ -0,0 +1,198 @@
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "engine.h"
+#include "solver.h"
+
+#define CACHE_MAGIC "THSCACHE"		/* First bytes of a cache file */
+#define CACHE_VERSION 1			/* Bumped whenever the records or the level key change */
+#define CACHE_MAP_BYTES (64 << 20)	/* Address space reserved for the mapping (the largest cache file) */
+#define CACHE_MIN_SLOTS 4096		/* Smallest index (slots, a power of two) */
+
+#define NUM_SYMMETRIES 8		/* Mirror images, rotations and transposes of a board */
+#define CANONICAL_STACK_CELLS 4096	/* Boards up to this size are canonicalized without allocating */
+
+// Structure to hold the header at the start of a cache file
+struct cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t record_align;
+};
+
+/*
+ * Structure to hold one record of a cache file. The record is followed by the solution's
+ * moves (without the null byte) and padded to a multiple of 8 bytes. Records are only ever
+ * appended, and the checksum tells a complete record from one cut short by a crash.
+ */
+struct cache_record {
+	uint64_t key;			/* Key of the normalized level (see cache_key()) */
+	uint32_t checksum;		/* Checksum of the rest of the record and of the moves */
+	int32_t turns;			/* Optimal number of turns (0 if unsolvable) */
+	int32_t length;			/* Number of moves that follow */
+	uint8_t solvable;		/* Classification of the level: 1 if Theseus can escape */
+	uint8_t unused[3];
+};
+
+// Structure to hold one slot of a cache's in-memory index (a key of 0 marks an empty slot)
+struct cache_slot {
+	uint64_t key;
+	uint32_t offset;		/* Offset of the record in the file */
+};
+
+// Structure to hold a cache's in-memory index (open addressing, replaced by a larger copy when half full)
+struct cache_index {
+	size_t num_slots;		/* A power of two */
+	struct cache_index *retired;	/* Smaller index this one replaced (freed when the cache is closed) */
+	struct cache_slot slots[];
+};
+
+// Structure to hold an open result cache
+struct result_cache {
+	int fd;
+	const char *map;		/* Read-only shared mapping of the file (CACHE_MAP_BYTES long) */
+
+	struct cache_index *index;	/* Index from level keys to records (swapped in atomically) */
+	size_t num_keys;
+	size_t indexed_end;		/* End of the last record indexed (records other processes append later follow it) */
+
+	pthread_mutex_t write_lock;	/* Serializes the writers of this process (readers never lock) */
+	long hits;
+	long misses;
+};
+
+/**
+ * Compute the key of a level: a 64-bit hash of the level once normalized into its engine
+ * form (the board size, the valid moves of every square, the exit, the starting squares
+ * and the rules). Level files that only differ in layout, comments or the order of their
+ * walls get the same key.
+ *
+ * 'level' specifies the level.
+ *
+ * Return Value:
+ *	The function returns the key (never 0).
+ */
+uint64_t cache_key(const struct engine_level *level);
+
+/**
+ * Compute the canonical key of a level: a 64-bit hash that is the same for a level and all
+ * of its mirror images and rotations, for finding duplicate levels. The Minotaur's move
+ * order makes the symmetries that swap rows and columns (transposes and quarter turns)
+ * swap the horizontal-first and vertical-first rules too, so such an image only gets the
+ * same key as the level if its rules say the opposite; the mirror images and the half
+ * turn keep the rules as they are. The Minotaurs keep their order.
+ *
+ * The level is hashed as seen through each of the eight symmetries, with every square's
+ * valid moves, the exit and the starting squares mapped, and the smallest hash is taken.
+ * Unlike cache_key(), the key must not be used to look up solutions: the moves of a
+ * mirror image are mirrored.
+ *
+ * 'level' specifies the level.
+ *
+ * Return Value:
+ *	The function returns the key (never 0), or 0 if memory could not be allocated.
+ */
+uint64_t cache_canonical_key(const struct engine_level *level);
+
+/**
+ * Check whether a level is the same as another one, or a mirror image or a rotation of it,
+ * by mapping the first level through each of the eight symmetries (as cache_canonical_key()
+ * does) and comparing the image with the second level square by square. Levels with the
+ * same canonical key are almost always the same, but only this tells them apart for sure.
+ *
+ * 'level' specifies the level.
+ * 'other' specifies the other level.
+ *
+ * Return Values:
+ *	true - One of the images of 'level' is 'other'.
+ *	false - The levels are different.
+ */
+bool cache_same_level(const struct engine_level *level, const struct engine_level *other);
+
+/**
+ * Open a result cache file, creating it if it doesn't exist. The file is mapped into
+ * memory and its records are indexed by key; a record cut short at the end of the file
+ * (by a writer that crashed) is dropped.
+ *
+ * 'cache' specifies the result_cache structure to initialize.
+ * 'path' specifies the file path of the cache.
+ *
+ * Return Values:
+ *	true - The cache was opened.
+ *	false - The file could not be opened or created, or isn't a cache file.
+ */
+bool cache_open(struct result_cache *cache, const char *path);
+
+/**
+ * Close a result cache and free the memory held by it.
+ */
+void cache_close(struct result_cache *cache);
+
+/**
+ * Look up the solution of a level in a cache. Lookups of indexed levels take no lock, so
+ * any number of threads can look up levels while another thread stores results. A level
+ * that isn't indexed is looked for again after indexing the records other processes have
+ * appended to the file since (under a shared lock on the file).
+ *
+ * 'cache' specifies the cache.
+ * 'key' specifies the key of the level (see cache_key()).
+ * 'sol' receives the cached solution (free it with free_solution()). Only the fields that
+ *	are kept in the cache are set: the states, expanded and memory fields are zeroed.
+ *
+ * Return Values:
+ *	true - The level was found in the cache.
+ *	false - The level is not in the cache (or memory for the moves could not be allocated).
+ */
+bool cache_lookup(struct result_cache *cache, uint64_t key, struct solution *sol);
+
+/**
+ * Append the solution of a level to a cache. The record is written to the end of the file
+ * with one write while holding an exclusive lock on the file, so several processes can
+ * share one cache file. The records other processes have appended are indexed first, and
+ * the level isn't written again if one of them already holds it.
+ *
+ * 'cache' specifies the cache.
+ * 'key' specifies the key of the level (see cache_key()).
+ * 'sol' specifies the solution to store.
+ *
+ * Return Values:
+ *	true - The solution was stored (or was already in the cache).
+ *	false - The record could not be written, or the cache file is full.
+ */
+bool cache_store(struct result_cache *cache, uint64_t key, const struct solution *sol);
+
+/**
+ * Solve a level, looking the solution up in a cache first and storing it there if it
+ * has to be searched for. A failure to store the result is not reported. A cached way
+ * out is played through the engine before it is trusted: if it doesn't make Theseus
+ * escape (another level with the same key), the level is searched for as on a miss.
+ * A record that says the level is unsolvable is taken as it is.
+ *
+ * 'cache' specifies the cache (NULL to always search).
+ * 'level' specifies the level to solve.
+ * 'method' specifies the search method (see solve_level()).
+ * 'sol' receives the solution (free it with free_solution()).
+ * 'cached' receives whether the solution came from the cache.
+ *
+ * Return Values:
+ *	true - The level was solved.
+ *	false - Memory for the search could not be allocated.
+ */
+bool cache_solve(struct result_cache *cache, const struct engine_level *level, search_method method, struct solution *sol, bool *cached);
+
+#endif	    // _CACHE_H
@@ -0,0 +1,585 @@
+#include "editor.h"
+
+// Solve every version of the level handed to the solver, keeping the verdict of the latest one
+static void *solver_thread(void *arg) {
+	struct edit_solver *solver = arg;
+
+	pthread_mutex_lock(&solver->lock);
+	while (true) {
+		while (!solver->has_pending && !solver->stopping)
+			pthread_cond_wait(&solver->wake, &solver->lock);
+		if (solver->stopping) break;
+
+		// Take the version (the flag is only cleared here, so a newer version always calls this search off)
+		struct engine_level level = solver->pending;
+		unsigned long number = solver->posted;
+		solver->has_pending = false;
+		__atomic_store_n(&solver->cancel, 0, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&solver->lock);
+
+		struct solution sol;
+		level.cancel = &solver->cancel;
+		bool solved = solve_level(&level, SEARCH_ASTAR, &sol);
+		engine_free(&level);
+
+		// A search that was called off is only out of date: its verdict is left out
+		pthread_mutex_lock(&solver->lock);
+		if (number == solver->posted && !__atomic_load_n(&solver->cancel, __ATOMIC_RELAXED)) {
+			solver->solved = number;
+			solver->verdict = !solved ? EDIT_UNKNOWN : (sol.solvable ? EDIT_SOLVABLE : EDIT_UNSOLVABLE);
+			solver->turns = sol.turns;
+		}
+		free_solution(&sol);
+	}
+	pthread_mutex_unlock(&solver->lock);
+
+	return NULL;
+}
+
+/**
+ * Start the background solver of the editor.
+ *
+ * Return Values:
+ *	true - The solver is running.
+ *	false - The solver's thread or lock could not be set up.
+ */
+bool edit_solver_start(struct edit_solver *solver) {
+	solver->stopping = false;
+	solver->has_pending = false;
+	solver->cancel = 0;
+	solver->posted = 0;
+	solver->solved = 0;
+	solver->verdict = EDIT_SOLVING;
+	solver->turns = 0;
+
+	if (pthread_mutex_init(&solver->lock, NULL) != 0) return false;
+	if (pthread_cond_init(&solver->wake, NULL) != 0) {
+		pthread_mutex_destroy(&solver->lock);
+		return false;
+	}
+	if (pthread_create(&solver->thread, NULL, solver_thread, solver) != 0) {
+		pthread_cond_destroy(&solver->wake);
+		pthread_mutex_destroy(&solver->lock);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Stop the background solver of the editor (calling off any search in progress) and wait
+ * for its thread to finish.
+ */
+void edit_solver_stop(struct edit_solver *solver) {
+	pthread_mutex_lock(&solver->lock);
+	solver->stopping = true;
+	__atomic_store_n(&solver->cancel, 1, __ATOMIC_RELAXED);
+	pthread_cond_signal(&solver->wake);
+	pthread_mutex_unlock(&solver->lock);
+
+	pthread_join(solver->thread, NULL);
+	if (solver->has_pending) engine_free(&solver->pending);
+	solver->has_pending = false;
+
+	pthread_cond_destroy(&solver->wake);
+	pthread_mutex_destroy(&solver->lock);
+
+	return;
+}
+
+/**
+ * Hand a version of a level to the background solver. A version still waiting is replaced,
+ * and a search in progress is called off, since its verdict would be out of date.
+ *
+ * 'solver' specifies the solver.
+ * 'board' specifies the version of the level.
+ *
+ * Return Values:
+ *	true - The version was handed over.
+ *	false - Memory for the version could not be allocated.
+ */
+bool edit_solver_post(struct edit_solver *solver, const struct stats *board) {
+	struct engine_level level;
+	if (!engine_load(&level, board)) return false;
+
+	pthread_mutex_lock(&solver->lock);
+	if (solver->has_pending) engine_free(&solver->pending);
+	solver->pending = level;
+	solver->has_pending = true;
+	solver->posted++;
+	__atomic_store_n(&solver->cancel, 1, __ATOMIC_RELAXED);
+	pthread_cond_signal(&solver->wake);
+	pthread_mutex_unlock(&solver->lock);
+
+	return true;
+}
+
+/**
+ * Get the verdict on the latest version of the level handed to the background solver.
+ *
+ * 'solver' specifies the solver.
+ * 'verdict' receives the verdict (EDIT_SOLVING while the search goes on).
+ * 'turns' receives the turns needed to escape, if the level is solvable.
+ *
+ * Return Value:
+ *	The function returns the number of the version the verdict is for.
+ */
+unsigned long edit_solver_poll(struct edit_solver *solver, edit_verdict *verdict, int *turns) {
+	pthread_mutex_lock(&solver->lock);
+	unsigned long number = solver->posted;
+	*verdict = (solver->solved == number) ? solver->verdict : EDIT_SOLVING;
+	*turns = solver->turns;
+	pthread_mutex_unlock(&solver->lock);
+
+	return number;
+}
+
+/**
+ * Add the wall on one side of a square of a level, or take it away if there is one. A wall
+ * may be listed for either of the two squares it separates, so both are looked for. Only a
+ * wall between two squares of the board can be toggled: the edge of the board is always
+ * closed, except for the exit's side, which must stay open for the level to be escapable.
+ *
+ * 'board' specifies the level.
+ * 'row', 'col' specify the square.
+ * 'side' specifies the side of the square (LEFT, RIGHT, UP or DOWN).
+ *
+ * Error Codes:
+ *	0 - The wall was added or taken away.
+ *	1 - Memory for the wall could not be allocated.
+ *	2 - The side is the exit's.
+ *	3 - The side is on the edge of the board.
+ */
+int toggle_wall(struct stats *board, short row, short col, short side) {
+	short other_row = row + move_rows[side], other_col = col + move_cols[side];
+	short other_side = side ^ 1;		/* LEFT <-> RIGHT, UP <-> DOWN */
+	bool removed = false;
+	cell_rel **link = &board->walls;
+
+	if (row == board->exit.relation.row && col == board->exit.relation.col && side == board->exit.location) return 2;
+	if (other_row < 0 || other_row >= board->size.num_rows || other_col < 0 || other_col >= board->size.num_cols) return 3;
+
+	// Take the wall away, whichever square it was listed for (and however many times)
+	while (*link != NULL) {
+		cell_rel *wall = *link;
+
+		if ((wall->relation.row == row && wall->relation.col == col && wall->location == side)
+		    || (wall->relation.row == other_row && wall->relation.col == other_col && wall->location == other_side)) {
+			*link = wall->next;
+			free(wall);
+			removed = true;
+		}
+		else link = &wall->next;
+	}
+	if (removed) return 0;
+
+	// Otherwise add it at the end of the list, so that a saved level keeps the order of its walls
+	cell_rel *wall = malloc(sizeof(cell_rel));
+	if (wall == NULL) return 1;
+
+	wall->relation.row = row;
+	wall->relation.col = col;
+	wall->location = side;
+	wall->next = NULL;
+	*link = wall;
+
+	return 0;
+}
+
+// Draw (or erase) the cursor's marks on each side of the middle line of a square
+static void draw_cursor(WINDOW *win, bool shown) {
+	int max_y, max_x;
+	getmaxyx(win, max_y, max_x);
+
+	// With the ANSI backend, the marks go into the cell buffer in the colors of the square
+	if (render_backend == BACKEND_ANSI) {
+		int beg_y, beg_x;
+		short fg, bg;
+
+		getbegyx(win, beg_y, beg_x);
+		pair_content(PAIR_NUMBER(getbkgd(win)), &fg, &bg);
+		ansi_put(beg_y + (max_y / 2), beg_x + 1, shown ? ">" : " ", 1, fg, bg);
+		ansi_put(beg_y + (max_y / 2), beg_x + max_x - 2, shown ? "<" : " ", 1, fg, bg);
+
+		return;
+	}
+
+	mvwaddch(win, max_y / 2, 1, shown ? ('>' | A_BOLD) : ' ');
+	mvwaddch(win, max_y / 2, max_x - 2, shown ? ('<' | A_BOLD) : ' ');
+	wnoutrefresh(win);
+
+	return;
+}
+
+// Blank the place of a WINDOW that is going away (i.e the exit WINDOW, which is off the board's squares)
+static void erase_win(WINDOW *win) {
+	int beg_y, beg_x, max_y, max_x;
+
+	if (render_backend == BACKEND_ANSI) {
+		getbegyx(win, beg_y, beg_x);
+		getmaxyx(win, max_y, max_x);
+		ansi_fill(beg_y, beg_x, max_y, max_x, ANSI_DEFAULT);
+	}
+	else {
+		wbkgd(win, A_NORMAL);
+		werase(win);
+		wnoutrefresh(win);
+	}
+
+	return;
+}
+
+// Draw one square of the board again: its color, the walls listed for it, the characters starting on it and the cursor
+static void redraw_square(struct edit_session *session, int cell) {
+	const struct stats *board = session->board;
+	int ncols = board->size.num_cols;
+	short row = cell / ncols, col = cell % ncols;
+	WINDOW *win = session->wins[cell].win;
+	short win_pair = PAIR_NUMBER(getbkgd(win));
+
+	if (render_backend == BACKEND_ANSI) {
+		int beg_y, beg_x, max_y, max_x;
+		short fg, bg;
+
+		getbegyx(win, beg_y, beg_x);
+		getmaxyx(win, max_y, max_x);
+		pair_content(win_pair, &fg, &bg);
+		ansi_fill(beg_y, beg_x, max_y, max_x, bg);
+	}
+	else {
+		werase(win);
+		wnoutrefresh(win);
+	}
+
+	for(const cell_rel *wall = board->walls; wall != NULL; wall = wall->next)
+		if (wall->relation.row == row && wall->relation.col == col) draw_wall(win, wall->location);
+
+	if (board->theseus.row == row && board->theseus.col == col) win_draw_sprite(win, SPRITE_THESEUS, win_pair);
+	for(int i = 0; i < board->num_minotaurs; i++)
+		if (board->minotaurs[i].row == row && board->minotaurs[i].col == col) win_draw_sprite(win, SPRITE_MINOTAUR, win_pair);
+
+	if (cell == session->cursor) draw_cursor(win, true);
+
+	return;
+}
+
+// Draw the squares a change of the level touched again, and the exit in its new place if it moved
+static void redraw_cells(struct edit_session *session, const int *cells, int num_cells, bool exit_moved) {
+	const struct stats *board = session->board;
+
+	if (exit_moved) {
+		short row = board->exit.relation.row, col = board->exit.relation.col;
+
+		// The exit's square has the other color of the checkerboard (as in draw_board())
+		erase_win(session->exit_win);
+		delwin(session->exit_win);
+		session->exit_win = place_win(session->wins[(row * board->size.num_cols) + col].win, board->exit.location, HEIGHT, WIDTH);
+		win_draw_sprite(session->exit_win, SPRITE_EXIT, ((row ^ col) & 1) ? PAIR_1 : PAIR_2);
+	}
+
+	for(int i = 0; i < num_cells; i++)
+		redraw_square(session, cells[i]);
+
+	return;
+}
+
+// Print the editor's keys and status (the file, the solver's verdict and the last note) to the bar
+static void draw_bar(struct edit_session *session) {
+	char status[EDIT_NOTE_LENGTH + 512];
+	const char *verdict;
+	int width = getmaxx(session->bar);
+
+	switch (session->verdict) {
+		case EDIT_SOLVING:
+			verdict = "Solving...";
+			break;
+
+		case EDIT_SOLVABLE:
+			verdict = "Solvable in";
+			break;
+
+		case EDIT_UNSOLVABLE:
+			verdict = "Unsolvable";
+			break;
+
+		default:
+			verdict = "Could not be solved";
+	}
+
+	werase(session->bar);
+	if (session->board->num_minotaurs == 1)
+		mvwprintw(session->bar, 0, 1, "%.*s", width - 2, "EDIT  arrows: cursor  w+arrow: wall  x+arrow: exit  t: Theseus  1: Minotaur  s: save  e: play");
+	else mvwprintw(session->bar, 0, 1, "EDIT  arrows: cursor  w+arrow: wall  x+arrow: exit  t: Theseus  1-%hd: Minotaurs  s: save  e: play",
+		       session->board->num_minotaurs);
+
+	if (session->verdict == EDIT_SOLVABLE)
+		snprintf(status, sizeof(status), "%s%s: %s %d turns   %s", session->file_path, session->modified ? " (modified)" : "",
+			 verdict, session->turns, session->note);
+	else snprintf(status, sizeof(status), "%s%s: %s   %s", session->file_path, session->modified ? " (modified)" : "", verdict, session->note);
+	mvwaddnstr(session->bar, 1, 1, status, width - 2);
+
+	// ncurses can't see the ANSI backend drawing over the bar, so always send all of it
+	if (render_backend == BACKEND_ANSI) redrawwin(session->bar);
+	wnoutrefresh(session->bar);
+
+	return;
+}
+
+// Find the move for an arrow key (-1 for any other key)
+static int arrow_move(int key) {
+	switch (key) {
+		case KEY_LEFT:
+			return LEFT;
+
+		case KEY_RIGHT:
+			return RIGHT;
+
+		case KEY_UP:
+			return UP;
+
+		case KEY_DOWN:
+			return DOWN;
+	}
+
+	return -1;
+}
+
+// Whether a starting square is taken by Theseus or by a Minotaur other than 'minotaur' (-1 to check them all)
+static bool start_taken(const struct stats *board, short row, short col, int minotaur) {
+	if (minotaur >= 0 && board->theseus.row == row && board->theseus.col == col) return true;
+
+	for(int i = 0; i < board->num_minotaurs; i++)
+		if (i != minotaur && board->minotaurs[i].row == row && board->minotaurs[i].col == col) return true;
+
+	return false;
+}
+
+/*
+ * Carry out a key pressed in the editor: returns whether the level changed. 'cells' receives the
+ * squares the change touched (EDIT_MAX_CHANGED at most, their number in 'num_cells'), and
+ * 'exit_moved' is set if the exit moved.
+ */
+static bool edit_key(struct edit_session *session, int key, int *cells, int *num_cells, bool *exit_moved) {
+	struct stats *board = session->board;
+	int ncols = board->size.num_cols;
+	short row = session->cursor / ncols, col = session->cursor % ncols;
+	int move = arrow_move(key), mod_key = key | ('a' - 'A');
+	int command = session->command;
+
+	session->command = 0;
+	session->note[0] = '\0';
+	*num_cells = 0;
+	*exit_moved = false;
+
+	// An arrow key after 'w' or 'x' picks the side of the square
+	if (command != 0 && move >= 0) {
+		if (command == EDIT_WALL) {
+			switch (toggle_wall(board, row, col, move)) {
+				case 0:
+					cells[(*num_cells)++] = session->cursor;
+					cells[(*num_cells)++] = session->cursor + (move_rows[move] * ncols) + move_cols[move];
+					return true;
+
+				case 1:
+					snprintf(session->note, sizeof(session->note), "Out of memory");
+					break;
+
+				case 2:
+					snprintf(session->note, sizeof(session->note), "The exit is on that side (move it first)");
+					break;
+
+				default:
+					snprintf(session->note, sizeof(session->note), "The edge of the board is always a wall");
+			}
+
+			return false;
+		}
+
+		if ((move == LEFT && col != 0) || (move == RIGHT && col != ncols - 1)
+		    || (move == UP && row != 0) || (move == DOWN && row != board->size.num_rows - 1)) {
+			snprintf(session->note, sizeof(session->note), "The exit must be on the edge of the board");
+			return false;
+		}
+		cells[(*num_cells)++] = (board->exit.relation.row * ncols) + board->exit.relation.col;
+		cells[(*num_cells)++] = session->cursor;
+		board->exit.relation.row = row;
+		board->exit.relation.col = col;
+		board->exit.location = move;
+		*exit_moved = true;
+
+		return true;
+	}
+
+	// Move the cursor
+	if (move >= 0) {
+		short new_row = row + move_rows[move], new_col = col + move_cols[move];
+		if (new_row < 0 || new_row >= board->size.num_rows || new_col < 0 || new_col >= ncols) return false;
+
+		draw_cursor(session->wins[session->cursor].win, false);
+		session->cursor = (new_row * ncols) + new_col;
+		draw_cursor(session->wins[session->cursor].win, true);
+
+		return false;
+	}
+
+	if (mod_key == EDIT_WALL || mod_key == EDIT_EXIT) {
+		session->command = mod_key;
+		snprintf(session->note, sizeof(session->note), "Press an arrow key for the side of the %s", (mod_key == EDIT_WALL) ? "wall" : "exit");
+
+		return false;
+	}
+
+	if (mod_key == EDIT_THESEUS) {
+		if (start_taken(board, row, col, -1)) {
+			snprintf(session->note, sizeof(session->note), "A Minotaur starts there");
+			return false;
+		}
+		cells[(*num_cells)++] = (board->theseus.row * ncols) + board->theseus.col;
+		cells[(*num_cells)++] = session->cursor;
+		board->theseus.row = row;
+		board->theseus.col = col;
+
+		return true;
+	}
+
+	if (key >= '1' && key < '1' + board->num_minotaurs) {
+		if (start_taken(board, row, col, key - '1')) {
+			snprintf(session->note, sizeof(session->note), "Another character starts there");
+			return false;
+		}
+		cells[(*num_cells)++] = (board->minotaurs[key - '1'].row * ncols) + board->minotaurs[key - '1'].col;
+		cells[(*num_cells)++] = session->cursor;
+		board->minotaurs[key - '1'].row = row;
+		board->minotaurs[key - '1'].col = col;
+
+		return true;
+	}
+
+	if (mod_key == EDIT_SAVE) {
+		if (write_level_file(session->file_path, board) == 0) {
+			session->modified = false;
+			snprintf(session->note, sizeof(session->note), "Saved");
+		}
+		else snprintf(session->note, sizeof(session->note), "Could not save the level");
+	}
+
+	return false;
+}
+
+/**
+ * Edit a level on the board screen. A cursor ('>' and '<' on each side of a square) is moved
+ * with the arrow keys: 'w' followed by an arrow key adds or takes away the wall on that side
+ * of the square (see toggle_wall()), 'x' followed by an arrow key moves the exit to that side (which must be on
+ * the edge of the board), 't' moves Theseus' start to the square and '1' to '4' move that
+ * Minotaur's start there. 's' saves the level to its file (see write_level_file()), and the
+ * key defined by the global constant - 'EDIT' leaves the editor. After every change the level
+ * is handed to a background thread to be solved, and the status line shows "Solving..." until
+ * it tells whether the level is solvable and in how many turns. Keys are read all the while:
+ * a change made before the search ends calls the search off, and the new version is solved.
+ * Only the squares a change touches are drawn again (and the exit, if it moved).
+ *
+ * 'file_path' specifies the file path the level is saved to.
+ * 'board' specifies the level, with the characters on their starting squares (edited in place).
+ *
+ * Return Values:
+ *	0 - The user left the editor.
+ *	1 - Memory for the board could not be allocated.
+ */
+int edit_level(const char *file_path, struct stats *board) {
+	struct edit_session session;
+	short theseus_win_pair, minotaur_win_pairs[MAX_MINOTAURS];
+	int num_squares = board->size.num_rows * board->size.num_cols;
+	int key;
+
+	session.file_path = file_path;
+	session.board = board;
+	session.wins = malloc(sizeof(board_square) * num_squares);
+	session.bar = newwin(EDIT_BAR_HEIGHT, COLS, LINES - EDIT_BAR_HEIGHT, 0);
+	if (session.wins == NULL || session.bar == NULL) {
+		free(session.wins);
+		if (session.bar != NULL) delwin(session.bar);
+		return 1;
+	}
+	keypad(session.bar, TRUE);
+
+	session.cursor = (board->theseus.row * board->size.num_cols) + board->theseus.col;
+	session.command = 0;
+	session.modified = false;
+	session.shown = 0;
+	session.verdict = EDIT_SOLVING;
+	session.turns = 0;
+	session.note[0] = '\0';
+
+	// Solve the level as it is to begin with
+	session.solving = edit_solver_start(&session.solver);
+	if (session.solving && !edit_solver_post(&session.solver, board)) {
+		edit_solver_stop(&session.solver);
+		session.solving = false;
+	}
+	if (!session.solving) session.verdict = EDIT_UNKNOWN;
+
+	session.exit_win = draw_board(board, session.wins, &theseus_win_pair, minotaur_win_pairs);
+	draw_cursor(session.wins[session.cursor].win, true);
+	draw_bar(&session);
+	flush_frame();
+
+	while (true) {
+
+		// Until the solver has a verdict on the latest version, wake up now and then to show it
+		wtimeout(session.bar, (session.verdict == EDIT_SOLVING) ? EDIT_POLL_MS : -1);
+		key = wgetch(session.bar);
+
+		// Keep the board in the middle of a resized terminal, and the bar along its bottom
+		if (key == KEY_RESIZE) {
+			fit_board(board, session.wins, &session.exit_win, &theseus_win_pair, minotaur_win_pairs);
+			draw_cursor(session.wins[session.cursor].win, true);
+
+			wresize(session.bar, EDIT_BAR_HEIGHT, COLS);
+			mvwin(session.bar, LINES - EDIT_BAR_HEIGHT, 0);
+		}
+		else if (key != ERR) {
+			int cells[EDIT_MAX_CHANGED], num_cells;
+			bool exit_moved;
+			if ((key | ('a' - 'A')) == EDIT) break;
+
+			// Draw the changed squares and hand the level to the solver (calling off the search of the last version)
+			if (edit_key(&session, key, cells, &num_cells, &exit_moved)) {
+				session.modified = true;
+				redraw_cells(&session, cells, num_cells, exit_moved);
+
+				if (session.solving && edit_solver_post(&session.solver, board)) session.verdict = EDIT_SOLVING;
+				else session.verdict = EDIT_UNKNOWN;
+			}
+		}
+
+		if (session.solving) {
+			edit_verdict verdict;
+			int turns;
+			unsigned long number = edit_solver_poll(&session.solver, &verdict, &turns);
+
+			if (verdict != EDIT_SOLVING && number != session.shown) {
+				session.shown = number;
+				session.verdict = verdict;
+				session.turns = turns;
+			}
+		}
+
+		draw_bar(&session);
+		flush_frame();
+	}
+	wtimeout(session.bar, -1);
+	if (session.solving) edit_solver_stop(&session.solver);
+
+	// Take the editor off the screen (the caller draws the board again)
+	werase(session.bar);
+	wnoutrefresh(session.bar);
+	delwin(session.bar);
+
+	for(int i = 0; i < num_squares; i++)
+		delwin(session.wins[i].win);
+	free(session.wins);
+	delwin(session.exit_win);
+	flush_frame();
+
+	return 0;
+}
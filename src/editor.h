@@ -0,0 +1,148 @@
+#ifndef _EDITOR_H
+#define _EDITOR_H
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#include <pthread.h>
+
+#include "game.h"
+#include "solver.h"
+
+#define EDIT_WALL 'w'		/* Command key to toggle a wall (followed by an arrow key for the side) */
+#define EDIT_EXIT 'x'		/* Command key to move the exit (followed by an arrow key for the side) */
+#define EDIT_THESEUS 't'	/* Command key to move Theseus' start to the cursor */
+#define EDIT_SAVE 's'		/* Command key to save the level to its file */
+				/* Keys '1' to '4' move that Minotaur's start to the cursor */
+
+#define EDIT_POLL_MS 30		/* How often the editor checks for the background solver's result */
+#define EDIT_BAR_HEIGHT 2	/* Lines at the bottom of the screen for the editor's keys and status */
+#define EDIT_NOTE_LENGTH 64	/* Longest note shown on the status line */
+#define EDIT_MAX_CHANGED 2	/* Squares one change of the level can touch (a wall's two sides, or a start's old and new square) */
+
+// Enumerated values representing what is known about the level being edited
+typedef enum {
+	EDIT_SOLVING,		/* The latest version of the level is still being solved */
+	EDIT_SOLVABLE,
+	EDIT_UNSOLVABLE,
+	EDIT_UNKNOWN		/* The level could not be solved (out of memory) */
+}
+edit_verdict;
+
+// Structure to hold the background solver of the editor: one thread solving the latest version of the level
+struct edit_solver {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;		/* Signalled when a version is handed over or the solver stops */
+	bool stopping;
+
+	struct engine_level pending;	/* Version waiting to be solved (owned by the solver) */
+	bool has_pending;
+	int cancel;			/* Set to call off the search in progress (see 'cancel' in engine_level) */
+
+	unsigned long posted;		/* Number of the latest version handed over */
+	unsigned long solved;		/* Number of the version the verdict is for */
+	edit_verdict verdict;
+	int turns;
+};
+
+// Structure to hold an editing session of a level on the board screen
+struct edit_session {
+	const char *file_path;
+	struct stats *board;
+
+	board_square *wins;
+	WINDOW *exit_win;
+	WINDOW *bar;			/* The editor's keys and status, at the bottom of the screen */
+	int cursor;			/* Cell of the square being edited */
+	int command;			/* EDIT_WALL or EDIT_EXIT while waiting for a side, else 0 */
+	bool modified;			/* The level has changed since it was last saved */
+
+	struct edit_solver solver;
+	bool solving;			/* The background solver is running */
+	unsigned long shown;		/* Number of the version whose verdict is shown */
+	edit_verdict verdict;
+	int turns;
+	char note[EDIT_NOTE_LENGTH];	/* Outcome of the last command */
+};
+
+/**
+ * Edit a level on the board screen. A cursor ('>' and '<' on each side of a square) is moved
+ * with the arrow keys: 'w' followed by an arrow key adds or takes away the wall on that side
+ * of the square (see toggle_wall()), 'x' followed by an arrow key moves the exit to that side (which must be on
+ * the edge of the board), 't' moves Theseus' start to the square and '1' to '4' move that
+ * Minotaur's start there. 's' saves the level to its file (see write_level_file()), and the
+ * key defined by the global constant - 'EDIT' leaves the editor. After every change the level
+ * is handed to a background thread to be solved, and the status line shows "Solving..." until
+ * it tells whether the level is solvable and in how many turns. Keys are read all the while:
+ * a change made before the search ends calls the search off, and the new version is solved.
+ * Only the squares a change touches are drawn again (and the exit, if it moved).
+ *
+ * 'file_path' specifies the file path the level is saved to.
+ * 'board' specifies the level, with the characters on their starting squares (edited in place).
+ *
+ * Return Values:
+ *	0 - The user left the editor.
+ *	1 - Memory for the board could not be allocated.
+ */
+int edit_level(const char *file_path, struct stats *board);
+
+/**
+ * Add the wall on one side of a square of a level, or take it away if there is one. A wall
+ * may be listed for either of the two squares it separates, so both are looked for. Only a
+ * wall between two squares of the board can be toggled: the edge of the board is always
+ * closed, except for the exit's side, which must stay open for the level to be escapable.
+ *
+ * 'board' specifies the level.
+ * 'row', 'col' specify the square.
+ * 'side' specifies the side of the square (LEFT, RIGHT, UP or DOWN).
+ *
+ * Error Codes:
+ *	0 - The wall was added or taken away.
+ *	1 - Memory for the wall could not be allocated.
+ *	2 - The side is the exit's.
+ *	3 - The side is on the edge of the board.
+ */
+int toggle_wall(struct stats *board, short row, short col, short side);
+
+/**
+ * Start the background solver of the editor.
+ *
+ * Return Values:
+ *	true - The solver is running.
+ *	false - The solver's thread or lock could not be set up.
+ */
+bool edit_solver_start(struct edit_solver *solver);
+
+/**
+ * Stop the background solver of the editor (calling off any search in progress) and wait
+ * for its thread to finish.
+ */
+void edit_solver_stop(struct edit_solver *solver);
+
+/**
+ * Hand a version of a level to the background solver. A version still waiting is replaced,
+ * and a search in progress is called off, since its verdict would be out of date.
+ *
+ * 'solver' specifies the solver.
+ * 'board' specifies the version of the level.
+ *
+ * Return Values:
+ *	true - The version was handed over.
+ *	false - Memory for the version could not be allocated.
+ */
+bool edit_solver_post(struct edit_solver *solver, const struct stats *board);
+
+/**
+ * Get the verdict on the latest version of the level handed to the background solver.
+ *
+ * 'solver' specifies the solver.
+ * 'verdict' receives the verdict (EDIT_SOLVING while the search goes on).
+ * 'turns' receives the turns needed to escape, if the level is solvable.
+ *
+ * Return Value:
+ *	The function returns the number of the version the verdict is for.
+ */
+unsigned long edit_solver_poll(struct edit_solver *solver, edit_verdict *verdict, int *turns);
+
+#endif	    // _EDITOR_H
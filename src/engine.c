@@ -0,0 +1,325 @@
+#include "engine.h"
+#include "kernels.h"
+
+// An array of numbers with which to build and manipulate bit_masks for valid moves on the board
+const short moves[NUM_MOVES] = {1, 2, 4, 8};
+
+// Changes of row and column for each move, and NO_MOVE last
+const short move_rows[NUM_MOVES + 1] = {0, 0, -1, 1, 0};
+const short move_cols[NUM_MOVES + 1] = {-1, 1, 0, 0, 0};
+
+/*
+ * The table of the Minotaur's steps (see engine.h), built by the preprocessor. 'DX' and 'DY'
+ * are the signs of Theseus' column and row minus the Minotaur's: he only moves toward
+ * Theseus, horizontally before vertically (or the other way around), through open sides.
+ */
+#define HORIZONTAL_STEP(MASK, DX) ((DX) < 0 && ((MASK) & 1) ? LEFT : (DX) > 0 && ((MASK) & 2) ? RIGHT : NO_MOVE)
+#define VERTICAL_STEP(MASK, DY) ((DY) < 0 && ((MASK) & 4) ? UP : (DY) > 0 && ((MASK) & 8) ? DOWN : NO_MOVE)
+#define CHOICE(VFIRST, MASK, DX, DY) \
+	((VFIRST) ? (VERTICAL_STEP(MASK, DY) != NO_MOVE ? VERTICAL_STEP(MASK, DY) : HORIZONTAL_STEP(MASK, DX)) \
+		  : (HORIZONTAL_STEP(MASK, DX) != NO_MOVE ? HORIZONTAL_STEP(MASK, DX) : VERTICAL_STEP(MASK, DY)))
+#define CHOICE_ROW(VFIRST, MASK, DX) {CHOICE(VFIRST, MASK, DX, -1), CHOICE(VFIRST, MASK, DX, 0), CHOICE(VFIRST, MASK, DX, 1)}
+#define CHOICE_MASK(VFIRST, MASK) {CHOICE_ROW(VFIRST, MASK, -1), CHOICE_ROW(VFIRST, MASK, 0), CHOICE_ROW(VFIRST, MASK, 1)}
+#define CHOICE_TABLE(VFIRST) { \
+	CHOICE_MASK(VFIRST, 0), CHOICE_MASK(VFIRST, 1), CHOICE_MASK(VFIRST, 2), CHOICE_MASK(VFIRST, 3), \
+	CHOICE_MASK(VFIRST, 4), CHOICE_MASK(VFIRST, 5), CHOICE_MASK(VFIRST, 6), CHOICE_MASK(VFIRST, 7), \
+	CHOICE_MASK(VFIRST, 8), CHOICE_MASK(VFIRST, 9), CHOICE_MASK(VFIRST, 10), CHOICE_MASK(VFIRST, 11), \
+	CHOICE_MASK(VFIRST, 12), CHOICE_MASK(VFIRST, 13), CHOICE_MASK(VFIRST, 14), CHOICE_MASK(VFIRST, 15)}
+
+const unsigned char minotaur_choices[2][MOVE_MASK_BITS + 1][3][3] = {CHOICE_TABLE(0), CHOICE_TABLE(1)};
+
+#undef CHOICE_TABLE
+#undef CHOICE_MASK
+#undef CHOICE_ROW
+#undef CHOICE
+#undef VERTICAL_STEP
+#undef HORIZONTAL_STEP
+
+/**
+ * Compute the bit-mask of valid moves for every square of a board. Moves that go off
+ * the board are turned off, as well as moves through walls (on both sides of each wall).
+ * The move through the exit is turned back on for the exit square.
+ *
+ * 'board' specifies the stats structure that holds the board information.
+ * 'masks' specifies an array with one element per square in which to store the bit-masks.
+ */
+void compute_move_masks(const struct stats *board, unsigned char *masks) {
+	int nrows = board->size.num_rows, ncols = board->size.num_cols;
+
+	// Start with every move valid, then turn off moves that go off the board
+	for(int i = 0; i < nrows; i++) {
+		for(int j = 0; j < ncols; j++) {
+			unsigned char mask = (moves[LEFT] | moves[RIGHT] | moves[UP] | moves[DOWN]);
+
+			if (j == 0) mask &= ~(moves[LEFT]);
+			if (j == (ncols - 1)) mask &= ~(moves[RIGHT]);
+			if (i == 0) mask &= ~(moves[UP]);
+			if (i == (nrows - 1)) mask &= ~(moves[DOWN]);
+
+			masks[(i * ncols) + j] = mask;
+		}
+	}
+
+	// Loop through linked-list of walls and turn off moves through walls on both sides of each wall
+	for(cell_rel *temp = board->walls; temp != NULL; temp = temp->next) {
+		int pos = (temp->relation.row * ncols) + temp->relation.col;
+		masks[pos] &= ~(moves[temp->location]);
+
+		switch (temp->location) {
+			case LEFT:
+				if (temp->relation.col > 0)
+					masks[pos - 1] &= ~(moves[RIGHT]);
+				break;
+
+			case RIGHT:
+				if (temp->relation.col < (ncols - 1))
+					masks[pos + 1] &= ~(moves[LEFT]);
+				break;
+
+			case UP:
+				if (temp->relation.row > 0)
+					masks[pos - ncols] &= ~(moves[DOWN]);
+				break;
+
+			case DOWN:
+				if (temp->relation.row < (nrows - 1))
+					masks[pos + ncols] &= ~(moves[UP]);
+				break;
+		}
+	}
+	masks[(board->exit.relation.row * ncols) + board->exit.relation.col] |= moves[board->exit.location];
+
+	return;
+}
+
+/**
+ * Find the index of a rule variant. Every rule variant has its own specialized copy
+ * of the batch stepper and the solver, picked with this index.
+ *
+ * 'rules' specifies the rule variant.
+ *
+ * Return Value:
+ *	The function returns a number from 0 to NUM_RULE_VARIANTS - 1.
+ */
+int rules_variant(const struct rules *rules) {
+	return ((((rules->minotaur_steps - 1) * 2) + rules->vertical_first) * MAX_THESEUS_STEPS) + (rules->theseus_steps - 1);
+}
+
+/**
+ * Build an engine_level structure from the board information in a stats structure.
+ * The engine_level does not refer back to the stats structure once built.
+ *
+ * 'level' specifies the engine_level structure to initialize.
+ * 'board' specifies the stats structure that holds the board information.
+ *
+ * Return Values:
+ *	true - The level was built.
+ *	false - Memory for the level could not be allocated.
+ */
+bool engine_load(struct engine_level *level, const struct stats *board) {
+	return engine_load_masks(level, board, NULL);
+}
+
+/**
+ * Build an engine_level structure like engine_load(), with the bit-masks of valid moves
+ * already computed (i.e by the level pack compiled into the game, see levelpack.h). The
+ * walls of the stats structure are then not looked at.
+ *
+ * 'level' specifies the engine_level structure to initialize.
+ * 'board' specifies the stats structure that holds the board information.
+ * 'masks' specifies the bit-mask of each square (see compute_move_masks()), or NULL to
+ * compute them from the walls.
+ *
+ * Return Values:
+ *	true - The level was built.
+ *	false - Memory for the level could not be allocated.
+ */
+bool engine_load_masks(struct engine_level *level, const struct stats *board, const unsigned char *masks) {
+	level->num_rows = board->size.num_rows;
+	level->num_cols = board->size.num_cols;
+	level->num_cells = level->num_rows * level->num_cols;
+
+	level->masks = malloc(sizeof(unsigned char) * level->num_cells);
+	level->cell_rows = malloc(sizeof(unsigned short) * level->num_cells * 2);
+	if (level->masks == NULL || level->cell_rows == NULL) {
+		engine_free(level);
+		return false;
+	}
+	if (masks != NULL) memcpy(level->masks, masks, sizeof(unsigned char) * level->num_cells);
+	else compute_move_masks(board, level->masks);
+
+	level->cell_cols = level->cell_rows + level->num_cells;
+	for(int cell = 0; cell < level->num_cells; cell++) {
+		level->cell_rows[cell] = cell / level->num_cols;
+		level->cell_cols[cell] = cell % level->num_cols;
+	}
+	for(int move = 0; move <= NO_MOVE; move++)
+		level->step_offsets[move] = (move_rows[move] * level->num_cols) + move_cols[move];
+
+	level->exit_cell = (board->exit.relation.row * level->num_cols) + board->exit.relation.col;
+	level->exit_dir = board->exit.location;
+
+	level->theseus_start = (board->theseus.row * level->num_cols) + board->theseus.col;
+	level->num_minotaurs = board->num_minotaurs;
+	for(int i = 0; i < board->num_minotaurs; i++)
+		level->minotaur_starts[i] = (board->minotaurs[i].row * level->num_cols) + board->minotaurs[i].col;
+
+	level->rules = board->rules;
+	level->variant = rules_variant(&board->rules);
+	level->cancel = NULL;
+
+	return true;
+}
+
+/**
+ * Free the memory held by an engine_level structure.
+ */
+void engine_free(struct engine_level *level) {
+	free(level->masks);
+	free(level->cell_rows);		/* The columns are in the same block */
+	level->masks = NULL;
+	level->cell_rows = level->cell_cols = NULL;
+
+	return;
+}
+
+/**
+ * Put the characters of a game back on their starting squares.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the engine_state structure to reset.
+ */
+void engine_reset(const struct engine_level *level, struct engine_state *state) {
+	state->theseus = level->theseus_start;
+	for(int i = 0; i < level->num_minotaurs; i++)
+		state->minotaurs[i] = level->minotaur_starts[i];
+	state->actions = 0;
+
+	return;
+}
+
+/**
+ * Move Theseus one square in a given direction, following the same rules as the
+ * move_theseus() function, without drawing anything.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the positions of the characters (updated in place).
+ * 'move' is the direction which to move Theseus on the board.
+ *
+ * Return Values:
+ *	ENGINE_BLOCKED - The move is invalid for the current square.
+ *	ENGINE_MOVED - A move was made to an ordinary square on the board.
+ *	ENGINE_ESCAPED - Theseus moved through the exit.
+ *	ENGINE_CAUGHT - Theseus moved onto a Minotaur's square.
+ */
+engine_result engine_move_theseus(const struct engine_level *level, struct engine_state *state, short move) {
+	if (move < 0 || move >= NUM_MOVES) return ENGINE_BLOCKED;
+
+	int next = theseus_step(level, state->theseus, move);
+	if (next == THESEUS_BLOCKED) return ENGINE_BLOCKED;
+	if (next == THESEUS_ESCAPED) return ENGINE_ESCAPED;
+
+	state->theseus = next;
+
+	return on_minotaur(state->minotaurs, level->num_minotaurs, next) ? ENGINE_CAUGHT : ENGINE_MOVED;
+}
+
+/**
+ * Make one step for one of the Minotaurs, following the same rules as the move_minotaur()
+ * function, without drawing anything. The Minotaur only moves toward Theseus, and
+ * tries horizontal moves before vertical moves (or the other way around if the
+ * level's rules say so). He never steps onto another Minotaur's square.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the positions of the characters (updated in place).
+ * 'index' specifies which Minotaur to move (in level order).
+ *
+ * Return Values:
+ *	ENGINE_BLOCKED - No move was made.
+ *	ENGINE_MOVED - A move was made, but Theseus was not caught.
+ *	ENGINE_CAUGHT - A move was made and Theseus has been caught.
+ */
+engine_result engine_move_minotaur(const struct engine_level *level, struct engine_state *state, int index) {
+	unsigned char mask = minotaur_free_moves(level, state->minotaurs, level->num_minotaurs, index);
+	int next = minotaur_step_masked(level, state->theseus, state->minotaurs[index], mask, level->rules.vertical_first);
+	if (next == state->minotaurs[index]) return ENGINE_BLOCKED;
+
+	state->minotaurs[index] = next;
+
+	return (next == state->theseus) ? ENGINE_CAUGHT : ENGINE_MOVED;
+}
+
+// Play one move of Theseus for a given rule variant (the variant arguments are constants where inlined)
+KERNEL_INLINE engine_result turn_kernel(const struct engine_level *level, struct engine_state *state, short move,
+					int minotaur_steps, bool vertical_first, int theseus_steps) {
+	int theseus = theseus_step(level, state->theseus, move);
+
+	if (theseus == THESEUS_BLOCKED) return ENGINE_BLOCKED;
+	if (theseus == THESEUS_ESCAPED) return ENGINE_ESCAPED;
+
+	state->theseus = theseus;
+	if (on_minotaur(state->minotaurs, level->num_minotaurs, theseus)) return ENGINE_CAUGHT;
+
+	// The Minotaur only moves once Theseus has made all of his moves for the turn
+	if (theseus_steps > 1 && ++state->actions < theseus_steps) return ENGINE_MOVED;
+	state->actions = 0;
+
+	bool caught = minotaurs_turn(level, theseus, state->minotaurs, level->num_minotaurs, minotaur_steps, vertical_first);
+
+	return caught ? ENGINE_CAUGHT : ENGINE_MOVED;
+}
+
+// One specialized copy of the batch stepper per rule variant
+#define DEFINE_STEP_BATCH(NAME, MSTEPS, VFIRST, TSTEPS) \
+	static void step_batch_##NAME(const struct engine_level *level, struct engine_state *states, \
+				      const short *move_list, engine_result *results, long count) { \
+		for(long i = 0; i < count; i++) \
+			results[i] = turn_kernel(level, &states[i], move_list[i], MSTEPS, VFIRST, TSTEPS); \
+	}
+RULE_VARIANTS(DEFINE_STEP_BATCH)
+
+/**
+ * Play one move of Theseus (or skip it with SKIP_MOVE). Once Theseus has made all of
+ * his moves for the turn (one with the original rules), each Minotaur takes all of his
+ * steps, one Minotaur after the other. An invalid move for Theseus leaves the state
+ * untouched.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the positions of the characters (updated in place).
+ * 'move' is the direction which to move Theseus, or SKIP_MOVE.
+ *
+ * Return Values:
+ *	ENGINE_BLOCKED - The move is invalid, nothing changed.
+ *	ENGINE_MOVED - The move was played and the game goes on.
+ *	ENGINE_ESCAPED - Theseus escaped through the exit.
+ *	ENGINE_CAUGHT - Theseus was caught by a Minotaur.
+ */
+engine_result engine_turn(const struct engine_level *level, struct engine_state *state, short move) {
+	if (move < 0 || move > SKIP_MOVE) return ENGINE_BLOCKED;
+
+	return turn_kernel(level, state, move, level->rules.minotaur_steps, level->rules.vertical_first, level->rules.theseus_steps);
+}
+
+/**
+ * Play one move (as with engine_turn()) in each of a batch of games of the same level.
+ * The copy of the stepper specialized for the level's rule variant is picked once for
+ * the whole batch. Games that are already over must not be stepped again.
+ *
+ * 'level' specifies the level being played by every game.
+ * 'states' specifies the states of the games (updated in place).
+ * 'move_list' specifies the move for each game (a direction or SKIP_MOVE).
+ * 'results' receives the result of the move for each game.
+ * 'count' specifies the number of games.
+ */
+void engine_step_batch(const struct engine_level *level, struct engine_state *states, const short *move_list, engine_result *results, long count) {
+	switch (level->variant) {
+#define STEP_BATCH_CASE(NAME, MSTEPS, VFIRST, TSTEPS) \
+		case (((MSTEPS - 1) * 2 + VFIRST) * MAX_THESEUS_STEPS) + (TSTEPS - 1): \
+			step_batch_##NAME(level, states, move_list, results, count); \
+			break;
+		RULE_VARIANTS(STEP_BATCH_CASE)
+#undef STEP_BATCH_CASE
+	}
+
+	return;
+}
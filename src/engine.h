@@ -0,0 +1,208 @@
+#ifndef _ENGINE_H
+#define _ENGINE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "loader.h"
+
+#define NUM_MOVES 4
+#define SKIP_MOVE NUM_MOVES	/* Move value for skipping Theseus' turn */
+#define NO_MOVE NUM_MOVES	/* Step of the Minotaur table for staying put */
+#define MOVE_MASK_BITS ((1 << NUM_MOVES) - 1)
+
+#define NUM_RULE_VARIANTS (MAX_MINOTAUR_STEPS * 2 * MAX_THESEUS_STEPS)
+
+// Enumerated values representing moves on a board
+typedef enum {
+	LEFT,
+	RIGHT,
+	UP,
+	DOWN
+}
+moves_t;
+
+// Enumerated values representing the outcome of a move in the engine
+typedef enum {
+	ENGINE_BLOCKED,		/* The move was invalid, nothing changed */
+	ENGINE_MOVED,		/* The move was made and the game goes on */
+	ENGINE_ESCAPED,		/* Theseus reached the exit */
+	ENGINE_CAUGHT		/* A Minotaur caught Theseus */
+}
+engine_result;
+
+// An array of numbers with which to build and manipulate bit_masks for valid moves on the board
+extern const short moves[];
+
+/*
+ * The Minotaur's step for every case, indexed by [vertical first][bit-mask of the moves he can
+ * make][sign of Theseus' column minus his, plus 1][sign of Theseus' row minus his, plus 1]: the
+ * move he makes (LEFT to DOWN), or NO_MOVE if he stays put. Both the game and the engine step
+ * the Minotaur with this table, so there is no branching on the direction.
+ */
+extern const unsigned char minotaur_choices[2][MOVE_MASK_BITS + 1][3][3];
+
+// Changes of row and column for each move, and NO_MOVE last
+extern const short move_rows[NUM_MOVES + 1];
+extern const short move_cols[NUM_MOVES + 1];
+
+// Structure to hold a level for the render-free engine (read-only once built)
+struct engine_level {
+	short num_rows;
+	short num_cols;
+	int num_cells;
+
+	unsigned char *masks;		/* Bit-mask of valid moves for each cell (see 'moves') */
+	unsigned short *cell_rows;	/* Row of each cell (so that no step divides by the number of columns) */
+	unsigned short *cell_cols;	/* Column of each cell (in the same block as 'cell_rows') */
+	int step_offsets[NUM_MOVES + 1];	/* Change of cell index for each move, and NO_MOVE last */
+
+	int exit_cell;
+	short exit_dir;
+
+	int theseus_start;
+	int minotaur_starts[MAX_MINOTAURS];	/* In the order the Minotaurs move */
+	short num_minotaurs;
+
+	struct rules rules;
+	int variant;			/* Index of the rule variant (see rules_variant()) */
+
+	const int *cancel;		/* Flag set by another thread to make the solver give up (NULL for none) */
+};
+
+// Structure to hold the positions of the characters in a game (cell indexes)
+struct engine_state {
+	int theseus;
+	int minotaurs[MAX_MINOTAURS];	/* Only the level's first 'num_minotaurs' are used */
+	short actions;			/* Moves Theseus has made so far in the current turn */
+};
+
+/**
+ * Compute the bit-mask of valid moves for every square of a board. Moves that go off
+ * the board are turned off, as well as moves through walls (on both sides of each wall).
+ * The move through the exit is turned back on for the exit square.
+ *
+ * 'board' specifies the stats structure that holds the board information.
+ * 'masks' specifies an array with one element per square in which to store the bit-masks.
+ */
+void compute_move_masks(const struct stats *board, unsigned char *masks);
+
+/**
+ * Find the index of a rule variant. Every rule variant has its own specialized copy
+ * of the batch stepper and the solver, picked with this index.
+ *
+ * 'rules' specifies the rule variant.
+ *
+ * Return Value:
+ *	The function returns a number from 0 to NUM_RULE_VARIANTS - 1.
+ */
+int rules_variant(const struct rules *rules);
+
+/**
+ * Build an engine_level structure from the board information in a stats structure.
+ * The engine_level does not refer back to the stats structure once built.
+ *
+ * 'level' specifies the engine_level structure to initialize.
+ * 'board' specifies the stats structure that holds the board information.
+ *
+ * Return Values:
+ *	true - The level was built.
+ *	false - Memory for the level could not be allocated.
+ */
+bool engine_load(struct engine_level *level, const struct stats *board);
+
+/**
+ * Build an engine_level structure like engine_load(), with the bit-masks of valid moves
+ * already computed (i.e by the level pack compiled into the game, see levelpack.h). The
+ * walls of the stats structure are then not looked at.
+ *
+ * 'level' specifies the engine_level structure to initialize.
+ * 'board' specifies the stats structure that holds the board information.
+ * 'masks' specifies the bit-mask of each square (see compute_move_masks()), or NULL to
+ * compute them from the walls.
+ *
+ * Return Values:
+ *	true - The level was built.
+ *	false - Memory for the level could not be allocated.
+ */
+bool engine_load_masks(struct engine_level *level, const struct stats *board, const unsigned char *masks);
+
+/**
+ * Free the memory held by an engine_level structure.
+ */
+void engine_free(struct engine_level *level);
+
+/**
+ * Put the characters of a game back on their starting squares.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the engine_state structure to reset.
+ */
+void engine_reset(const struct engine_level *level, struct engine_state *state);
+
+/**
+ * Move Theseus one square in a given direction, following the same rules as the
+ * move_theseus() function, without drawing anything.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the positions of the characters (updated in place).
+ * 'move' is the direction which to move Theseus on the board.
+ *
+ * Return Values:
+ *	ENGINE_BLOCKED - The move is invalid for the current square.
+ *	ENGINE_MOVED - A move was made to an ordinary square on the board.
+ *	ENGINE_ESCAPED - Theseus moved through the exit.
+ *	ENGINE_CAUGHT - Theseus moved onto a Minotaur's square.
+ */
+engine_result engine_move_theseus(const struct engine_level *level, struct engine_state *state, short move);
+
+/**
+ * Make one step for one of the Minotaurs, following the same rules as the move_minotaur()
+ * function, without drawing anything. The Minotaur only moves toward Theseus, and
+ * tries horizontal moves before vertical moves (or the other way around if the
+ * level's rules say so). He never steps onto another Minotaur's square.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the positions of the characters (updated in place).
+ * 'index' specifies which Minotaur to move (in level order).
+ *
+ * Return Values:
+ *	ENGINE_BLOCKED - No move was made.
+ *	ENGINE_MOVED - A move was made, but Theseus was not caught.
+ *	ENGINE_CAUGHT - A move was made and Theseus has been caught.
+ */
+engine_result engine_move_minotaur(const struct engine_level *level, struct engine_state *state, int index);
+
+/**
+ * Play one move of Theseus (or skip it with SKIP_MOVE). Once Theseus has made all of
+ * his moves for the turn (one with the original rules), each Minotaur takes all of his
+ * steps, one Minotaur after the other. An invalid move for Theseus leaves the state
+ * untouched.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the positions of the characters (updated in place).
+ * 'move' is the direction which to move Theseus, or SKIP_MOVE.
+ *
+ * Return Values:
+ *	ENGINE_BLOCKED - The move is invalid, nothing changed.
+ *	ENGINE_MOVED - The move was played and the game goes on.
+ *	ENGINE_ESCAPED - Theseus escaped through the exit.
+ *	ENGINE_CAUGHT - Theseus was caught by a Minotaur.
+ */
+engine_result engine_turn(const struct engine_level *level, struct engine_state *state, short move);
+
+/**
+ * Play one move (as with engine_turn()) in each of a batch of games of the same level.
+ * The copy of the stepper specialized for the level's rule variant is picked once for
+ * the whole batch. Games that are already over must not be stepped again.
+ *
+ * 'level' specifies the level being played by every game.
+ * 'states' specifies the states of the games (updated in place).
+ * 'move_list' specifies the move for each game (a direction or SKIP_MOVE).
+ * 'results' receives the result of the move for each game.
+ * 'count' specifies the number of games.
+ */
+void engine_step_batch(const struct engine_level *level, struct engine_state *states, const short *move_list, engine_result *results, long count);
+
+#endif	    // _ENGINE_H
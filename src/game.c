@@ -1,4 +1,6 @@
 #include "game.h"
+#include "editor.h"
+#include "levelpack.h"
 
 /**
  * Take in a string value representing a file path for a level, and start a Theseus and
@@ -9,7 +11,8 @@
  * The user plays from the point of view of Theseus, and tries to escape the Minotaur by
  * reaching the exit square.
  *
- * 'file_path' specifies the file path for a level file to be used in the game.
+ * 'file_path' specifies the file path for a level file to be used in the game (a path of
+ * the compiled-in level pack is read from the pack, see read_level()).
  * 'last_level' specifies whether the current level file is the last in the sequence.
  *
  * Return Values:
@@ -30,10 +33,10 @@ int play_game(const char *file_path, bool last_level) {
 	// Make sure that the inputted file path isn't NULL
 	if (file_path == NULL) return 5;
 
-	// Load data from the file into a stats structure
+	// Load data from the file (or the compiled-in level pack) into a stats structure
 	struct stats board_stats;
 	board_stats.walls = NULL;
-	int result = read_level_file(file_path, &board_stats);
+	int result = read_level(file_path, &board_stats);
 
 	// Return proper error value if there was a load failure
 	if (result != 0) {
@@ -43,55 +46,21 @@ int play_game(const char *file_path, bool last_level) {
 
 	int num_squares = board_stats.size.num_rows * board_stats.size.num_cols;
 
-	int theseus_board_pos = (board_stats.theseus.row * board_stats.size.num_cols) + board_stats.theseus.col;
-	int minotaur_board_pos = (board_stats.minotaur.row * board_stats.size.num_cols) + board_stats.minotaur.col;
-	int exit_board_pos = (board_stats.exit.relation.row * board_stats.size.num_cols) + board_stats.exit.relation.col;
-
-	WINDOW *exit_win;
-	short theseus_win_pair, minotaur_win_pair, exit_win_pair;
+	WINDOW *exit_win, *hud = NULL;
+	short theseus_win_pair, minotaur_win_pairs[MAX_MINOTAURS];
 	bool move_made, escaped, caught;
 	int key, mod_key, theseus_move_result, minotaur_move_result;
+	int theseus_moves = 0;
+
+	// Keep the starting positions, to start the level over after it has been edited
+	cell_pos theseus_start = board_stats.theseus, minotaur_starts[MAX_MINOTAURS];
+	memcpy(minotaur_starts, board_stats.minotaurs, sizeof(minotaur_starts));
 
 	// Allocate memory for an array of WINDOW pointers
 	board_square *wins = malloc(sizeof(board_square) * num_squares);
 
-	// Initialize color pairs for the board
-	init_pair(PAIR_1, COLOR_BLACK, COLOR_WHITE);
-	init_pair(PAIR_2, COLOR_BLACK, COLOR_CYAN);
-
-	init_pair(THESEUS_PAIR, COLOR_BLACK, COLOR_BLACK);
-	init_pair(MINOTAUR_PAIR, COLOR_RED, COLOR_BLACK);
-	init_pair(EXIT_PAIR, COLOR_MAGENTA, COLOR_BLACK);
-
-	// Initialize variables to keep track of the pair values of the current WINDOWs occupied by Theseus, the Minotaur, and the Exit
-	if (board_stats.theseus.row & 1)
-		theseus_win_pair = (board_stats.theseus.col & 1) ? PAIR_1 : PAIR_2;
-	else theseus_win_pair = (board_stats.theseus.col & 1) ? PAIR_2 : PAIR_1;
-
-	if (board_stats.minotaur.row & 1)
-		minotaur_win_pair = (board_stats.minotaur.col & 1) ? PAIR_1 : PAIR_2;
-	else minotaur_win_pair = (board_stats.minotaur.col & 1) ? PAIR_2 : PAIR_1;
-
-	if (board_stats.exit.relation.row & 1)
-		exit_win_pair = (board_stats.exit.relation.col & 1) ? PAIR_2 : PAIR_1;
-	else exit_win_pair = (board_stats.exit.relation.col & 1) ? PAIR_1 : PAIR_2;
-
-	// Draw the board to the screen
-	refresh();
-	win_layout(wins, board_stats.size.num_rows, board_stats.size.num_cols, HEIGHT, WIDTH);
-	
-	for(cell_rel *temp = board_stats.walls; temp != NULL; temp = temp->next)
-		draw_wall(wins[(temp->relation.row * board_stats.size.num_cols) + temp->relation.col].win, temp->location);
-
-	exit_win = place_win(wins[exit_board_pos].win, board_stats.exit.location, HEIGHT, WIDTH);
-	win_draw_image(exit_win, exit_image, EXIT_SIZE, EXIT_PAIR, exit_win_pair);
-
-	win_draw_image(wins[theseus_board_pos].win, theseus_image, THESEUS_SIZE, THESEUS_PAIR, theseus_win_pair);
-	win_draw_image(wins[minotaur_board_pos].win, minotaur_image, MINOTAUR_SIZE, MINOTAUR_PAIR, minotaur_win_pair);
-	doupdate();
-
-	// Disable moves through walls and off the board
-	set_moves(&board_stats, wins);
+	// Draw the board to the screen and disable moves through walls and off the board
+	exit_win = draw_board(&board_stats, wins, &theseus_win_pair, minotaur_win_pairs);
 
 	escaped = false;
 	caught = false;
@@ -99,9 +68,64 @@ int play_game(const char *file_path, bool last_level) {
 	// Accept input (moves/commands) from the user
 	while (true) {
 		move_made = false;
+		theseus_move_result = 0;
 		
 		// Detect the key press and check if EXIT key was pressed
 		mod_key = (key = getch()) | ('a' - 'A');
+		lat_mark();
+
+		// Keep the board in the middle of a resized terminal, with the HUD on top of it
+		if (key == KEY_RESIZE) {
+			fit_board(&board_stats, wins, &exit_win, &theseus_win_pair, minotaur_win_pairs);
+			if (hud != NULL) {
+				touchwin(hud);
+				wnoutrefresh(hud);
+			}
+			flush_frame();
+
+			continue;
+		}
+
+		// Show or hide the latency HUD
+		if (mod_key == HUD) {
+			if (hud == NULL) {
+				hud = newwin(HUD_HEIGHT, HUD_WIDTH, 0, 0);
+				draw_hud(hud);
+			}
+			else {
+				delwin(hud);
+				hud = NULL;
+				repaint_board(wins, num_squares, exit_win, NULL);
+			}
+			flush_frame();
+
+			continue;
+		}
+
+		// Edit the level from its starting positions, then play the edited level from the start
+		if (mod_key == EDIT) {
+			if (hud != NULL) {
+				werase(hud);
+				wnoutrefresh(hud);
+				delwin(hud);
+				hud = NULL;
+			}
+			for(int i = 0; i < num_squares; i++)
+				delwin(wins[i].win);
+			delwin(exit_win);
+
+			board_stats.theseus = theseus_start;
+			memcpy(board_stats.minotaurs, minotaur_starts, sizeof(minotaur_starts));
+			edit_level(file_path, &board_stats);
+
+			theseus_start = board_stats.theseus;
+			memcpy(minotaur_starts, board_stats.minotaurs, sizeof(minotaur_starts));
+			exit_win = draw_board(&board_stats, wins, &theseus_win_pair, minotaur_win_pairs);
+			theseus_moves = 0;
+
+			continue;
+		}
+
 		if (mod_key == EXIT || mod_key == RESTART || mod_key == MAIN_MENU) {
 
 			// Show correct confirmation message based on key press
@@ -113,15 +137,10 @@ int play_game(const char *file_path, bool last_level) {
 			}
 			else if (show_message(0, 55, "Are you sure you want to return to the Main Menu?", " YES ", " NO ")) break;
 			
-			// Reprint the board to the screen
-			refresh();
-			for(int i = 0; i < num_squares; i++) {
-				touchwin(wins[i].win);			/* Mark the entire WINDOW as changed (causes all of the WINDOW to be redrawn) */
-				wnoutrefresh(wins[i].win);
-			}
-			touchwin(exit_win);
-			wnoutrefresh(exit_win);
-			doupdate();
+			// Reprint the board to the screen (the terminal may have been resized while the message was up)
+			fit_board(&board_stats, wins, &exit_win, &theseus_win_pair, minotaur_win_pairs);
+			repaint_board(wins, num_squares, exit_win, hud);
+			flush_frame();
 			
 			continue;
 		}
@@ -169,26 +188,40 @@ int play_game(const char *file_path, bool last_level) {
 				break;
 		}
 
+		// Record how long it took for Theseus' move to reach the terminal
+		if (theseus_move_result != 0) lat_record(LAT_THESEUS);
+
 		// Check if Theseus escaped (user won)
 		if (escaped || caught) break;
 
 		// Skip the Minotaur's move if no move was made
 		if (!move_made) continue;
 
-		usleep(PAUSE_TIME);
+		// The Minotaur waits until Theseus has made all of his moves for the turn
+		if (++theseus_moves < board_stats.rules.theseus_steps) continue;
+		theseus_moves = 0;
 
-		// Determine and make the Minotaur's two moves
-		if ((minotaur_move_result = move_minotaur(&board_stats, wins, &minotaur_win_pair)) == 1) {
-			usleep(PAUSE_TIME);
-			
-			if ((minotaur_move_result = move_minotaur(&board_stats, wins, &minotaur_win_pair)) == 2) {
-				caught = true;
-				break;
+		// Determine and make the moves of each Minotaur in turn (two with the original rules)
+		for(int i = 0; i < board_stats.num_minotaurs && !caught; i++) {
+			for(int step = 0; step < board_stats.rules.minotaur_steps; step++) {
+				usleep(PAUSE_TIME);
+				lat_mark();
+
+				if ((minotaur_move_result = move_minotaur(&board_stats, wins, i, &minotaur_win_pairs[i])) == 0) break;
+				lat_record(LAT_MINOTAUR);
+
+				if (minotaur_move_result == 2) {
+					caught = true;
+					break;
+				}
 			}
 		}
-		else if (minotaur_move_result == 2) {
-			caught = true;
-			break;
+		if (caught) break;
+
+		// Keep the latency HUD up to date
+		if (hud != NULL) {
+			draw_hud(hud);
+			flush_frame();
 		}
 	}
 
@@ -197,6 +230,7 @@ int play_game(const char *file_path, bool last_level) {
 		delwin(wins[i].win);
 	free(wins);
 	delwin(exit_win);
+	if (hud != NULL) delwin(hud);
 
 	free_walls(board_stats.walls);
 
@@ -244,6 +278,76 @@ int play_game(const char *file_path, bool last_level) {
 	return 8;
 }
 
+
+/**
+ * Initialize the color pairs for the board, draw the board described by a stats structure
+ * to the screen (squares, walls, exit, Theseus and the Minotaurs), and compute the valid moves
+ * for each square of the board. The color pairs of the squares currently occupied by Theseus
+ * and the Minotaurs are stored for use by the movement functions.
+ *
+ * 'board' is a structure holding the information for the board.
+ * 'wins' specifies an array of uninitialized board_square structures (one per square).
+ * 'theseus_win_pair' receives the color pair of the square occupied by Theseus.
+ * 'minotaur_win_pairs' receives the color pair of the square occupied by each Minotaur.
+ *
+ * Return Value:
+ *	The function returns the exit WINDOW for the board.
+ */
+WINDOW *draw_board(struct stats *board, board_square *wins, short *theseus_win_pair, short *minotaur_win_pairs) {
+	int theseus_board_pos = (board->theseus.row * board->size.num_cols) + board->theseus.col;
+	int exit_board_pos = (board->exit.relation.row * board->size.num_cols) + board->exit.relation.col;
+
+	WINDOW *exit_win;
+	short exit_win_pair;
+
+	// Initialize color pairs for the board
+	init_pair(PAIR_1, COLOR_BLACK, COLOR_WHITE);
+	init_pair(PAIR_2, COLOR_BLACK, COLOR_CYAN);
+
+	init_pair(THESEUS_PAIR, COLOR_BLACK, COLOR_BLACK);
+	init_pair(MINOTAUR_PAIR, COLOR_RED, COLOR_BLACK);
+	init_pair(EXIT_PAIR, COLOR_MAGENTA, COLOR_BLACK);
+	bake_sprites();
+
+	// Initialize variables to keep track of the pair values of the current WINDOWs occupied by Theseus, the Minotaurs, and the Exit
+	if (board->theseus.row & 1)
+		*theseus_win_pair = (board->theseus.col & 1) ? PAIR_1 : PAIR_2;
+	else *theseus_win_pair = (board->theseus.col & 1) ? PAIR_2 : PAIR_1;
+
+	for(int i = 0; i < board->num_minotaurs; i++) {
+		if (board->minotaurs[i].row & 1)
+			minotaur_win_pairs[i] = (board->minotaurs[i].col & 1) ? PAIR_1 : PAIR_2;
+		else minotaur_win_pairs[i] = (board->minotaurs[i].col & 1) ? PAIR_2 : PAIR_1;
+	}
+
+	if (board->exit.relation.row & 1)
+		exit_win_pair = (board->exit.relation.col & 1) ? PAIR_2 : PAIR_1;
+	else exit_win_pair = (board->exit.relation.col & 1) ? PAIR_1 : PAIR_2;
+
+	// Draw the board to the screen (the screen has just been cleared)
+	refresh();
+	if (render_backend == BACKEND_ANSI) ansi_clear();
+	win_layout(wins, board->size.num_rows, board->size.num_cols, HEIGHT, WIDTH);
+	
+	for(cell_rel *temp = board->walls; temp != NULL; temp = temp->next)
+		draw_wall(wins[(temp->relation.row * board->size.num_cols) + temp->relation.col].win, temp->location);
+
+	exit_win = place_win(wins[exit_board_pos].win, board->exit.location, HEIGHT, WIDTH);
+	win_draw_sprite(exit_win, SPRITE_EXIT, exit_win_pair);
+
+	win_draw_sprite(wins[theseus_board_pos].win, SPRITE_THESEUS, *theseus_win_pair);
+	for(int i = 0; i < board->num_minotaurs; i++) {
+		int minotaur_board_pos = (board->minotaurs[i].row * board->size.num_cols) + board->minotaurs[i].col;
+		win_draw_sprite(wins[minotaur_board_pos].win, SPRITE_MINOTAUR, minotaur_win_pairs[i]);
+	}
+	flush_frame();
+
+	// Disable moves through walls and off the board
+	set_moves(board, wins);
+
+	return exit_win;
+}
+
 /**
  * Display a message WINDOW to the screen, and prompt the user for a "yes or no" decision where
  * they can switch between the options using the left and right arrow keys. The message and options
@@ -282,10 +386,13 @@ bool show_message(int win_height, int win_width, const char *title, const char *
 	mvwprintw(win, win_height - 3, ((win_width - strlen(false_choice)) * 3) / 4, "%s", false_choice);
 	wattroff(win, A_REVERSE);
 
+	// ncurses can't see the ANSI backend drawing over an earlier message, so always send all of it
+	if (render_backend == BACKEND_ANSI) redrawwin(win);
 	wrefresh(win);
 	
 	// Select the option that is chosen by the user
 	while ((key = getch()) != '\n') {
+		lat_mark();
 		
 		switch (key) {
 			case KEY_LEFT:
@@ -293,6 +400,7 @@ bool show_message(int win_height, int win_width, const char *title, const char *
 					mvwchgat(win, win_height - 3, ((win_width - strlen(false_choice)) * 3) / 4, strlen(false_choice), A_NORMAL, 0, NULL);
 					mvwchgat(win, win_height - 3, (win_width - strlen(true_choice)) / 4, strlen(true_choice), A_REVERSE, 0, NULL);
 					wrefresh(win);
+					lat_record(LAT_MENU);
 
 					cur_choice = !cur_choice;
 				}
@@ -303,6 +411,7 @@ bool show_message(int win_height, int win_width, const char *title, const char *
 					mvwchgat(win, win_height - 3, (win_width - strlen(true_choice)) / 4, strlen(true_choice), A_NORMAL, 0, NULL);
 					mvwchgat(win, win_height - 3, ((win_width - strlen(false_choice)) * 3) / 4, strlen(false_choice), A_REVERSE, 0, NULL);
 					wrefresh(win);
+					lat_record(LAT_MENU);
 
 					cur_choice = !cur_choice;
 				}
@@ -317,3 +426,121 @@ bool show_message(int win_height, int win_width, const char *title, const char *
 
 	return cur_choice;
 }
+
+/**
+ * Mark every WINDOW of the board as changed and copy them to the virtual screen, so that
+ * the whole board is redrawn on the next frame (i.e after a message WINDOW covered it).
+ * The latency HUD is copied last so that it stays on top of the board.
+ *
+ * 'wins' specifies the array of board_square structures for the board.
+ * 'num_squares' is the number of board_square structures in 'wins'.
+ * 'exit_win' specifies the exit WINDOW for the board.
+ * 'hud' specifies the latency HUD WINDOW (NULL if the HUD is hidden).
+ */
+void repaint_board(board_square *wins, int num_squares, WINDOW *exit_win, WINDOW *hud) {
+	refresh();
+
+	// The ANSI backend keeps its own copy of the board, so just have all of it sent again
+	if (render_backend == BACKEND_ANSI) {
+		ansi_invalidate();
+		if (hud != NULL) {
+			redrawwin(hud);
+			wnoutrefresh(hud);
+		}
+
+		return;
+	}
+
+	for(int i = 0; i < num_squares; i++) {
+		touchwin(wins[i].win);			/* Mark the entire WINDOW as changed (causes all of the WINDOW to be redrawn) */
+		wnoutrefresh(wins[i].win);
+	}
+	touchwin(exit_win);
+	wnoutrefresh(exit_win);
+
+	if (hud != NULL) {
+		touchwin(hud);
+		wnoutrefresh(hud);
+	}
+
+	return;
+}
+
+/**
+ * Print the latency statistics that have been gathered so far to the latency HUD WINDOW:
+ * the median and 99th percentile latencies of Theseus' moves, the Minotaur's steps and
+ * menu actions, along with the number of bytes sent to the terminal per frame. The
+ * WINDOW is only copied to the virtual screen.
+ *
+ * 'hud' specifies the WINDOW to print the statistics to.
+ */
+void draw_hud(WINDOW *hud) {
+	const char *names[NUM_LAT_KINDS] = {"Theseus", "Minotaur", "Menu"};
+	unsigned long long last_bytes;
+	double avg_bytes = lat_bytes_per_frame(&last_bytes);
+
+	werase(hud);
+	box(hud, 0, 0);
+	mvwprintw(hud, 1, 2, "%-9s %8s %8s %6s", "Latency", "p50 ms", "p99 ms", "count");
+
+	for(int i = 0; i < NUM_LAT_KINDS; i++)
+		mvwprintw(hud, i + 2, 2, "%-9s %8.2f %8.2f %6llu", names[i], lat_percentile(i, 0.50) / 1000.0,
+			  lat_percentile(i, 0.99) / 1000.0, lat_count(i));
+
+	if (avg_bytes < 0)
+		mvwprintw(hud, NUM_LAT_KINDS + 2, 2, "Bytes/frame: n/a");
+	else mvwprintw(hud, NUM_LAT_KINDS + 2, 2, "Bytes/frame: %.0f avg, %llu last", avg_bytes, last_bytes);
+
+	// ncurses can't see the ANSI backend drawing over the HUD, so always send all of it
+	if (render_backend == BACKEND_ANSI) redrawwin(hud);
+	wnoutrefresh(hud);
+
+	return;
+}
+
+/**
+ * Fit the board to the screen after the terminal has been resized. ncurses clears the terminal
+ * after a resize and paints it again from the virtual screen, so the virtual screen is put back
+ * together: the blank screen, then the board, moved to the middle of the screen with its
+ * contents (see win_relayout()). The board is only drawn from scratch if the resize cut its
+ * WINDOWs. With the ANSI backend, the screen buffer keeps the size it was set up with (spectators
+ * were sent that size), so the board stays where it is and is all sent to the terminal again.
+ * Other WINDOWs (i.e the latency HUD) have to be copied to the virtual screen again by the
+ * caller, before the frame is flushed.
+ *
+ * 'board' is a structure holding the information for the board.
+ * 'wins' specifies the array of board_square structures for the board.
+ * 'exit_win' specifies the exit WINDOW for the board (replaced if the board is drawn again).
+ * 'theseus_win_pair' receives the color pair of the square occupied by Theseus, if the board is drawn again.
+ * 'minotaur_win_pairs' receives the color pair of the square occupied by each Minotaur, if the board is drawn again.
+ */
+void fit_board(struct stats *board, board_square *wins, WINDOW **exit_win, short *theseus_win_pair, short *minotaur_win_pairs) {
+	int num_squares = board->size.num_rows * board->size.num_cols;
+
+	if (render_backend == BACKEND_ANSI) {
+		ansi_invalidate();
+		return;
+	}
+
+	// The WINDOWs no longer have their shape, so the board is drawn again from its stats
+	if (win_relayout(wins, board->size.num_rows, board->size.num_cols, HEIGHT, WIDTH, *exit_win) == 2) {
+		for(int i = 0; i < num_squares; i++)
+			delwin(wins[i].win);
+		delwin(*exit_win);
+		clear();
+		*exit_win = draw_board(board, wins, theseus_win_pair, minotaur_win_pairs);
+
+		return;
+	}
+
+	touchwin(stdscr);
+	wnoutrefresh(stdscr);
+	for(int i = 0; i < num_squares; i++) {
+		touchwin(wins[i].win);
+		wnoutrefresh(wins[i].win);
+	}
+	touchwin(*exit_win);
+	wnoutrefresh(*exit_win);
+
+	return;
+}
@@ -7,6 +7,7 @@
 #include "board.h"
 #include "loader.h"
 #include "movement.h"
+#include "latency.h"
 
 #define PAUSE_TIME 200000
 
@@ -14,10 +15,15 @@
 #define EXIT 'q'	/* Command key to quit game */
 #define RESTART 'r'	/* Command key to restart game */
 #define SKIP_TURN ' '	/* Command key to skip turn */
+#define HUD 'h'		/* Command key to show/hide the latency HUD */
+#define EDIT 'e'	/* Command key to edit the level (and to go back to playing it) */
 
 #define MESSAGE_HEIGHT 7
 #define MESSAGE_WIDTH 45
 
+#define HUD_HEIGHT 7
+#define HUD_WIDTH 38
+
 /**
  * Take in a string value representing a file path for a level, and start a Theseus and
  * the Minotaur Game. If the contents of the level file pointed to by the given file path
@@ -27,7 +33,8 @@
  * The user plays from the point of view of Theseus, and tries to escape the Minotaur by
  * reaching the exit square.
  *
- * 'file_path' specifies the file path for a level file to be used in the game.
+ * 'file_path' specifies the file path for a level file to be used in the game (a path of
+ * the compiled-in level pack is read from the pack, see read_level()).
  * 'last_level' specifies whether the current level file is the last in the sequence.
  *
  * Return Values:
@@ -45,6 +52,22 @@
  */
 int play_game(const char *file_path, bool last_level);
 
+/**
+ * Initialize the color pairs for the board, draw the board described by a stats structure
+ * to the screen (squares, walls, exit, Theseus and the Minotaurs), and compute the valid moves
+ * for each square of the board. The color pairs of the squares currently occupied by Theseus
+ * and the Minotaurs are stored for use by the movement functions.
+ *
+ * 'board' is a structure holding the information for the board.
+ * 'wins' specifies an array of uninitialized board_square structures (one per square).
+ * 'theseus_win_pair' receives the color pair of the square occupied by Theseus.
+ * 'minotaur_win_pairs' receives the color pair of the square occupied by each Minotaur.
+ *
+ * Return Value:
+ *      The function returns the exit WINDOW for the board.
+ */
+WINDOW *draw_board(struct stats *board, board_square *wins, short *theseus_win_pair, short *minotaur_win_pairs);
+
 /**
  * Display a message WINDOW to the screen, and prompt the user for a "yes or no" decision where
  * they can switch between the options using the left and right arrow keys. The message and options
@@ -62,4 +85,44 @@ int play_game(const char *file_path, bool last_level);
  */
 bool show_message(int win_height, int win_width, const char *title, const char *true_choice, const char *false_choice);
 
+/**
+ * Mark every WINDOW of the board as changed and copy them to the virtual screen, so that
+ * the whole board is redrawn on the next frame (i.e after a message WINDOW covered it).
+ * The latency HUD is copied last so that it stays on top of the board.
+ *
+ * 'wins' specifies the array of board_square structures for the board.
+ * 'num_squares' is the number of board_square structures in 'wins'.
+ * 'exit_win' specifies the exit WINDOW for the board.
+ * 'hud' specifies the latency HUD WINDOW (NULL if the HUD is hidden).
+ */
+void repaint_board(board_square *wins, int num_squares, WINDOW *exit_win, WINDOW *hud);
+
+/**
+ * Print the latency statistics that have been gathered so far to the latency HUD WINDOW:
+ * the median and 99th percentile latencies of Theseus' moves, the Minotaur's steps and
+ * menu actions, along with the number of bytes sent to the terminal per frame. The
+ * WINDOW is only copied to the virtual screen.
+ *
+ * 'hud' specifies the WINDOW to print the statistics to.
+ */
+void draw_hud(WINDOW *hud);
+
+/**
+ * Fit the board to the screen after the terminal has been resized. ncurses clears the terminal
+ * after a resize and paints it again from the virtual screen, so the virtual screen is put back
+ * together: the blank screen, then the board, moved to the middle of the screen with its
+ * contents (see win_relayout()). The board is only drawn from scratch if the resize cut its
+ * WINDOWs. With the ANSI backend, the screen buffer keeps the size it was set up with (spectators
+ * were sent that size), so the board stays where it is and is all sent to the terminal again.
+ * Other WINDOWs (i.e the latency HUD) have to be copied to the virtual screen again by the
+ * caller, before the frame is flushed.
+ *
+ * 'board' is a structure holding the information for the board.
+ * 'wins' specifies the array of board_square structures for the board.
+ * 'exit_win' specifies the exit WINDOW for the board (replaced if the board is drawn again).
+ * 'theseus_win_pair' receives the color pair of the square occupied by Theseus, if the board is drawn again.
+ * 'minotaur_win_pairs' receives the color pair of the square occupied by each Minotaur, if the board is drawn again.
+ */
+void fit_board(struct stats *board, board_square *wins, WINDOW **exit_win, short *theseus_win_pair, short *minotaur_win_pairs);
+
 #endif	    // _GAME_H
@@ -0,0 +1,39 @@
+#include "iostat.h"
+
+// File descriptor for /proc/self/io (opened on first use, -1 if unavailable)
+static int io_fd = -2;
+
+/**
+ * Read the output counters of the running process from /proc/self/io. The counters
+ * include every write system call the process has made (including the ones made
+ * from inside the ncurses library), so the difference between two readings gives
+ * the exact number of bytes and write calls that were emitted in between. The file
+ * is opened once and kept open, so that each reading costs a single pread() call.
+ *
+ * 'counters' specifies the io_counters structure to fill in.
+ *
+ * Return Values:
+ *	true - The counters were read successfully.
+ *	false - The counters are not available on this system.
+ */
+bool read_io_counters(struct io_counters *counters) {
+	char buffer[512];
+	ssize_t length;
+
+	if (io_fd == -2)
+		io_fd = open("/proc/self/io", O_RDONLY | O_CLOEXEC);
+	if (io_fd < 0) return false;
+
+	if ((length = pread(io_fd, buffer, sizeof(buffer) - 1, 0)) <= 0) return false;
+	buffer[length] = '\0';
+
+	// Pick out the two counters we care about from the "name: value" lines
+	char *wchar = strstr(buffer, "wchar:");
+	char *syscw = strstr(buffer, "syscw:");
+	if (wchar == NULL || syscw == NULL) return false;
+
+	counters->bytes_written = strtoull(wchar + 6, NULL, 10);
+	counters->write_calls = strtoull(syscw + 6, NULL, 10);
+
+	return true;
+}
@@ -0,0 +1,35 @@
+#ifndef _IOSTAT_H
+#define _IOSTAT_H
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Structure to hold the output counters of the running process
+struct io_counters {
+	unsigned long long bytes_written;	/* Bytes passed to write() and friends */
+	unsigned long long write_calls;		/* Number of write system calls */
+};
+
+/**
+ * Read the output counters of the running process from /proc/self/io. The counters
+ * include every write system call the process has made (including the ones made
+ * from inside the ncurses library), so the difference between two readings gives
+ * the exact number of bytes and write calls that were emitted in between. The file
+ * is opened once and kept open, so that each reading costs a single pread() call.
+ *
+ * 'counters' specifies the io_counters structure to fill in.
+ *
+ * Return Values:
+ *	true - The counters were read successfully.
+ *	false - The counters are not available on this system.
+ */
+bool read_io_counters(struct io_counters *counters);
+
+#endif	    // _IOSTAT_H
@@ -0,0 +1,127 @@
+#ifndef _KERNELS_H
+#define _KERNELS_H
+
+#include "engine.h"
+
+/*
+ * Step kernels shared by the engine, the batch stepper and the solver. The rule variant
+ * arguments are meant to be compile-time constants: every user instantiates its hot loop
+ * once per rule variant (see RULE_VARIANTS), so that each copy is compiled with its own
+ * number of steps and move order and nothing is dispatched inside the loop.
+ */
+
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+#define THESEUS_BLOCKED -1	/* Returned by theseus_step() for an invalid move */
+#define THESEUS_ESCAPED -2	/* Returned by theseus_step() when Theseus goes through the exit */
+
+// Every rule variant as X(name, minotaur steps, vertical first, Theseus steps), in rules_variant() order
+#define RULE_VARIANTS(X) \
+	X(m1h_t1, 1, false, 1) X(m1h_t2, 1, false, 2) X(m1v_t1, 1, true, 1) X(m1v_t2, 1, true, 2) \
+	X(m2h_t1, 2, false, 1) X(m2h_t2, 2, false, 2) X(m2v_t1, 2, true, 1) X(m2v_t2, 2, true, 2) \
+	X(m3h_t1, 3, false, 1) X(m3h_t2, 3, false, 2) X(m3v_t1, 3, true, 1) X(m3v_t2, 3, true, 2)
+
+// Move Theseus from a cell (SKIP_MOVE stays put): returns the new cell, THESEUS_BLOCKED or THESEUS_ESCAPED
+KERNEL_INLINE int theseus_step(const struct engine_level *level, int theseus, int move) {
+	if (move == SKIP_MOVE) return theseus;
+	if (!(level->masks[theseus] & moves[move])) return THESEUS_BLOCKED;
+	if (theseus == level->exit_cell && move == level->exit_dir) return THESEUS_ESCAPED;
+
+	switch (move) {
+		case LEFT:
+			return theseus - 1;
+
+		case RIGHT:
+			return theseus + 1;
+
+		case UP:
+			return theseus - level->num_cols;
+
+		default:
+			return theseus + level->num_cols;
+	}
+}
+
+// Pick the Minotaur's step from the table: 'dx' and 'dy' are the signs (-1, 0 or 1) of Theseus' column and row minus the Minotaur's
+KERNEL_INLINE int minotaur_choice(unsigned char mask, int dx, int dy, bool vertical_first) {
+	return minotaur_choices[vertical_first][mask & MOVE_MASK_BITS][dx + 1][dy + 1];
+}
+
+// Make one Minotaur step toward Theseus using only the moves in 'mask': returns his new cell (unchanged if he can't move)
+KERNEL_INLINE int minotaur_step_masked(const struct engine_level *level, int theseus, int minotaur, unsigned char mask, bool vertical_first) {
+	int m_row = level->cell_rows[minotaur], m_col = level->cell_cols[minotaur];
+	int t_row = level->cell_rows[theseus], t_col = level->cell_cols[theseus];
+	int dx = (t_col > m_col) - (t_col < m_col), dy = (t_row > m_row) - (t_row < m_row);
+
+	return minotaur + level->step_offsets[minotaur_choice(mask, dx, dy, vertical_first)];
+}
+
+// Make one Minotaur step toward Theseus: returns the Minotaur's new cell (unchanged if he can't move)
+KERNEL_INLINE int minotaur_step(const struct engine_level *level, int theseus, int minotaur, bool vertical_first) {
+	return minotaur_step_masked(level, theseus, minotaur, level->masks[minotaur], vertical_first);
+}
+
+// Give the Minotaur all his steps for a turn: returns his new cell (equal to 'theseus' if caught)
+KERNEL_INLINE int minotaur_turn(const struct engine_level *level, int theseus, int minotaur, int steps, bool vertical_first) {
+	for(int step = 0; step < steps; step++) {
+		int next = minotaur_step(level, theseus, minotaur, vertical_first);
+		if (next == minotaur || next == theseus) return next;
+
+		minotaur = next;
+	}
+
+	return minotaur;
+}
+
+// Valid moves of Minotaur 'index' that don't run into one of the other Minotaurs
+KERNEL_INLINE unsigned char minotaur_free_moves(const struct engine_level *level, const int *minotaurs, int count, int index) {
+	int minotaur = minotaurs[index], ncols = level->num_cols;
+	unsigned char mask = level->masks[minotaur];
+
+	// A move off the edge of a row is already masked out, so wrapping cells don't matter
+	for(int k = 0; k < count; k++) {
+		int other = minotaurs[k];
+
+		if (other == minotaur - 1) mask &= ~moves[LEFT];
+		else if (other == minotaur + 1) mask &= ~moves[RIGHT];
+		else if (other == minotaur - ncols) mask &= ~moves[UP];
+		else if (other == minotaur + ncols) mask &= ~moves[DOWN];
+	}
+
+	return mask;
+}
+
+// Check if Theseus stands on the square of one of the Minotaurs
+KERNEL_INLINE bool on_minotaur(const int *minotaurs, int count, int theseus) {
+	for(int k = 0; k < count; k++)
+		if (minotaurs[k] == theseus) return true;
+
+	return false;
+}
+
+/*
+ * Give every Minotaur his steps for a turn, one Minotaur after the other in level order
+ * (updated in place). A Minotaur never steps onto another Minotaur's square: that move
+ * is treated like a wall. Returns true if Theseus was caught (the turn ends right away).
+ */
+KERNEL_INLINE bool minotaurs_turn(const struct engine_level *level, int theseus, int *minotaurs, int count, int steps, bool vertical_first) {
+	if (count == 1) {
+		minotaurs[0] = minotaur_turn(level, theseus, minotaurs[0], steps, vertical_first);
+		return (minotaurs[0] == theseus);
+	}
+
+	for(int k = 0; k < count; k++) {
+		for(int step = 0; step < steps; step++) {
+			unsigned char mask = minotaur_free_moves(level, minotaurs, count, k);
+			int next = minotaur_step_masked(level, theseus, minotaurs[k], mask, vertical_first);
+			if (next == minotaurs[k]) break;
+
+			minotaurs[k] = next;
+			if (next == theseus) return true;
+		}
+	}
+
+	return false;
+}
+
+#endif	    // _KERNELS_H
@@ -0,0 +1,291 @@
+#include "latency.h"
+
+// Whether latency instrumentation is turned on (off by default)
+bool latency_enabled = false;
+
+// Whether the startup phases are timed (off by default, see lat_startup_phase())
+bool startup_trace_enabled = false;
+
+// Names of the kinds of latency (used for the dump file)
+static const char *lat_names[NUM_LAT_KINDS] = {
+	"theseus_move",
+	"minotaur_step",
+	"menu_action"
+};
+
+// One histogram for each kind of latency
+static struct lat_histogram histograms[NUM_LAT_KINDS];
+
+// Time (microseconds) of the last marked input event, 0 if none
+static unsigned long long marked_time = 0;
+
+// Output counters taken at the start of the current frame, and the per-frame totals
+static struct io_counters frame_start;
+static bool frame_started = false;
+static unsigned long long frame_bytes_total = 0;
+static unsigned long long frame_bytes_last = 0;
+static unsigned long long frames_measured = 0;
+
+// Startup phases timed so far, with the time (microseconds) each one ended at
+static const char *startup_names[LAT_STARTUP_PHASES];
+static unsigned long long startup_ends[LAT_STARTUP_PHASES];
+static unsigned long long startup_begin = 0;
+static int startup_phases = 0;
+static bool startup_done = false;
+
+// Find the bucket holding a value (exact below LAT_SUB_BUCKETS, then LAT_SUB_BUCKETS per power of two)
+static int bucket_index(unsigned long long value) {
+	if (value < LAT_SUB_BUCKETS) return (int)value;
+
+	int msb = 63 - __builtin_clzll(value);
+	int octave = msb - 4;				/* LAT_SUB_BUCKETS == 1 << 4 */
+
+	if (octave >= LAT_OCTAVES) return LAT_BUCKETS - 1;
+
+	return LAT_SUB_BUCKETS + (octave * LAT_SUB_BUCKETS) + (int)((value >> octave) - LAT_SUB_BUCKETS);
+}
+
+// Find the largest value that falls into a bucket
+static unsigned long long bucket_upper(int index) {
+	if (index < LAT_SUB_BUCKETS) return index;
+
+	int octave = (index - LAT_SUB_BUCKETS) / LAT_SUB_BUCKETS;
+	int sub = (index - LAT_SUB_BUCKETS) % LAT_SUB_BUCKETS;
+
+	return ((unsigned long long)(LAT_SUB_BUCKETS + sub + 1) << octave) - 1;
+}
+
+/**
+ * Add one latency value (in microseconds) to a histogram. Histograms that are not
+ * shared between threads can be used this way from any number of threads.
+ *
+ * 'hist' specifies the histogram to add the value to.
+ * 'value' specifies the latency in microseconds.
+ */
+void lat_hist_add(struct lat_histogram *hist, unsigned long long value) {
+	hist->counts[bucket_index(value)]++;
+	hist->total++;
+	hist->sum += value;
+	if (value > hist->max) hist->max = value;
+
+	return;
+}
+
+/**
+ * Add all the values of one histogram into another histogram.
+ *
+ * 'dest' specifies the histogram to add the values to.
+ * 'src' specifies the histogram to take the values from.
+ */
+void lat_hist_merge(struct lat_histogram *dest, const struct lat_histogram *src) {
+	for(int i = 0; i < LAT_BUCKETS; i++)
+		dest->counts[i] += src->counts[i];
+
+	dest->total += src->total;
+	dest->sum += src->sum;
+	if (src->max > dest->max) dest->max = src->max;
+
+	return;
+}
+
+/**
+ * Find the latency (in microseconds) below which a given fraction of the values of
+ * a histogram fall.
+ *
+ * 'hist' specifies the histogram to look at.
+ * 'fraction' specifies the percentile as a fraction (i.e 0.99 for p99).
+ *
+ * Return Value:
+ *	The function returns the upper bound of the bucket holding the percentile,
+ *	or 0 if the histogram is empty.
+ */
+unsigned long long lat_hist_percentile(const struct lat_histogram *hist, double fraction) {
+	unsigned long long seen = 0, target;
+
+	if (hist->total == 0) return 0;
+
+	// The rank of the value we're looking for (rounded up, and at least the first value)
+	target = (unsigned long long)(fraction * hist->total);
+	if (target < fraction * hist->total || target == 0) target++;
+
+	for(int i = 0; i < LAT_BUCKETS; i++) {
+		seen += hist->counts[i];
+		if (seen >= target)
+			return (bucket_upper(i) < hist->max) ? bucket_upper(i) : hist->max;
+	}
+
+	return hist->max;
+}
+
+/**
+ * Timestamp an input event, such as the return of getch(). The next call to
+ * lat_record() measures its latency from this point.
+ */
+void lat_mark(void) {
+	if (latency_enabled) marked_time = lat_now();
+
+	return;
+}
+
+/**
+ * Record the time since the last call to lat_mark() into the histogram for the
+ * specified kind of latency. Nothing is recorded if no event has been marked.
+ *
+ * 'kind' specifies which histogram to record into.
+ */
+void lat_record(lat_kind kind) {
+	if (!latency_enabled || marked_time == 0) return;
+
+	lat_hist_add(&histograms[kind], lat_now() - marked_time);
+
+	return;
+}
+
+/**
+ * Measure the output of a frame. Called by flush_frame() right before and right
+ * after the virtual screen is copied to the terminal.
+ *
+ * 'done' specifies whether the frame has finished being flushed.
+ */
+void lat_frame(bool done) {
+	struct io_counters counters;
+
+	if (!latency_enabled) return;
+
+	if (!done) {
+		frame_started = read_io_counters(&frame_start);
+	}
+	else if (frame_started && read_io_counters(&counters)) {
+		frame_bytes_last = counters.bytes_written - frame_start.bytes_written;
+		frame_bytes_total += frame_bytes_last;
+		frames_measured++;
+		frame_started = false;
+	}
+
+	return;
+}
+
+/**
+ * Find the latency (in microseconds) below which a given fraction of the recorded
+ * values for a kind of latency fall.
+ *
+ * 'kind' specifies which histogram to look at.
+ * 'fraction' specifies the percentile as a fraction (i.e 0.99 for p99).
+ *
+ * Return Value:
+ *	The function returns the upper bound of the bucket holding the percentile,
+ *	or 0 if nothing has been recorded.
+ */
+unsigned long long lat_percentile(lat_kind kind, double fraction) {
+	return lat_hist_percentile(&histograms[kind], fraction);
+}
+
+/**
+ * Get the number of values that have been recorded for a kind of latency.
+ */
+unsigned long long lat_count(lat_kind kind) {
+	return histograms[kind].total;
+}
+
+/**
+ * Get the average number of bytes written to the terminal per frame, and the number
+ * of bytes written for the last frame.
+ *
+ * 'last' receives the number of bytes of the last frame (may be NULL).
+ *
+ * Return Value:
+ *	The function returns the average bytes per frame, or -1 if unknown.
+ */
+double lat_bytes_per_frame(unsigned long long *last) {
+	if (last != NULL) *last = frame_bytes_last;
+	if (frames_measured == 0) return -1;
+
+	return (double)frame_bytes_total / frames_measured;
+}
+
+/**
+ * Write all the latency histograms and the per-frame output statistics to a file.
+ *
+ * 'file_path' specifies the file to write to.
+ *
+ * Return Values:
+ *	true - The file was written.
+ *	false - The file could not be opened for writing.
+ */
+bool lat_dump(const char *file_path) {
+	FILE *outfile = fopen(file_path, "w");
+	if (outfile == NULL) return false;
+
+	// Summary lines first, one per kind of latency (all values in microseconds)
+	fprintf(outfile, "# kind count mean_us p50_us p90_us p99_us p999_us max_us\n");
+	for(int k = 0; k < NUM_LAT_KINDS; k++) {
+		struct lat_histogram *hist = &histograms[k];
+
+		fprintf(outfile, "%s %llu %.1f %llu %llu %llu %llu %llu\n", lat_names[k], hist->total,
+			(hist->total) ? (double)hist->sum / hist->total : 0.0,
+			lat_percentile(k, 0.50), lat_percentile(k, 0.90), lat_percentile(k, 0.99),
+			lat_percentile(k, 0.999), hist->max);
+	}
+
+	fprintf(outfile, "# frames bytes_per_frame\n");
+	fprintf(outfile, "frames %llu %.1f\n", frames_measured, (frames_measured) ? (double)frame_bytes_total / frames_measured : 0.0);
+
+	// Then the non-empty buckets of every histogram
+	fprintf(outfile, "# kind bucket_upper_us count\n");
+	for(int k = 0; k < NUM_LAT_KINDS; k++) {
+		for(int i = 0; i < LAT_BUCKETS; i++) {
+			if (histograms[k].counts[i])
+				fprintf(outfile, "%s %llu %llu\n", lat_names[k], bucket_upper(i), histograms[k].counts[i]);
+		}
+	}
+	fclose(outfile);
+
+	return true;
+}
+
+/**
+ * Mark the end of a startup phase, which started where the previous phase ended (or where
+ * the clock was started, for the first phase). Nothing is recorded unless the startup
+ * trace is turned on, nor after the last phase (the first frame painted) has been marked.
+ *
+ * 'phase' specifies the name of the phase (a string literal), or NULL to start the clock
+ *	(which is done even with the trace off, so it can start before the options are parsed).
+ * 'last' specifies whether this is the last phase of the startup.
+ */
+void lat_startup_phase(const char *phase, bool last) {
+	if (phase == NULL) {
+		startup_begin = lat_now();
+		return;
+	}
+	if (!startup_trace_enabled || startup_done) return;
+
+	unsigned long long now = lat_now();
+
+	if (startup_begin == 0) startup_begin = now;
+	if (startup_phases < LAT_STARTUP_PHASES) {
+		startup_names[startup_phases] = phase;
+		startup_ends[startup_phases++] = now;
+	}
+	if (last) startup_done = true;
+
+	return;
+}
+
+/**
+ * Print the time spent in each startup phase, and in the whole startup.
+ *
+ * 'outfile' specifies the stream to print to.
+ */
+void lat_startup_report(FILE *outfile) {
+	unsigned long long start = startup_begin;
+
+	fprintf(outfile, "# startup phase                  ms      total_ms\n");
+	for(int i = 0; i < startup_phases; i++) {
+		fprintf(outfile, "%-28s %8.3f %12.3f\n", startup_names[i], (startup_ends[i] - start) / 1000.0,
+			(startup_ends[i] - startup_begin) / 1000.0);
+		start = startup_ends[i];
+	}
+	if (!startup_done) fprintf(outfile, "# (no frame was painted)\n");
+
+	return;
+}
@@ -0,0 +1,163 @@
+#ifndef _LATENCY_H
+#define _LATENCY_H
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "iostat.h"
+
+#define LAT_SUB_BUCKETS 16	/* Buckets per power of two (~6% worst-case relative error) */
+#define LAT_OCTAVES 36		/* Powers of two covered above LAT_SUB_BUCKETS microseconds */
+#define LAT_BUCKETS (LAT_SUB_BUCKETS + (LAT_OCTAVES * LAT_SUB_BUCKETS))
+
+#define LAT_STARTUP_PHASES 16	/* Most startup phases that are timed */
+
+// Enumerated values representing the kinds of latency that are measured
+typedef enum {
+	LAT_THESEUS,		/* Key press to the frame showing Theseus' move */
+	LAT_MINOTAUR,		/* Scheduled Minotaur step to the frame showing it */
+	LAT_MENU,		/* Key press to the refreshed menu or message WINDOW */
+	NUM_LAT_KINDS
+}
+lat_kind;
+
+// Log-linear (HDR-style) histogram of latencies in microseconds
+struct lat_histogram {
+	unsigned long long counts[LAT_BUCKETS];
+	unsigned long long total;
+	unsigned long long sum;
+	unsigned long long max;
+};
+
+// Whether latency instrumentation is turned on (off by default)
+extern bool latency_enabled;
+
+// Whether the startup phases are timed (off by default, see lat_startup_phase())
+extern bool startup_trace_enabled;
+
+/**
+ * Get the current time in microseconds from the monotonic clock. Defined here so that code
+ * that only needs the clock (i.e the solver in libtheseus) doesn't link the latency globals.
+ */
+static inline unsigned long long lat_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((unsigned long long)ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000);
+}
+
+/**
+ * Add one latency value (in microseconds) to a histogram. Histograms that are not
+ * shared between threads can be used this way from any number of threads.
+ *
+ * 'hist' specifies the histogram to add the value to.
+ * 'value' specifies the latency in microseconds.
+ */
+void lat_hist_add(struct lat_histogram *hist, unsigned long long value);
+
+/**
+ * Add all the values of one histogram into another histogram.
+ *
+ * 'dest' specifies the histogram to add the values to.
+ * 'src' specifies the histogram to take the values from.
+ */
+void lat_hist_merge(struct lat_histogram *dest, const struct lat_histogram *src);
+
+/**
+ * Find the latency (in microseconds) below which a given fraction of the values of
+ * a histogram fall.
+ *
+ * 'hist' specifies the histogram to look at.
+ * 'fraction' specifies the percentile as a fraction (i.e 0.99 for p99).
+ *
+ * Return Value:
+ *	The function returns the upper bound of the bucket holding the percentile,
+ *	or 0 if the histogram is empty.
+ */
+unsigned long long lat_hist_percentile(const struct lat_histogram *hist, double fraction);
+
+/**
+ * Timestamp an input event, such as the return of getch(). The next call to
+ * lat_record() measures its latency from this point.
+ */
+void lat_mark(void);
+
+/**
+ * Record the time since the last call to lat_mark() into the histogram for the
+ * specified kind of latency. Nothing is recorded if no event has been marked.
+ *
+ * 'kind' specifies which histogram to record into.
+ */
+void lat_record(lat_kind kind);
+
+/**
+ * Measure the output of a frame. Called by flush_frame() right before and right
+ * after the virtual screen is copied to the terminal.
+ *
+ * 'done' specifies whether the frame has finished being flushed.
+ */
+void lat_frame(bool done);
+
+/**
+ * Find the latency (in microseconds) below which a given fraction of the recorded
+ * values for a kind of latency fall.
+ *
+ * 'kind' specifies which histogram to look at.
+ * 'fraction' specifies the percentile as a fraction (i.e 0.99 for p99).
+ *
+ * Return Value:
+ *	The function returns the upper bound of the bucket holding the percentile,
+ *	or 0 if nothing has been recorded.
+ */
+unsigned long long lat_percentile(lat_kind kind, double fraction);
+
+/**
+ * Get the number of values that have been recorded for a kind of latency.
+ */
+unsigned long long lat_count(lat_kind kind);
+
+/**
+ * Get the average number of bytes written to the terminal per frame, and the number
+ * of bytes written for the last frame.
+ *
+ * 'last' receives the number of bytes of the last frame (may be NULL).
+ *
+ * Return Value:
+ *	The function returns the average bytes per frame, or -1 if unknown.
+ */
+double lat_bytes_per_frame(unsigned long long *last);
+
+/**
+ * Write all the latency histograms and the per-frame output statistics to a file.
+ *
+ * 'file_path' specifies the file to write to.
+ *
+ * Return Values:
+ *	true - The file was written.
+ *	false - The file could not be opened for writing.
+ */
+bool lat_dump(const char *file_path);
+
+/**
+ * Mark the end of a startup phase, which started where the previous phase ended (or where
+ * the clock was started, for the first phase). Nothing is recorded unless the startup
+ * trace is turned on, nor after the last phase (the first frame painted) has been marked.
+ *
+ * 'phase' specifies the name of the phase (a string literal), or NULL to start the clock
+ *	(which is done even with the trace off, so it can start before the options are parsed).
+ * 'last' specifies whether this is the last phase of the startup.
+ */
+void lat_startup_phase(const char *phase, bool last);
+
+/**
+ * Print the time spent in each startup phase, and in the whole startup.
+ *
+ * 'outfile' specifies the stream to print to.
+ */
+void lat_startup_report(FILE *outfile);
+
+#endif	    // _LATENCY_H
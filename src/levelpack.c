@@ -0,0 +1,160 @@
+#include "levelpack.h"
+
+/**
+ * Make a level list of the level pack compiled into the game, without reading any file.
+ * The paths of the list are the pack's own strings, which is how read_level() and
+ * find_packed_level() tell a packed level from a level file with the same path.
+ *
+ * 'list' receives the level list (free it with free_level_list()). It is left empty
+ * if memory for it could not be allocated.
+ *
+ * Return Values:
+ *	true - The list was made.
+ *	false - Memory for the list could not be allocated.
+ */
+bool packed_level_list(struct level_list *list) {
+	list->text = NULL;
+	list->paths = malloc(sizeof(char *) * level_pack_size);
+	list->num_levels = 0;
+	if (list->paths == NULL) return false;
+
+	// The list is never written to, so it can point at the pack's read-only strings
+	for(int i = 0; i < level_pack_size; i++)
+		list->paths[i] = (char *)level_pack[i].path;
+	list->num_levels = level_pack_size;
+
+	return true;
+}
+
+/**
+ * Make the catalog of the level pack compiled into the game from the metrics packed
+ * with its levels (see read_catalog()).
+ *
+ * 'entries' receives an array of catalog entries (free it with free()), in list order.
+ *
+ * Return Value:
+ *	The function returns the number of entries, or -1 if the pack was built without a
+ *	catalog or memory for the entries could not be allocated.
+ */
+int packed_catalog(struct catalog_entry **entries) {
+	int count = 0;
+
+	for(int i = 0; i < level_pack_size; i++)
+		count += level_pack[i].has_metrics;
+	if (count == 0) return -1;
+
+	*entries = malloc(sizeof(struct catalog_entry) * count);
+	if (*entries == NULL) return -1;
+
+	count = 0;
+	for(int i = 0; i < level_pack_size; i++) {
+		if (!level_pack[i].has_metrics) continue;
+
+		snprintf((*entries)[count].path, CATALOG_PATH_LENGTH, "%s", level_pack[i].path);
+		(*entries)[count++].metrics = level_pack[i].metrics;
+	}
+
+	return count;
+}
+
+/**
+ * Find the packed level named by a level file path. Only the path strings of a list made
+ * by packed_level_list() name packed levels: a level list read from a file always names
+ * level files, even if its paths are the same as the pack's.
+ *
+ * Return Value:
+ *	The function returns the index of the level in 'level_pack', or -1 if the path
+ *	doesn't name a packed level.
+ */
+int find_packed_level(const char *file_path) {
+	for(int i = 0; i < level_pack_size; i++)
+		if (file_path == level_pack[i].path) return i;
+
+	return -1;
+}
+
+// Copy everything but the walls of a packed level into a stats structure
+static void unpack_level(const struct packed_level *packed, struct stats *board) {
+	board->rules = packed->rules;
+	board->size = packed->size;
+	board->exit.relation.row = packed->exit.row;
+	board->exit.relation.col = packed->exit.col;
+	board->exit.location = packed->exit.location;
+	board->exit.next = NULL;
+
+	board->theseus = packed->theseus;
+	memcpy(board->minotaurs, packed->minotaurs, sizeof(board->minotaurs));
+	board->num_minotaurs = packed->num_minotaurs;
+	board->walls = NULL;
+
+	return;
+}
+
+/**
+ * Read a level from the level pack compiled into the game if 'file_path' names one (see
+ * find_packed_level()), else from its level file (see read_level_file()). A packed level
+ * is copied into the stats structure without any file being read or checked again.
+ *
+ * 'file_path' specifies the file path of the level.
+ * 'board' is a stats structure in which to copy the level.
+ *
+ * Error Codes:
+ *	Same as the error codes of read_level_file() (7 if memory for the walls of a packed
+ *	level could not be allocated).
+ */
+int read_level(const char *file_path, struct stats *board) {
+	int index = find_packed_level(file_path);
+	if (index < 0) return read_level_file(file_path, board);
+
+	const struct packed_level *packed = &level_pack[index];
+	unpack_level(packed, board);
+
+	// Link the walls in the order of the level file, as read_level_file() does
+	cell_rel **link = &board->walls;
+	for(int i = 0; i < packed->num_walls; i++) {
+		cell_rel *wall = malloc(sizeof(cell_rel));
+		if (wall == NULL) {
+			free_walls(board->walls);
+			board->walls = NULL;
+			return 7;
+		}
+
+		wall->relation.row = packed->walls[i].row;
+		wall->relation.col = packed->walls[i].col;
+		wall->location = packed->walls[i].location;
+		wall->next = NULL;
+		*link = wall;
+		link = &wall->next;
+	}
+
+	return 0;
+}
+
+/**
+ * Build an engine_level structure for a level named by a level file path (see read_level()).
+ * A packed level is built from its packed move masks, without walking its walls.
+ *
+ * 'level' specifies the engine_level structure to initialize (free it with engine_free()).
+ * 'file_path' specifies the file path of the level.
+ *
+ * Return Values:
+ *	true - The level was built.
+ *	false - The level file could not be read, or memory for the level could not be allocated.
+ */
+bool load_level_engine(struct engine_level *level, const char *file_path) {
+	struct stats board;
+	int index = find_packed_level(file_path);
+
+	if (index >= 0) {
+		unpack_level(&level_pack[index], &board);
+		return engine_load_masks(level, &board, level_pack[index].masks);
+	}
+
+	board.walls = NULL;
+	if (read_level_file(file_path, &board) != 0) return false;
+
+	bool loaded = engine_load(level, &board);
+	free_walls(board.walls);
+
+	return loaded;
+}
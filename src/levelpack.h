@@ -0,0 +1,107 @@
+#ifndef _LEVELPACK_H
+#define _LEVELPACK_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "analysis.h"
+#include "engine.h"
+#include "loader.h"
+
+// Structure to hold one wall (or the exit) of a packed level: a square and one of its sides
+struct packed_side {
+	short row;
+	short col;
+	short location;
+};
+
+// Structure to hold a level compiled into the game (see tools/pack_levels.c), checked when the game was built
+struct packed_level {
+	const char *path;		/* File path of the level in the level list it was packed from */
+	struct rules rules;
+	struct dimensions size;
+	struct packed_side exit;
+
+	cell_pos theseus;
+	cell_pos minotaurs[MAX_MINOTAURS];	/* In the order they move */
+	short num_minotaurs;
+
+	const struct packed_side *walls;	/* In the order of the level file */
+	int num_walls;
+	const unsigned char *masks;	/* Bit-mask of valid moves for each square (see compute_move_masks()) */
+
+	bool has_metrics;		/* The list's catalog had the level's metrics */
+	struct level_metrics metrics;
+};
+
+// The level pack compiled into the game (generated in levelpack_data.c by 'make' from Levels/levellist.txt)
+extern const struct packed_level level_pack[];
+extern const int level_pack_size;
+
+/**
+ * Make a level list of the level pack compiled into the game, without reading any file.
+ * The paths of the list are the pack's own strings, which is how read_level() and
+ * find_packed_level() tell a packed level from a level file with the same path.
+ *
+ * 'list' receives the level list (free it with free_level_list()). It is left empty
+ * if memory for it could not be allocated.
+ *
+ * Return Values:
+ *	true - The list was made.
+ *	false - Memory for the list could not be allocated.
+ */
+bool packed_level_list(struct level_list *list);
+
+/**
+ * Make the catalog of the level pack compiled into the game from the metrics packed
+ * with its levels (see read_catalog()).
+ *
+ * 'entries' receives an array of catalog entries (free it with free()), in list order.
+ *
+ * Return Value:
+ *	The function returns the number of entries, or -1 if the pack was built without a
+ *	catalog or memory for the entries could not be allocated.
+ */
+int packed_catalog(struct catalog_entry **entries);
+
+/**
+ * Find the packed level named by a level file path. Only the path strings of a list made
+ * by packed_level_list() name packed levels: a level list read from a file always names
+ * level files, even if its paths are the same as the pack's.
+ *
+ * Return Value:
+ *	The function returns the index of the level in 'level_pack', or -1 if the path
+ *	doesn't name a packed level.
+ */
+int find_packed_level(const char *file_path);
+
+/**
+ * Read a level from the level pack compiled into the game if 'file_path' names one (see
+ * find_packed_level()), else from its level file (see read_level_file()). A packed level
+ * is copied into the stats structure without any file being read or checked again.
+ *
+ * 'file_path' specifies the file path of the level.
+ * 'board' is a stats structure in which to copy the level.
+ *
+ * Error Codes:
+ *	Same as the error codes of read_level_file() (7 if memory for the walls of a packed
+ *	level could not be allocated).
+ */
+int read_level(const char *file_path, struct stats *board);
+
+/**
+ * Build an engine_level structure for a level named by a level file path (see read_level()).
+ * A packed level is built from its packed move masks, without walking its walls.
+ *
+ * 'level' specifies the engine_level structure to initialize (free it with engine_free()).
+ * 'file_path' specifies the file path of the level.
+ *
+ * Return Values:
+ *	true - The level was built.
+ *	false - The level file could not be read, or memory for the level could not be allocated.
+ */
+bool load_level_engine(struct engine_level *level, const char *file_path);
+
+#endif	    // _LEVELPACK_H
@@ -0,0 +1,506 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "libtheseus.h"
+#include "engine.h"
+#include "loader.h"
+#include "solver.h"
+
+/*
+ * The public structures are the engine's own (so that batches are stepped in place, without
+ * copying): each of these typedefs fails to compile if the two stop matching.
+ */
+typedef char th_check_minotaurs[(TH_MAX_MINOTAURS == MAX_MINOTAURS) ? 1 : -1];
+typedef char th_check_skip[(TH_SKIP == SKIP_MOVE && TH_LEFT == LEFT && TH_DOWN == DOWN) ? 1 : -1];
+typedef char th_check_state[(sizeof(struct th_state) == sizeof(struct engine_state) && offsetof(struct th_state, actions) == offsetof(struct engine_state, actions)) ? 1 : -1];
+typedef char th_check_result[(sizeof(th_result) == sizeof(engine_result) && TH_CAUGHT == (int)ENGINE_CAUGHT) ? 1 : -1];
+typedef char th_check_search[(TH_SEARCH_BIDIRECTIONAL == (int)SEARCH_BIDIRECTIONAL) ? 1 : -1];
+
+// Letters for the moves of a solution (indexed by move, TH_SKIP last)
+static const char move_letters[] = "LRUDS";
+
+// Structure to hold a loaded level
+struct th_level {
+	struct engine_level level;
+};
+
+// Structure to hold a vectorized environment (games are split into one run of consecutive games per level)
+struct th_vec {
+	int num_levels;
+	int num_envs;
+	int max_steps;
+	int rows;			/* Size of an observation plane (the largest board) */
+	int cols;
+	size_t plane_size;
+	size_t obs_size;		/* Bytes of one game's observation */
+
+	const struct engine_level **boards;	/* Level of each run */
+	int *run_start;			/* First game of each run ('num_levels' + 1 entries, the last one is 'num_envs') */
+	int **grid;			/* Square of the observation planes for each cell of a run's level */
+	unsigned char **still;		/* Planes that never change, for each run's level */
+
+	struct engine_state *states;
+	struct engine_state *before;	/* States before the last step */
+	engine_result *results;
+	int *steps;			/* Steps since each game was started */
+
+	unsigned char *obs;		/* The caller's buffers */
+	float *rewards;
+	unsigned char *dones;
+};
+
+/**
+ * Load a level from a buffer holding a level file (the same format as the files in Levels/).
+ *
+ * 'buffer' specifies the text of the level file (it doesn't need to end with a '\0').
+ * 'length' specifies the number of bytes in 'buffer'.
+ * 'level' receives the loaded level (free it with th_level_free()).
+ *
+ * Error Codes:
+ *	0 - The level was loaded.
+ *	1 - Memory for the level could not be allocated.
+ *	2 to 8 - The level is invalid (see the error codes of read_level_file()).
+ */
+int th_level_load(const char *buffer, size_t length, th_level **level) {
+	struct stats board;
+	FILE *stream = fmemopen((void *)buffer, length, "r");
+
+	*level = NULL;
+	if (stream == NULL) return 1;
+
+	board.walls = NULL;
+	int result = read_level_stream(stream, &board);
+	if (result != 0) return result;
+
+	th_level *loaded = malloc(sizeof(th_level));
+	if (loaded == NULL || !engine_load(&loaded->level, &board)) {
+		free(loaded);
+		free_walls(board.walls);
+		return 1;
+	}
+	free_walls(board.walls);
+
+	*level = loaded;
+	return 0;
+}
+
+/**
+ * Free a level loaded with th_level_load().
+ */
+void th_level_free(th_level *level) {
+	if (level == NULL) return;
+
+	engine_free(&level->level);
+	free(level);
+
+	return;
+}
+
+/**
+ * Get the size of a level and its number of Minotaurs. Any of the pointers may be NULL.
+ *
+ * 'level' specifies the level.
+ * 'rows' receives the number of rows of the board.
+ * 'cols' receives the number of columns of the board.
+ * 'num_minotaurs' receives the number of Minotaurs.
+ */
+void th_level_info(const th_level *level, int *rows, int *cols, int *num_minotaurs) {
+	if (rows != NULL) *rows = level->level.num_rows;
+	if (cols != NULL) *cols = level->level.num_cols;
+	if (num_minotaurs != NULL) *num_minotaurs = level->level.num_minotaurs;
+
+	return;
+}
+
+/**
+ * Put the characters of a game on their starting squares.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the game to reset.
+ */
+void th_reset(const th_level *level, struct th_state *state) {
+	engine_reset(&level->level, (struct engine_state *)state);
+
+	return;
+}
+
+/**
+ * Play one move of Theseus (or skip it with TH_SKIP). Once Theseus has made all of his
+ * moves for the turn, every Minotaur takes his steps. An invalid move leaves the game
+ * untouched.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the game (updated in place).
+ * 'move' specifies the move.
+ *
+ * Return Value:
+ *	The function returns the outcome of the move.
+ */
+th_result th_step(const th_level *level, struct th_state *state, th_move move) {
+	return (th_result)engine_turn(&level->level, (struct engine_state *)state, move);
+}
+
+/**
+ * Play one move (as with th_step()) in each of a batch of games of the same level. Games
+ * that are already over must not be stepped again.
+ *
+ * 'level' specifies the level being played by every game.
+ * 'states' specifies the games (updated in place).
+ * 'move_list' specifies the move for each game.
+ * 'results' receives the outcome of the move for each game.
+ * 'count' specifies the number of games.
+ */
+void th_step_batch(const th_level *level, struct th_state *states, const th_move *move_list, th_result *results, long count) {
+	engine_step_batch(&level->level, (struct engine_state *)states, move_list, (engine_result *)results, count);
+
+	return;
+}
+
+// Copy a solution of the solver into a public one (taking over its moves)
+static void export_solution(struct solution *from, struct th_solution *to) {
+	to->solvable = from->solvable ? 1 : 0;
+	to->turns = from->turns;
+	to->moves = from->moves;
+	to->states = from->states;
+	from->moves = NULL;
+
+	return;
+}
+
+/**
+ * Find the shortest way for Theseus to escape a level from its starting squares (see
+ * solve_level() for the search methods).
+ *
+ * 'level' specifies the level.
+ * 'method' specifies the search method.
+ * 'sol' receives the solution (free it with th_solution_free()).
+ *
+ * Error Codes:
+ *	0 - The level was searched ('sol->solvable' tells whether Theseus can escape).
+ *	1 - Memory for the search could not be allocated.
+ */
+int th_solve(const th_level *level, th_search method, struct th_solution *sol) {
+	struct solution found;
+
+	if (!solve_level(&level->level, (search_method)method, &found)) return 1;
+	export_solution(&found, sol);
+
+	return 0;
+}
+
+/**
+ * Free the memory held by a th_solution structure.
+ */
+void th_solution_free(struct th_solution *sol) {
+	free(sol->moves);
+	sol->moves = NULL;
+
+	return;
+}
+
+// Solve a level from the start of a turn in a game: returns the turns left (-1 if Theseus can't escape, -2 if out of memory)
+static int turns_left(const struct engine_level *level, const struct engine_state *state, th_move *first_move) {
+	struct engine_level from = *level;	/* Shares the masks: the solver only reads them */
+	struct solution sol;
+
+	from.theseus_start = state->theseus;
+	for(int i = 0; i < level->num_minotaurs; i++)
+		from.minotaur_starts[i] = state->minotaurs[i];
+
+	if (!solve_level(&from, SEARCH_BFS, &sol)) return -2;
+	if (!sol.solvable) {
+		free_solution(&sol);
+		return -1;
+	}
+
+	if (first_move != NULL) *first_move = (th_move)(strchr(move_letters, sol.moves[0]) - move_letters);
+	free_solution(&sol);
+
+	return sol.turns;
+}
+
+/**
+ * Find the move that gets Theseus out in the fewest turns from the current state of a game
+ * (which must not be over).
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the game.
+ * 'move' receives the move.
+ *
+ * Error Codes:
+ *	0 - A move was found.
+ *	1 - Theseus can no longer escape.
+ *	2 - Memory for the search could not be allocated.
+ */
+int th_hint(const th_level *level, const struct th_state *state, th_move *move) {
+	const struct engine_level *board = &level->level;
+	const struct engine_state *game = (const struct engine_state *)state;
+
+	if (game->actions == 0) {
+		int turns = turns_left(board, game, move);
+		return (turns >= 0) ? 0 : ((turns == -1) ? 1 : 2);
+	}
+
+	/*
+	 * In the middle of a turn (Theseus makes at most MAX_THESEUS_STEPS moves) the solver
+	 * can't start from the game, so each move that ends the turn is tried and solved from
+	 * where it leads.
+	 */
+	int best = -1;
+
+	for(th_move next = 0; next <= TH_SKIP; next++) {
+		struct engine_state after = *game;
+		int turns;
+
+		switch (engine_turn(board, &after, next)) {
+			case ENGINE_ESCAPED:
+				*move = next;
+				return 0;
+
+			case ENGINE_MOVED:
+				turns = turns_left(board, &after, NULL);
+				break;
+
+			default:
+				continue;
+		}
+
+		if (turns == -2) return 2;
+		if (turns >= 0 && (best < 0 || turns < best)) {
+			best = turns;
+			*move = next;
+		}
+	}
+
+	return (best >= 0) ? 0 : 1;
+}
+
+/**
+ * Get the shape of one game's observation in a vectorized environment of some levels:
+ * TH_OBS_PLANES planes of 'rows' by 'cols' bytes (the largest board of the levels), so
+ * that the buffers can be allocated before th_vec_new(). 'rows' and 'cols' may be NULL.
+ *
+ * 'levels' specifies the levels.
+ * 'num_levels' specifies the number of levels.
+ * 'rows' receives the rows of a plane.
+ * 'cols' receives the columns of a plane.
+ *
+ * Return Value:
+ *	The function returns the bytes of one game's observation.
+ */
+size_t th_vec_shape(th_level *const *levels, int num_levels, int *rows, int *cols) {
+	int max_rows = 0, max_cols = 0;
+
+	for(int k = 0; k < num_levels; k++) {
+		if (levels[k]->level.num_rows > max_rows) max_rows = levels[k]->level.num_rows;
+		if (levels[k]->level.num_cols > max_cols) max_cols = levels[k]->level.num_cols;
+	}
+	if (rows != NULL) *rows = max_rows;
+	if (cols != NULL) *cols = max_cols;
+
+	return (size_t)TH_OBS_PLANES * max_rows * max_cols;
+}
+
+// Write the planes of a level that never change, and the square of every cell in the planes
+static void draw_still_planes(const th_vec *vec, const struct engine_level *level, unsigned char *still, int *grid) {
+	memset(still, 0, vec->obs_size);
+	for(int plane = TH_PLANE_WALL_LEFT; plane <= TH_PLANE_WALL_DOWN; plane++)
+		memset(still + (plane * vec->plane_size), 1, vec->plane_size);
+
+	for(int cell = 0; cell < level->num_cells; cell++) {
+		int square = ((cell / level->num_cols) * vec->cols) + (cell % level->num_cols);
+
+		grid[cell] = square;
+		for(int move = LEFT; move <= DOWN; move++)
+			still[((TH_PLANE_WALL_LEFT + move) * vec->plane_size) + square] = !(level->masks[cell] & moves[move]);
+		still[(TH_PLANE_BOARD * vec->plane_size) + square] = 1;
+	}
+	still[(TH_PLANE_EXIT * vec->plane_size) + grid[level->exit_cell]] = 1;
+
+	return;
+}
+
+// Put the characters of a game on (or take them off) its observation
+static inline void draw_characters(const th_vec *vec, unsigned char *obs, const int *grid, const struct engine_state *state, int num_minotaurs, bool shown) {
+	unsigned char *theseus = obs + (TH_PLANE_THESEUS * vec->plane_size);
+	unsigned char *minotaurs = obs + (TH_PLANE_MINOTAUR * vec->plane_size);
+
+	theseus[grid[state->theseus]] = shown ? (unsigned char)(1 + state->actions) : 0;
+	for(int i = 0; i < num_minotaurs; i++)
+		minotaurs[grid[state->minotaurs[i]]] = shown;
+
+	return;
+}
+
+/**
+ * Create a vectorized environment for reinforcement learning: 'num_envs' games played side
+ * by side, split into equal runs of consecutive games, one run per level (in the order of
+ * 'levels'). Every step writes the observations, rewards and done flags straight into
+ * buffers owned by the caller:
+ *
+ *	obs - unsigned char[num_envs][TH_OBS_PLANES][rows][cols] (see th_vec_shape())
+ *	rewards - float[num_envs]
+ *	dones - unsigned char[num_envs] (TH_RUNNING, TH_TERMINATED or TH_TRUNCATED)
+ *
+ * The observations are kept up to date in place: the planes that never change are written
+ * by th_vec_reset() and each step only touches the squares the characters leave and
+ * enter, so the buffers must not be changed by the caller between steps.
+ *
+ * 'levels' specifies the levels (they must outlive the environment).
+ * 'num_levels' specifies the number of levels (at most 'num_envs').
+ * 'num_envs' specifies the number of games.
+ * 'max_steps' specifies the steps after which a game is truncated (0 for no limit).
+ * 'obs', 'rewards' and 'dones' specify the output buffers.
+ *
+ * Return Value:
+ *	The function returns the environment (free it with th_vec_free()), or NULL if the
+ *	arguments are invalid or memory could not be allocated.
+ */
+th_vec *th_vec_new(th_level *const *levels, int num_levels, int num_envs, int max_steps,
+		   unsigned char *obs, float *rewards, unsigned char *dones) {
+	if (num_levels < 1 || num_envs < num_levels || obs == NULL || rewards == NULL || dones == NULL) return NULL;
+
+	th_vec *vec = calloc(1, sizeof(th_vec));
+	if (vec == NULL) return NULL;
+
+	vec->num_levels = num_levels;
+	vec->num_envs = num_envs;
+	vec->max_steps = max_steps;
+	vec->obs_size = th_vec_shape(levels, num_levels, &vec->rows, &vec->cols);
+	vec->plane_size = (size_t)vec->rows * vec->cols;
+	vec->obs = obs;
+	vec->rewards = rewards;
+	vec->dones = dones;
+
+	vec->boards = malloc(sizeof(struct engine_level *) * num_levels);
+	vec->run_start = malloc(sizeof(int) * (num_levels + 1));
+	vec->grid = calloc(num_levels, sizeof(int *));
+	vec->still = calloc(num_levels, sizeof(unsigned char *));
+	vec->states = malloc(sizeof(struct engine_state) * num_envs);
+	vec->before = malloc(sizeof(struct engine_state) * num_envs);
+	vec->results = malloc(sizeof(engine_result) * num_envs);
+	vec->steps = calloc(num_envs, sizeof(int));
+
+	bool ok = (vec->boards != NULL && vec->run_start != NULL && vec->grid != NULL && vec->still != NULL &&
+		   vec->states != NULL && vec->before != NULL && vec->results != NULL && vec->steps != NULL);
+
+	for(int k = 0; ok && k < num_levels; k++) {
+		const struct engine_level *level = &levels[k]->level;
+
+		vec->boards[k] = level;
+		vec->run_start[k] = (int)(((long long)k * num_envs) / num_levels);
+		vec->grid[k] = malloc(sizeof(int) * level->num_cells);
+		vec->still[k] = malloc(vec->obs_size);
+		ok = (vec->grid[k] != NULL && vec->still[k] != NULL);
+		if (ok) draw_still_planes(vec, level, vec->still[k], vec->grid[k]);
+	}
+	if (!ok) {
+		th_vec_free(vec);
+		return NULL;
+	}
+	vec->run_start[num_levels] = num_envs;
+
+	th_vec_reset(vec);
+
+	return vec;
+}
+
+/**
+ * Free a vectorized environment (the levels and the caller's buffers are left alone).
+ */
+void th_vec_free(th_vec *vec) {
+	if (vec == NULL) return;
+
+	for(int k = 0; k < vec->num_levels && vec->grid != NULL && vec->still != NULL; k++) {
+		free(vec->grid[k]);
+		free(vec->still[k]);
+	}
+	free(vec->boards);
+	free(vec->run_start);
+	free(vec->grid);
+	free(vec->still);
+	free(vec->states);
+	free(vec->before);
+	free(vec->results);
+	free(vec->steps);
+	free(vec);
+
+	return;
+}
+
+/**
+ * Start every game of an environment over, rewrite all of the observations, and clear
+ * the rewards and done flags.
+ *
+ * 'vec' specifies the environment.
+ */
+void th_vec_reset(th_vec *vec) {
+	for(int k = 0; k < vec->num_levels; k++) {
+		const struct engine_level *level = vec->boards[k];
+
+		for(int i = vec->run_start[k]; i < vec->run_start[k + 1]; i++) {
+			unsigned char *obs = vec->obs + (i * vec->obs_size);
+
+			memcpy(obs, vec->still[k], vec->obs_size);
+			engine_reset(level, &vec->states[i]);
+			draw_characters(vec, obs, vec->grid[k], &vec->states[i], level->num_minotaurs, true);
+			vec->steps[i] = 0;
+			vec->rewards[i] = 0.0f;
+			vec->dones[i] = TH_RUNNING;
+		}
+	}
+
+	return;
+}
+
+/**
+ * Play one move in every game of an environment. A blocked move counts as a step that
+ * changes nothing. A game that ends gets its reward and done flag, and is started over
+ * right away: its observation is already the one of the new game.
+ *
+ * 'vec' specifies the environment.
+ * 'actions' specifies the move of each game (TH_LEFT to TH_SKIP).
+ */
+void th_vec_step(th_vec *vec, const th_move *actions) {
+	for(int k = 0; k < vec->num_levels; k++) {
+		const struct engine_level *level = vec->boards[k];
+		const int *grid = vec->grid[k];
+		int first = vec->run_start[k], count = vec->run_start[k + 1] - first;
+
+		// Step the whole run with the stepper of its rule variant, then bring the observations up to date
+		memcpy(&vec->before[first], &vec->states[first], sizeof(struct engine_state) * count);
+		engine_step_batch(level, &vec->states[first], &actions[first], &vec->results[first], count);
+
+		for(int i = first; i < first + count; i++) {
+			engine_result result = vec->results[i];
+			unsigned char *obs = vec->obs + (i * vec->obs_size);
+			unsigned char done = TH_RUNNING;
+			float reward = TH_REWARD_STEP;
+
+			vec->steps[i]++;
+			if (result == ENGINE_ESCAPED) {
+				reward = TH_REWARD_ESCAPED;
+				done = TH_TERMINATED;
+			}
+			else if (result == ENGINE_CAUGHT) {
+				reward = TH_REWARD_CAUGHT;
+				done = TH_TERMINATED;
+			}
+			else if (vec->max_steps > 0 && vec->steps[i] >= vec->max_steps) done = TH_TRUNCATED;
+
+			if (done != TH_RUNNING) {
+				engine_reset(level, &vec->states[i]);
+				vec->steps[i] = 0;
+			}
+			if (result != ENGINE_BLOCKED || done != TH_RUNNING) {
+				draw_characters(vec, obs, grid, &vec->before[i], level->num_minotaurs, false);
+				draw_characters(vec, obs, grid, &vec->states[i], level->num_minotaurs, true);
+			}
+
+			vec->rewards[i] = reward;
+			vec->dones[i] = done;
+		}
+	}
+
+	return;
+}
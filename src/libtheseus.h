@@ -0,0 +1,253 @@
+#ifndef _LIBTHESEUS_H
+#define _LIBTHESEUS_H
+
+/*
+ * libtheseus: the game's engine and solver as a library (built with 'make lib'), without
+ * ncurses. Levels are loaded from memory and are read-only once loaded, and every game
+ * lives in a th_state structure owned by the caller, so nothing is shared between calls:
+ * any number of threads may step, solve and ask for hints on the same level at once, as
+ * long as no two of them change the same th_state.
+ */
+
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define TH_API __attribute__((visibility("default")))
+#else
+#define TH_API
+#endif
+
+#define TH_MAX_MINOTAURS 4
+
+// Values of a move (the same as the engine's moves)
+#define TH_LEFT 0
+#define TH_RIGHT 1
+#define TH_UP 2
+#define TH_DOWN 3
+#define TH_SKIP 4		/* Skip Theseus' move */
+
+typedef short th_move;
+
+// Enumerated values representing the outcome of a move
+typedef enum {
+	TH_BLOCKED,		/* The move was invalid, nothing changed */
+	TH_MOVED,		/* The move was made and the game goes on */
+	TH_ESCAPED,		/* Theseus reached the exit */
+	TH_CAUGHT		/* A Minotaur caught Theseus */
+}
+th_result;
+
+// Enumerated values representing the search methods of th_solve()
+typedef enum {
+	TH_SEARCH_BFS,
+	TH_SEARCH_ASTAR,
+	TH_SEARCH_BIDIRECTIONAL
+}
+th_search;
+
+// Planes of an observation of th_vec (one byte per square each)
+#define TH_PLANE_WALL_LEFT 0	/* 1 where the move is blocked (a wall or the edge of the board) */
+#define TH_PLANE_WALL_RIGHT 1
+#define TH_PLANE_WALL_UP 2
+#define TH_PLANE_WALL_DOWN 3
+#define TH_PLANE_THESEUS 4	/* 1 + the moves Theseus has made in the turn, on his square */
+#define TH_PLANE_MINOTAUR 5	/* 1 on every Minotaur's square */
+#define TH_PLANE_EXIT 6		/* 1 on the exit square */
+#define TH_PLANE_BOARD 7	/* 1 on the squares of the level (levels smaller than the grid are padded) */
+#define TH_OBS_PLANES 8
+
+// Values of the done flags of th_vec
+#define TH_RUNNING 0
+#define TH_TERMINATED 1		/* Theseus escaped or was caught */
+#define TH_TRUNCATED 2		/* The game ran out of steps */
+
+// Rewards of th_vec
+#define TH_REWARD_ESCAPED 1.0f
+#define TH_REWARD_CAUGHT -1.0f
+#define TH_REWARD_STEP 0.0f
+
+// A loaded level (opaque)
+typedef struct th_level th_level;
+
+// A vectorized environment: many games of one or more levels stepped together (opaque)
+typedef struct th_vec th_vec;
+
+// Structure to hold the positions of the characters in a game (cell indexes: row * cols + col)
+struct th_state {
+	int theseus;
+	int minotaurs[TH_MAX_MINOTAURS];	/* Only the level's first 'num_minotaurs' are used */
+	short actions;				/* Moves Theseus has made so far in the current turn */
+};
+
+// Structure to hold the result of th_solve()
+struct th_solution {
+	int solvable;		/* 1 if Theseus can escape, else 0 */
+	int turns;		/* Turns needed to escape */
+	char *moves;		/* Theseus' moves as a string of L, R, U, D and S (skip), NULL if unsolvable */
+	long states;		/* Number of states visited by the search */
+};
+
+/**
+ * Load a level from a buffer holding a level file (the same format as the files in Levels/).
+ *
+ * 'buffer' specifies the text of the level file (it doesn't need to end with a '\0').
+ * 'length' specifies the number of bytes in 'buffer'.
+ * 'level' receives the loaded level (free it with th_level_free()).
+ *
+ * Error Codes:
+ *	0 - The level was loaded.
+ *	1 - Memory for the level could not be allocated.
+ *	2 to 8 - The level is invalid (see the error codes of read_level_file()).
+ */
+TH_API int th_level_load(const char *buffer, size_t length, th_level **level);
+
+/**
+ * Free a level loaded with th_level_load().
+ */
+TH_API void th_level_free(th_level *level);
+
+/**
+ * Get the size of a level and its number of Minotaurs. Any of the pointers may be NULL.
+ *
+ * 'level' specifies the level.
+ * 'rows' receives the number of rows of the board.
+ * 'cols' receives the number of columns of the board.
+ * 'num_minotaurs' receives the number of Minotaurs.
+ */
+TH_API void th_level_info(const th_level *level, int *rows, int *cols, int *num_minotaurs);
+
+/**
+ * Put the characters of a game on their starting squares.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the game to reset.
+ */
+TH_API void th_reset(const th_level *level, struct th_state *state);
+
+/**
+ * Play one move of Theseus (or skip it with TH_SKIP). Once Theseus has made all of his
+ * moves for the turn, every Minotaur takes his steps. An invalid move leaves the game
+ * untouched.
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the game (updated in place).
+ * 'move' specifies the move.
+ *
+ * Return Value:
+ *	The function returns the outcome of the move.
+ */
+TH_API th_result th_step(const th_level *level, struct th_state *state, th_move move);
+
+/**
+ * Play one move (as with th_step()) in each of a batch of games of the same level. Games
+ * that are already over must not be stepped again, and every move must be a valid move
+ * value (TH_LEFT to TH_SKIP).
+ *
+ * 'level' specifies the level being played by every game.
+ * 'states' specifies the games (updated in place).
+ * 'move_list' specifies the move for each game.
+ * 'results' receives the outcome of the move for each game.
+ * 'count' specifies the number of games.
+ */
+TH_API void th_step_batch(const th_level *level, struct th_state *states, const th_move *move_list, th_result *results, long count);
+
+/**
+ * Find the shortest way for Theseus to escape a level from its starting squares (see
+ * solve_level() for the search methods).
+ *
+ * 'level' specifies the level.
+ * 'method' specifies the search method.
+ * 'sol' receives the solution (free it with th_solution_free()).
+ *
+ * Error Codes:
+ *	0 - The level was searched ('sol->solvable' tells whether Theseus can escape).
+ *	1 - Memory for the search could not be allocated.
+ */
+TH_API int th_solve(const th_level *level, th_search method, struct th_solution *sol);
+
+/**
+ * Free the memory held by a th_solution structure.
+ */
+TH_API void th_solution_free(struct th_solution *sol);
+
+/**
+ * Find the move that gets Theseus out in the fewest turns from the current state of a game
+ * (which must not be over).
+ *
+ * 'level' specifies the level being played.
+ * 'state' specifies the game.
+ * 'move' receives the move.
+ *
+ * Error Codes:
+ *	0 - A move was found.
+ *	1 - Theseus can no longer escape.
+ *	2 - Memory for the search could not be allocated.
+ */
+TH_API int th_hint(const th_level *level, const struct th_state *state, th_move *move);
+
+/**
+ * Create a vectorized environment for reinforcement learning: 'num_envs' games played side
+ * by side, split into equal runs of consecutive games, one run per level (in the order of
+ * 'levels'). Every step writes the observations, rewards and done flags straight into
+ * buffers owned by the caller:
+ *
+ *	obs - unsigned char[num_envs][TH_OBS_PLANES][rows][cols] (see th_vec_shape())
+ *	rewards - float[num_envs]
+ *	dones - unsigned char[num_envs] (TH_RUNNING, TH_TERMINATED or TH_TRUNCATED)
+ *
+ * The observations are kept up to date in place: the planes that never change are written
+ * by th_vec_reset() and each step only touches the squares the characters leave and
+ * enter, so the buffers must not be changed by the caller between steps.
+ *
+ * 'levels' specifies the levels (they must outlive the environment).
+ * 'num_levels' specifies the number of levels (at most 'num_envs').
+ * 'num_envs' specifies the number of games.
+ * 'max_steps' specifies the steps after which a game is truncated (0 for no limit).
+ * 'obs', 'rewards' and 'dones' specify the output buffers.
+ *
+ * Return Value:
+ *	The function returns the environment (free it with th_vec_free()), or NULL if the
+ *	arguments are invalid or memory could not be allocated.
+ */
+TH_API th_vec *th_vec_new(th_level *const *levels, int num_levels, int num_envs, int max_steps,
+			  unsigned char *obs, float *rewards, unsigned char *dones);
+
+/**
+ * Free a vectorized environment (the levels and the caller's buffers are left alone).
+ */
+TH_API void th_vec_free(th_vec *vec);
+
+/**
+ * Get the shape of one game's observation in a vectorized environment of some levels:
+ * TH_OBS_PLANES planes of 'rows' by 'cols' bytes (the largest board of the levels), so
+ * that the buffers can be allocated before th_vec_new(). 'rows' and 'cols' may be NULL.
+ *
+ * 'levels' specifies the levels.
+ * 'num_levels' specifies the number of levels.
+ * 'rows' receives the rows of a plane.
+ * 'cols' receives the columns of a plane.
+ *
+ * Return Value:
+ *	The function returns the bytes of one game's observation.
+ */
+TH_API size_t th_vec_shape(th_level *const *levels, int num_levels, int *rows, int *cols);
+
+/**
+ * Start every game of an environment over, rewrite all of the observations, and clear
+ * the rewards and done flags.
+ *
+ * 'vec' specifies the environment.
+ */
+TH_API void th_vec_reset(th_vec *vec);
+
+/**
+ * Play one move in every game of an environment. A blocked move counts as a step that
+ * changes nothing. A game that ends gets its reward and done flag, and is started over
+ * right away: its observation is already the one of the new game.
+ *
+ * 'vec' specifies the environment.
+ * 'actions' specifies the move of each game (TH_LEFT to TH_SKIP).
+ */
+TH_API void th_vec_step(th_vec *vec, const th_move *actions);
+
+#endif	    // _LIBTHESEUS_H
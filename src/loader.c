@@ -1,5 +1,5 @@
 #include "loader.h"
-#include "movement.h"
+#include "engine.h"
 #include "scans.h"
 
 /**
@@ -7,7 +7,10 @@
  * scan the entire file into a stats structure, making sure that all scanned data is
  * valid. The function scans in the dimensions for a board, the relative position of
  * an exit square, the starting positions of Theseus and the Minotaur, as well as the
- * relative positions of all "walls" found in the specified file.
+ * relative positions of all "walls" found in the specified file. The file may start with
+ * header lines: "rules <minotaur steps> <h|v> <theseus steps>" picks a rule variant (the
+ * original rules are rules 2 h 1), and "minotaurs <count>" gives the number of Minotaur
+ * lines that follow Theseus' line (one by default).
  *
  * 'file_path' is a string literal that specifies the path of the file to be scanned.
  * 'board' is a stats structure in which to copy the scanned data.
@@ -18,9 +21,10 @@
  *	2 - Invalid board dimensions were scanned.
  *	3 - Invalid relative position of exit square was scanned.
  *	4 - Invalid starting position for Theseus was scanned.
- *	5 - Invalid starting position for Minotaur was scanned.
+ *	5 - Invalid starting position for a Minotaur was scanned.
  *	6 - Invalid relative position of a "wall" was scanned.
  *	7 - Unknown function exited with return value of 1.
+ *	8 - Invalid header line was scanned.
  */
 int read_level_file(const char *file_path, struct stats *board) {
 
@@ -28,8 +32,25 @@ int read_level_file(const char *file_path, struct stats *board) {
 	FILE *level_file = fopen(file_path, "r");
 	if (level_file == NULL) return 1;
 
+	return read_level_stream(level_file, board);
+}
+
+/**
+ * Scan an entire level from an already opened stream into a stats structure, making sure
+ * that all scanned data is valid. This is the same as read_level_file() but works with any
+ * FILE pointer, so levels can also be read from pipes or from memory (see fmemopen()).
+ * The stream is closed by this function, whether the level is valid or not.
+ *
+ * 'level_file' specifies the stream to scan the level from.
+ * 'board' is a stats structure in which to copy the scanned data.
+ *
+ * Error Codes:
+ *	Same as the error codes of read_level_file() (1 is never returned).
+ */
+int read_level_stream(FILE *level_file, struct stats *board) {
+
 	// Create an array of pointers to the scanner functions
-	int (*scanners[])(FILE *, struct stats *) = {scan_dimensions, scan_exit, scan_theseus, scan_minotaur, scan_walls};
+	int (*scanners[])(FILE *, struct stats *) = {scan_header, scan_dimensions, scan_exit, scan_theseus, scan_minotaur, scan_walls};
 
 	// Perform each scanner function in order
 	for(int i = 0; i < NUM_SCANS; i++) {
@@ -37,6 +58,9 @@ int read_level_file(const char *file_path, struct stats *board) {
 			
 			// Return the correct error code based on failed scanner function
 			switch (i) {
+				case HEADER:
+					return 8;
+
 				case DIMENSIONS:
 					return 2;
 
@@ -62,6 +86,140 @@ int read_level_file(const char *file_path, struct stats *board) {
 	return 0;
 }
 
+/**
+ * Write a level to a level file, in the format read by read_level_file(): the header
+ * lines (only those that differ from the defaults), the dimensions, the exit, Theseus,
+ * each Minotaur, and one line per wall. The level is written to a temporary file next
+ * to 'file_path' that then replaces it, so the file is never left half written.
+ *
+ * 'file_path' specifies the file path to write the level to.
+ * 'board' specifies the stats structure that holds the level.
+ *
+ * Error Codes:
+ *	0 - No error was encountered.
+ *	1 - The file could not be written.
+ *	2 - Memory for the temporary file path could not be allocated.
+ */
+int write_level_file(const char *file_path, const struct stats *board) {
+	char *temp_path = malloc(strlen(file_path) + sizeof(".tmp"));
+	if (temp_path == NULL) return 2;
+	sprintf(temp_path, "%s.tmp", file_path);
+
+	FILE *level_file = fopen(temp_path, "w");
+	if (level_file == NULL) {
+		free(temp_path);
+		return 1;
+	}
+
+	// Header lines are only needed for levels that don't use the original rules and one Minotaur
+	if (board->rules.minotaur_steps != DEFAULT_MINOTAUR_STEPS || board->rules.theseus_steps != DEFAULT_THESEUS_STEPS
+	    || board->rules.vertical_first)
+		fprintf(level_file, "rules %hd %c %hd\n", board->rules.minotaur_steps, board->rules.vertical_first ? 'v' : 'h', board->rules.theseus_steps);
+	if (board->num_minotaurs != 1)
+		fprintf(level_file, "minotaurs %hd\n", board->num_minotaurs);
+
+	fprintf(level_file, "%hd %hd\n", board->size.num_rows, board->size.num_cols);
+	fprintf(level_file, "%hd %hd %hd\n", board->exit.relation.row, board->exit.relation.col, board->exit.location);
+	fprintf(level_file, "%hd %hd\n", board->theseus.row, board->theseus.col);
+	for(int i = 0; i < board->num_minotaurs; i++)
+		fprintf(level_file, "%hd %hd\n", board->minotaurs[i].row, board->minotaurs[i].col);
+	for(const cell_rel *wall = board->walls; wall != NULL; wall = wall->next)
+		fprintf(level_file, "%hd %hd %hd\n", wall->relation.row, wall->relation.col, wall->location);
+
+	// Only replace the level file once the whole level has reached the temporary file
+	bool written = !ferror(level_file);
+	if (fclose(level_file) != 0) written = false;
+	if (written && rename(temp_path, file_path) != 0) written = false;
+	if (!written) remove(temp_path);
+	free(temp_path);
+
+	return written ? 0 : 1;
+}
+
+/**
+ * Read a level list with a single read of the whole file, and index its level file paths
+ * in place (the paths point into the file's text, so nothing is copied per level). Empty
+ * lines are skipped. The levels themselves are only read when they are played.
+ *
+ * 'file_path' specifies the file path of the level list.
+ * 'list' receives the level list (free it with free_level_list()). It is left empty
+ * if the list can't be read.
+ *
+ * Error Codes:
+ *	0 - No error was encountered.
+ *	1 - The file could not be opened or read.
+ *	2 - Memory for the list could not be allocated.
+ */
+int read_level_list(const char *file_path, struct level_list *list) {
+	struct stat info;
+	ssize_t got;
+	size_t length = 0;
+
+	list->text = NULL;
+	list->paths = NULL;
+	list->num_levels = 0;
+
+	int fd = open(file_path, O_RDONLY);
+	if (fd < 0) return 1;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		return 1;
+	}
+
+	// Read the whole file at once (a regular file needs a single read)
+	char *text = malloc(info.st_size + 1);
+	if (text == NULL) {
+		close(fd);
+		return 2;
+	}
+	while (length < (size_t)info.st_size && (got = read(fd, text + length, info.st_size - length)) > 0)
+		length += got;
+	close(fd);
+	text[length] = '\0';
+
+	// Index the lines: at most one path per newline, plus an unterminated last line
+	int max_levels = 1;
+	for(char *c = memchr(text, '\n', length); c != NULL; c = memchr(c + 1, '\n', text + length - (c + 1)))
+		max_levels++;
+
+	char **paths = malloc(sizeof(char *) * max_levels);
+	if (paths == NULL) {
+		free(text);
+		return 2;
+	}
+
+	int num_levels = 0;
+	for(char *line = text; line < text + length; ) {
+		char *end = memchr(line, '\n', text + length - line);
+		if (end == NULL) end = text + length;
+
+		*end = '\0';
+		if (end > line && end[-1] == '\r') end[-1] = '\0';
+		if (line[0] != '\0') paths[num_levels++] = line;
+
+		line = end + 1;
+	}
+
+	list->text = text;
+	list->paths = paths;
+	list->num_levels = num_levels;
+
+	return 0;
+}
+
+/**
+ * Free the memory of a level list read with read_level_list().
+ */
+void free_level_list(struct level_list *list) {
+	free(list->paths);
+	free(list->text);
+	list->paths = NULL;
+	list->text = NULL;
+	list->num_levels = 0;
+
+	return;
+}
+
 /**
  * Scan data from a specified file into a single cell_rel structure. Also check for
  * invalid data. The validity of scanned data is determined by the given dimensions of
@@ -1,15 +1,25 @@
 #ifndef _LOADER_H
 #define _LOADER_H
 
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define MIN_BOARD_X 3
 #define MIN_BOARD_Y 3
 #define MAX_BOARD_X 20
 #define MAX_BOARD_Y 10
 
+#define DEFAULT_MINOTAUR_STEPS 2
+#define MAX_MINOTAUR_STEPS 3
+#define DEFAULT_THESEUS_STEPS 1
+#define MAX_THESEUS_STEPS 2
+#define MAX_MINOTAURS 4
+
 // Structure to hold dimensions of a board
 struct dimensions {
 	short num_rows;
@@ -31,23 +41,42 @@ typedef struct cell_rel {
 }
 cell_rel;
 
+// Structure to hold the rule variant of a level (see the optional "rules" header line)
+struct rules {
+	short minotaur_steps;		/* Steps the Minotaur takes per turn */
+	short theseus_steps;		/* Moves Theseus makes per turn */
+	bool vertical_first;		/* The Minotaur tries vertical moves before horizontal moves */
+};
+
 // Structure to hold all the information needed for a board
 struct stats {
+	struct rules rules;
 	struct dimensions size;
 	cell_rel exit;
 
 	cell_pos theseus;
-	cell_pos minotaur;
+	cell_pos minotaurs[MAX_MINOTAURS];	/* In the order they move */
+	short num_minotaurs;
 
 	cell_rel *walls;
 };
 
+// Structure to hold a level list (one level file path per line, like Levels/levellist.txt)
+struct level_list {
+	char *text;		/* The whole list file, with every line ended by '\0' in place */
+	char **paths;		/* Start of each level file path in 'text' */
+	int num_levels;
+};
+
 /**
  * Take in a string of text referencing an external 'level' file for the game. Then
  * scan the entire file into a stats structure, making sure that all scanned data is
  * valid. The function scans in the dimensions for a board, the relative position of
  * an exit square, the starting positions of Theseus and the Minotaur, as well as the
- * relative positions of all "walls" found in the specified file.
+ * relative positions of all "walls" found in the specified file. The file may start with
+ * header lines: "rules <minotaur steps> <h|v> <theseus steps>" picks a rule variant (the
+ * original rules are rules 2 h 1), and "minotaurs <count>" gives the number of Minotaur
+ * lines that follow Theseus' line (one by default).
  *
  * 'file_path' is a string literal that specifies the path of the file to be scanned.
  * 'board' is a stats structure in which to copy the scanned data.
@@ -58,12 +87,64 @@ struct stats {
  *      2 - Invalid board dimensions were scanned.
  *      3 - Invalid relative position of exit square was scanned.
  *      4 - Invalid starting position for Theseus was scanned.
- *      5 - Invalid starting position for Minotaur was scanned.
+ *      5 - Invalid starting position for a Minotaur was scanned.
  *      6 - Invalid relative position of a "wall" was scanned.
  *	7 - Unknown function exited with return value of 1.
+ *	8 - Invalid header line was scanned.
  */
 int read_level_file(const char *file_path, struct stats *board);
 
+/**
+ * Scan an entire level from an already opened stream into a stats structure, making sure
+ * that all scanned data is valid. This is the same as read_level_file() but works with any
+ * FILE pointer, so levels can also be read from pipes or from memory (see fmemopen()).
+ * The stream is closed by this function, whether the level is valid or not.
+ *
+ * 'level_file' specifies the stream to scan the level from.
+ * 'board' is a stats structure in which to copy the scanned data.
+ *
+ * Error Codes:
+ *      Same as the error codes of read_level_file() (1 is never returned).
+ */
+int read_level_stream(FILE *level_file, struct stats *board);
+
+/**
+ * Write a level to a level file, in the format read by read_level_file(): the header
+ * lines (only those that differ from the defaults), the dimensions, the exit, Theseus,
+ * each Minotaur, and one line per wall. The level is written to a temporary file next
+ * to 'file_path' that then replaces it, so the file is never left half written.
+ *
+ * 'file_path' specifies the file path to write the level to.
+ * 'board' specifies the stats structure that holds the level.
+ *
+ * Error Codes:
+ *      0 - No error was encountered.
+ *      1 - The file could not be written.
+ *      2 - Memory for the temporary file path could not be allocated.
+ */
+int write_level_file(const char *file_path, const struct stats *board);
+
+/**
+ * Read a level list with a single read of the whole file, and index its level file paths
+ * in place (the paths point into the file's text, so nothing is copied per level). Empty
+ * lines are skipped. The levels themselves are only read when they are played.
+ *
+ * 'file_path' specifies the file path of the level list.
+ * 'list' receives the level list (free it with free_level_list()). It is left empty
+ * if the list can't be read.
+ *
+ * Error Codes:
+ *	0 - No error was encountered.
+ *	1 - The file could not be opened or read.
+ *	2 - Memory for the list could not be allocated.
+ */
+int read_level_list(const char *file_path, struct level_list *list);
+
+/**
+ * Free the memory of a level list read with read_level_list().
+ */
+void free_level_list(struct level_list *list);
+
 /**
  * Scan data from a specified file into a single cell_rel structure. Also check for
  * invalid data. The validity of scanned data is determined by the given dimensions of
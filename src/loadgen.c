@@ -0,0 +1,225 @@
+#include "server.h"
+
+// Structure to hold one session driven by the load generator
+struct load_session {
+	int fd;
+	char in[SERVER_MAX_LINE];		/* Partial reply received so far */
+	size_t in_len;
+	unsigned long long sent_time;		/* When the command in flight was sent */
+	bool loading;				/* The command in flight is a LOAD */
+};
+
+// Structure to hold the work and the results of one load generator thread
+struct load_thread {
+	pthread_t thread;
+	const char *socket_path;
+	const char *level_path;
+	int num_sessions;
+	unsigned int seed;
+
+	struct lat_histogram latency;
+	unsigned long long commands;
+	bool failed;
+};
+
+// Commands that are still left to send (shared by all threads)
+static long commands_left;
+
+// Connect a new session to the server's socket
+static int connect_session(const char *socket_path) {
+	struct sockaddr_un address;
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) return -1;
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, socket_path, sizeof(address.sun_path) - 1);
+
+	if (connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+// Send a command line for a session and remember when it was sent
+static bool send_command(struct load_session *sess, const char *line, bool loading) {
+	size_t length = strlen(line), sent = 0;
+	ssize_t result;
+
+	sess->sent_time = lat_now();
+	sess->loading = loading;
+
+	while (sent < length) {
+		if ((result = send(sess->fd, line + sent, length - sent, MSG_NOSIGNAL)) < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		sent += result;
+	}
+
+	return true;
+}
+
+// Pick and send the next command for a session, given the last reply (returns false when done)
+static bool next_command(struct load_thread *work, struct load_session *sess, const char *last_reply) {
+	char line[SERVER_MAX_LINE];
+	bool game_over = (strstr(last_reply, "ESCAPED") != NULL || strstr(last_reply, "CAUGHT") != NULL);
+
+	if (__atomic_fetch_sub(&commands_left, 1, __ATOMIC_RELAXED) <= 0) return false;
+
+	work->seed = (work->seed * 1103515245u) + 12345u;
+	unsigned int dice = (work->seed >> 16) % 100;
+
+	// Mostly moves; after the game ends, either undo the last turn or start over
+	if (game_over) {
+		if (dice < 50) return send_command(sess, "UNDO\n", false);
+
+		snprintf(line, sizeof(line), "LOAD %s\n", work->level_path);
+		return send_command(sess, line, true);
+	}
+
+	if (dice < 80) {
+		snprintf(line, sizeof(line), "MOVE %c\n", "LRUDS"[dice % 5]);
+		return send_command(sess, line, false);
+	}
+
+	return send_command(sess, (dice < 90) ? "UNDO\n" : "STATE\n", false);
+}
+
+// Load generator thread: drive a group of sessions, one command in flight per session
+static void *load_worker(void *arg) {
+	struct load_thread *work = arg;
+	struct load_session *sessions = calloc(work->num_sessions, sizeof(struct load_session));
+	struct epoll_event events[SERVER_MAX_EVENTS];
+	int poll_fd = epoll_create1(EPOLL_CLOEXEC);
+	int active = 0;
+	char line[SERVER_MAX_LINE];
+
+	// Open every session and have it load the level
+	snprintf(line, sizeof(line), "LOAD %s\n", work->level_path);
+	for(int i = 0; i < work->num_sessions; i++) {
+		if ((sessions[i].fd = connect_session(work->socket_path)) < 0 || !send_command(&sessions[i], line, true)) {
+			work->failed = true;
+			break;
+		}
+
+		struct epoll_event event;
+		event.events = EPOLLIN;
+		event.data.ptr = &sessions[i];
+		epoll_ctl(poll_fd, EPOLL_CTL_ADD, sessions[i].fd, &event);
+		active++;
+	}
+
+	// Handle replies until every session has run out of commands
+	while (active > 0 && !work->failed) {
+		int num_events = epoll_wait(poll_fd, events, SERVER_MAX_EVENTS, -1);
+
+		for(int i = 0; i < num_events; i++) {
+			struct load_session *sess = events[i].data.ptr;
+			char buffer[SERVER_MAX_LINE];
+			ssize_t length = read(sess->fd, buffer, sizeof(buffer));
+
+			if (length <= 0) {
+				work->failed = true;
+				break;
+			}
+
+			for(ssize_t j = 0; j < length; j++) {
+				if (buffer[j] != '\n') {
+					if (sess->in_len < SERVER_MAX_LINE - 1) sess->in[sess->in_len++] = buffer[j];
+					continue;
+				}
+				sess->in[sess->in_len] = '\0';
+				sess->in_len = 0;
+
+				lat_hist_add(&work->latency, lat_now() - sess->sent_time);
+				work->commands++;
+
+				// A failed LOAD means the server can't play the level at all
+				if (sess->loading && strncmp(sess->in, "OK", 2) != 0) {
+					fprintf(stderr, "theseus: server replied: %s\n", sess->in);
+					work->failed = true;
+					break;
+				}
+
+				if (!next_command(work, sess, sess->in)) {
+					epoll_ctl(poll_fd, EPOLL_CTL_DEL, sess->fd, NULL);
+					active--;
+				}
+			}
+		}
+	}
+
+	for(int i = 0; i < work->num_sessions; i++) {
+		if (sessions[i].fd > 0) close(sessions[i].fd);
+	}
+	close(poll_fd);
+	free(sessions);
+
+	return NULL;
+}
+
+/**
+ * Drive a game server with a local load generator. A number of sessions are opened
+ * over the server's Unix domain socket, and each one loads the given level and then
+ * keeps sending a mix of MOVE, UNDO and STATE commands (one command in flight per
+ * session) until the total number of commands has been sent. The throughput and the
+ * latency distribution of the commands are printed when done.
+ *
+ * 'socket_path' specifies the file path of the server's Unix domain socket.
+ * 'level_path' specifies the level file the sessions play (as seen by the server).
+ * 'num_sessions' specifies how many sessions to open.
+ * 'num_commands' specifies the total number of commands to send.
+ * 'num_threads' specifies the number of threads driving the sessions.
+ *
+ * Return Values:
+ *	0 - The load was generated successfully.
+ *	1 - The server could not be reached or returned an error.
+ */
+int run_loadgen(const char *socket_path, const char *level_path, int num_sessions, long num_commands, int num_threads) {
+	if (num_threads < 1) num_threads = 1;
+	if (num_sessions < num_threads) num_sessions = num_threads;
+
+	struct load_thread *threads = calloc(num_threads, sizeof(struct load_thread));
+	struct lat_histogram *total = calloc(1, sizeof(struct lat_histogram));
+	unsigned long long commands = 0;
+	bool failed = false;
+
+	// Each session's first LOAD counts as one of the commands
+	commands_left = num_commands - num_sessions;
+
+	unsigned long long start_time = lat_now();
+
+	for(int i = 0; i < num_threads; i++) {
+		threads[i].socket_path = socket_path;
+		threads[i].level_path = level_path;
+		threads[i].num_sessions = (num_sessions / num_threads) + (i < (num_sessions % num_threads));
+		threads[i].seed = i + 1;
+		pthread_create(&threads[i].thread, NULL, load_worker, &threads[i]);
+	}
+
+	for(int i = 0; i < num_threads; i++) {
+		pthread_join(threads[i].thread, NULL);
+		lat_hist_merge(total, &threads[i].latency);
+		commands += threads[i].commands;
+		failed = failed || threads[i].failed;
+	}
+
+	double elapsed = (lat_now() - start_time) / 1e6;
+
+	if (failed) fprintf(stderr, "theseus: load generation failed (is the server running on %s?)\n", socket_path);
+
+	printf("sessions:    %d (%d threads)\n", num_sessions, num_threads);
+	printf("commands:    %llu in %.3f s\n", commands, elapsed);
+	printf("throughput:  %.0f commands/s\n", (elapsed > 0) ? commands / elapsed : 0.0);
+	printf("latency us:  p50 %llu  p90 %llu  p99 %llu  p99.9 %llu  max %llu\n",
+	       lat_hist_percentile(total, 0.50), lat_hist_percentile(total, 0.90), lat_hist_percentile(total, 0.99),
+	       lat_hist_percentile(total, 0.999), total->max);
+
+	free(threads);
+	free(total);
+
+	return failed ? 1 : 0;
+}
@@ -1,50 +1,136 @@
+#include "analysis.h"
+#include "broadcast.h"
 #include "game.h"
+#include "levelpack.h"
+#include "pipeline.h"
+#include "playout.h"
+#include "server.h"
+#include "solver.h"
 #include "welcome.h"
 
-#define NAME_LENGTH 50
-#define MAX_LEVELS 50
-
 #define MAIN_MENU_ITEMS 4
 
-int main(void) {
-	char *level_list[MAX_LEVELS];
-	int level_index = 0;
-
-	// Try to open the levellist.txt file and read from it
-	FILE *list_file = fopen("./Levels/levellist.txt", "r");
-	if (list_file != NULL) {
-
-		bool name_error;
-		int c, index;
-		char buffer[NAME_LENGTH + 1];
-
-		// Read in as many level file paths from the levellist.txt file as possible
-		while ((c = fgetc(list_file)) != EOF) {
-			fseek(list_file, -1, SEEK_CUR);
-
-			if (level_index > MAX_LEVELS) break;
-
-			// Copy the name of the file path to a buffer
-			name_error = false;
-			index = 0;
-			for(c = fgetc(list_file); c != '\n' && c != EOF; c = fgetc(list_file)) {
-				if (index >= NAME_LENGTH) {
-					name_error = true;
-					break;
-				}
-
-				buffer[index++] = (char)c;
-			}
-			buffer[index] = '\0';
+int main(int argc, char *argv[]) {
+	const char *latency_log = NULL;
+	const char *server_socket = NULL, *loadgen_socket = NULL, *loadgen_level = NULL;
+	int num_threads = SERVER_THREADS, num_sessions = LOADGEN_SESSIONS;
+	long num_commands = LOADGEN_COMMANDS;
+	bool use_ansi = false;
+	const char *broadcast_socket = NULL, *watch_socket = NULL, *solve_path = NULL;
+	const char *pack_path = NULL, *cache_path = NULL, *catalog_list = NULL, *playout_list = NULL;
+	long playout_count = PLAYOUT_COUNT;
+	double epsilon = PLAYOUT_EPSILON;
+	const char *list_path = NULL;		/* NULL to play the level pack compiled into the game */
+	int broadcast_fd = -1;
+	search_method method = SEARCH_BFS;
+
+	// Start timing the startup phases (only reported with --startup-trace)
+	lat_startup_phase(NULL, false);
+
+	// Parse the command line options
+	for(int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--latency-log") == 0 && i + 1 < argc)
+			latency_log = argv[++i];
+		else if (strcmp(argv[i], "--startup-trace") == 0)
+			startup_trace_enabled = true;
+		else if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc)
+			list_path = argv[++i];
+		else if (strcmp(argv[i], "--ansi") == 0)
+			use_ansi = true;
+		else if (strcmp(argv[i], "--broadcast") == 0 && i + 1 < argc)
+			broadcast_socket = argv[++i];
+		else if (strcmp(argv[i], "--broadcast-fd") == 0 && i + 1 < argc)
+			broadcast_fd = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc)
+			watch_socket = argv[++i];
+		else if (strcmp(argv[i], "--solve") == 0 && i + 1 < argc)
+			solve_path = argv[++i];
+		else if (strcmp(argv[i], "--verify-pack") == 0 && i + 1 < argc)
+			pack_path = argv[++i];
+		else if (strcmp(argv[i], "--catalog") == 0 && i + 1 < argc)
+			catalog_list = argv[++i];
+		else if (strcmp(argv[i], "--playouts") == 0 && i + 1 < argc)
+			playout_list = argv[++i];
+		else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+			playout_count = atol(argv[++i]);
+		else if (strcmp(argv[i], "--epsilon") == 0 && i + 1 < argc)
+			epsilon = atof(argv[++i]);
+		else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+			cache_path = argv[++i];
+		else if (strcmp(argv[i], "--search") == 0 && i + 1 < argc && strcmp(argv[i + 1], "bfs") == 0) {
+			method = SEARCH_BFS;
+			i++;
+		}
+		else if (strcmp(argv[i], "--search") == 0 && i + 1 < argc && strcmp(argv[i + 1], "astar") == 0) {
+			method = SEARCH_ASTAR;
+			i++;
+		}
+		else if (strcmp(argv[i], "--search") == 0 && i + 1 < argc && strcmp(argv[i + 1], "bidir") == 0) {
+			method = SEARCH_BIDIRECTIONAL;
+			i++;
+		}
+		else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc)
+			server_socket = argv[++i];
+		else if (strcmp(argv[i], "--loadgen") == 0 && i + 2 < argc) {
+			loadgen_socket = argv[++i];
+			loadgen_level = argv[++i];
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			num_threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--sessions") == 0 && i + 1 < argc)
+			num_sessions = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--commands") == 0 && i + 1 < argc)
+			num_commands = atol(argv[++i]);
+		else {
+			fprintf(stderr, "Usage: %s [--levels LIST_FILE] [--ansi] [--latency-log FILE] [--startup-trace] [--broadcast SOCKET] [--broadcast-fd FD]\n"
+					"       %s --watch SOCKET\n"
+					"       %s --solve LEVEL_FILE|- [--search bfs|astar|bidir] [--cache FILE] [--threads N]\n"
+					"       %s --verify-pack LIST_FILE [--search bfs|astar|bidir] [--cache FILE]\n"
+					"       %s --catalog LIST_FILE [--threads N]\n"
+					"       %s --playouts LIST_FILE [--count N] [--epsilon E] [--threads N]\n"
+					"       %s --server SOCKET [--levels LIST_FILE] [--threads N]\n"
+					"       %s --loadgen SOCKET LEVEL_FILE [--sessions N] [--commands N] [--threads N]\n",
+				argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+			return 1;
+		}
+	}
 
-			if (name_error) break;
+	// Run without the terminal interface in server and load generator modes
+	if (server_socket != NULL) {
+		struct level_list server_list;
 
-			// Copy the name of the file path from the buffer to an array of level file paths
-			level_list[level_index] = malloc(sizeof(char) * (index + 1));
-			strcpy(level_list[level_index++], buffer);
+		if (list_path != NULL ? read_level_list(list_path, &server_list) != 0 : !packed_level_list(&server_list)) {
+			fprintf(stderr, "theseus: %s: could not read level list\n", (list_path != NULL) ? list_path : "level pack");
+			return 1;
 		}
-		fclose(list_file);
+		int result = run_server(server_socket, &server_list, num_threads);
+		free_level_list(&server_list);
+
+		return result;
 	}
+	if (loadgen_socket != NULL) return run_loadgen(loadgen_socket, loadgen_level, num_sessions, num_commands, num_threads);
+	if (watch_socket != NULL) return watch_broadcast(watch_socket);
+	if (solve_path != NULL && strcmp(solve_path, "-") == 0) return run_solve_stream(method, cache_path, num_threads);
+	if (solve_path != NULL) return run_solver(solve_path, method, cache_path);
+	if (pack_path != NULL) return run_verify_pack(pack_path, method, cache_path);
+	if (catalog_list != NULL) return run_catalog(catalog_list, num_threads);
+	if (playout_list != NULL) return run_playouts(playout_list, playout_count, epsilon, num_threads);
+
+	// Spectators are sent the frames encoded by the ANSI backend
+	bool broadcasting = (broadcast_socket != NULL || broadcast_fd >= 0);
+	if (broadcasting) use_ansi = true;
+	lat_startup_phase("parse options", false);
+
+	// Read the level file paths from the level list (an unreadable list leaves no levels), or list the compiled-in pack without reading any file
+	struct level_list levels;
+	if (list_path != NULL) read_level_list(list_path, &levels);
+	else packed_level_list(&levels);
+	lat_startup_phase("read level list", false);
+
+	// The metrics of the levels are read from the list's catalog (or the pack) when the level menu is first shown
+	struct catalog_entry *catalog = NULL;
+	int catalog_size = -1;
+	bool catalog_read = false;
 
 	int level_num = 0;
 	int action_choice = 0;
@@ -63,12 +149,29 @@ int main(void) {
 
 	// Initalize the terminal screen in curses mode
 	initscr();
+	lat_startup_phase("initscr", false);
 	start_color();
 
 	raw();
 	noecho();
 	curs_set(0);
 	keypad(stdscr, TRUE);
+	lat_startup_phase("colors and input modes", false);
+
+	// Draw the board with raw escape sequences instead of ncurses if asked to
+	if (use_ansi && ansi_init(STDOUT_FILENO, LINES, COLS))
+		render_backend = BACKEND_ANSI;
+
+	// Stream the game to spectators if asked to
+	if (broadcasting && (render_backend != BACKEND_ANSI || !broadcast_start(broadcast_socket, broadcast_fd, LINES, COLS))) {
+		endwin();
+		perror("theseus: could not start the broadcast");
+		return 1;
+	}
+
+	// Measure input-to-frame latency (shown on the HUD and dumped on exit)
+	latency_enabled = true;
+	lat_startup_phase("output backends", false);
 	
 	while (true) {
 
@@ -103,7 +206,7 @@ int main(void) {
 						level_num = 0;
 				}
 				prev_action = action_choice;
-				game_result = play_game(level_list[level_num], level_num == (level_index - 1));
+				game_result = play_game(levels.paths[level_num], level_num == (levels.num_levels - 1));
 
 				// Handle any errors that may have occurred while initializing/playing the game
 				switch (game_result) {
@@ -117,7 +220,7 @@ int main(void) {
 
 					case 2:
 						action_choice = 0;
-						if (level_num != (level_index - 1)) level_num++;
+						if (level_num != (levels.num_levels - 1)) level_num++;
 						break;
 
 					case 3:
@@ -152,8 +255,14 @@ int main(void) {
 			case 2:
 				prev_action = action_choice;
 
-				// Show a list of all levels from levellist.txt file
-				if ((menu_choice = show_menu(level_index + 1 + MIN_HEIGHT, NAME_LENGTH + (2 * PADDING_LEFT), "Choose Level File", level_index, level_list, 1, "Back")) != level_index) {
+				if (!catalog_read) {
+					catalog_size = (list_path != NULL) ? read_catalog(list_path, &catalog) : packed_catalog(&catalog);
+					if (catalog_size < 0) catalog = NULL;
+					catalog_read = true;
+				}
+
+				// Show a list of all levels from the level list (sorted and filtered by difficulty if it has a catalog)
+				if ((menu_choice = show_level_menu(levels.paths, levels.num_levels, catalog, catalog_size)) != levels.num_levels) {
 					level_num = menu_choice;
 					action_choice = 1;
 				}
@@ -203,10 +312,18 @@ int main(void) {
 
 	// Exit out of curses mode
 	endwin();
+	broadcast_stop();
+	ansi_end();
+
+	// Save the latency histograms if asked to
+	if (latency_log != NULL && !lat_dump(latency_log))
+		fprintf(stderr, "Could not write latency log '%s'\n", latency_log);
+	if (startup_trace_enabled) lat_startup_report(stderr);
 
 	// Free all allocated memory
-	for(int i = 0; i < level_index; i++)
-		free(level_list[i]);
+	free_level_menu();
+	free_level_list(&levels);
+	free(catalog);
 
 	return 0;
 }
@@ -1,8 +1,6 @@
 #include "board.h"
 #include "movement.h"
-
-// An array of numbers with which to build and manipulate bit_masks for valid moves on the board
-const short moves[NUM_MOVES] = {1, 2, 4, 8};
+#include "kernels.h"
 
 /**
  * Take in an array of board_square structures and a stats structure, holding
@@ -15,58 +13,14 @@ const short moves[NUM_MOVES] = {1, 2, 4, 8};
  * 'win_grid' specifies the array of board_square structures to modify.
  */
 void set_moves(struct stats *board, board_square *win_grid) {
+	int num_squares = board->size.num_rows * board->size.num_cols;
+	unsigned char masks[num_squares];
 
-	// Turn off moves that go off the board
-	for(int i = 0; i < board->size.num_rows; i++) {
-		if (i == 0 || i == (board->size.num_rows - 1)) {
-			int bit_index = (i == 0) ? UP : DOWN;
-			
-			for(int j = 0; j < board->size.num_cols; j++) {
-				win_grid[(i * board->size.num_cols) + j].move_mask &= ~(moves[bit_index]);
-				
-				// Turn off two bits (moves) of move_mask for corners of the board
-				if (j == 0 || j == (board->size.num_cols - 1)) {
-					int bit_index_corner = (j == 0) ? LEFT : RIGHT;
-					win_grid[(i * board->size.num_cols) + j].move_mask &= ~(moves[bit_index_corner]);
-				}
-			}
-		}
-		else {
-			int bit_index = LEFT;
-			for(int j = 0; j < board->size.num_cols; j += (board->size.num_cols - 1)) {
-				win_grid[(i * board->size.num_cols) + j].move_mask &= ~(moves[bit_index]);
-				bit_index = RIGHT;
-			}
-		}
-	}
-
-	// Loop through linked-list of walls and turn off moves through walls on both sides of each wall
-	for(cell_rel *temp = board->walls; temp != NULL; temp = temp->next) {
-		win_grid[(temp->relation.row * board->size.num_cols) + temp->relation.col].move_mask &= ~(moves[temp->location]);
-		
-		switch (temp->location) {
-			case LEFT:
-				if (temp->relation.col > 0)
-					win_grid[(temp->relation.row * board->size.num_cols) + temp->relation.col - 1].move_mask &= ~(moves[RIGHT]);
-				break;
-
-			case RIGHT:
-				if (temp->relation.col < (board->size.num_cols - 1))
-					win_grid[(temp->relation.row * board->size.num_cols) + temp->relation.col + 1].move_mask &= ~(moves[LEFT]);
-				break;
+	// The rules for valid moves are shared with the render-free engine
+	compute_move_masks(board, masks);
 
-			case UP:
-				if (temp->relation.row > 0)
-					win_grid[((temp->relation.row - 1) * board->size.num_cols) + temp->relation.col].move_mask &= ~(moves[DOWN]);
-				break;
-
-			case DOWN:
-				if (temp->relation.row < (board->size.num_rows - 1))
-					win_grid[((temp->relation.row + 1) * board->size.num_cols) + temp->relation.col].move_mask &= ~(moves[UP]);
-				break;
-		}
-	}
-	win_grid[(board->exit.relation.row * board->size.num_cols) + board->exit.relation.col].move_mask |= moves[board->exit.location];
+	for(int i = 0; i < num_squares; i++)
+		win_grid[i].move_mask = masks[i];
 
 	return;
 }
@@ -75,7 +29,7 @@ void set_moves(struct stats *board, board_square *win_grid) {
  * Move Theseus to a new WINDOW based on an inputted move direction. If the move is invalid for the
  * current square, then no move is made. If the move specified puts Theseus in the exit WINDOW, the
  * function handles the copying of the display image for Theseus over to the given WINDOW supplied
- * for 'exit' parameter. If the move specified puts Theseus in the same position as the Minotaur, then
+ * for 'exit' parameter. If the move specified puts Theseus in the same position as a Minotaur, then
  * the display image for Theseus is erased from the current WINDOW, but not copied over to the new
  * WINDOW. The position for Theseus is still updated, however.
  *
@@ -89,24 +43,23 @@ void set_moves(struct stats *board, board_square *win_grid) {
  *	0 - No move was made for Theseus (invalid move).
  *	1 - A move was made to an ordinary square on the board.
  *	2 - A move was made to the exit WINDOW.
- *	3 - A move was made to a square occupied by the Minotaur (display image not copied over).
+ *	3 - A move was made to a square occupied by a Minotaur (display image not copied over).
  */
 int move_theseus(struct stats *board, board_square *win_grid, WINDOW *exit, short *win_pair, short move) {
 	int theseus_pos = (board->theseus.row * board->size.num_cols) + board->theseus.col;
-	int minotaur_pos = (board->minotaur.row * board->size.num_cols) + board->minotaur.col;
 	int exit_pos = (board->exit.relation.row * board->size.num_cols) + board->exit.relation.col;
 
 	// Make sure the move is valid
 	if (!(win_grid[theseus_pos].move_mask & moves[move])) return 0;
 
 	// Erase the image from the WINDOW currently occupied by Theseus
-	win_draw_image(win_grid[theseus_pos].win, eraser, ERASER_SIZE, *win_pair, *win_pair);
+	win_draw_sprite(win_grid[theseus_pos].win, SPRITE_ERASER, *win_pair);
 	*win_pair = (*win_pair == PAIR_1) ? PAIR_2 : PAIR_1;
 
 	// Check if Theseus is moving to the exit WINDOW
 	if (theseus_pos == exit_pos && board->exit.location == move) {
-		win_draw_image(exit, theseus_image, THESEUS_SIZE, THESEUS_PAIR, *win_pair);
-		doupdate();
+		win_draw_sprite(exit, SPRITE_THESEUS, *win_pair);
+		flush_frame();
 		return 2;
 	}
 
@@ -133,132 +86,93 @@ int move_theseus(struct stats *board, board_square *win_grid, WINDOW *exit, shor
 			break;
 	}
 
-	// Check if Theseus moved to the Minotaur's position
-	if (theseus_pos == minotaur_pos) {
-		doupdate();
-		return 3;
+	// Check if Theseus moved to a Minotaur's position
+	for(int i = 0; i < board->num_minotaurs; i++) {
+		if (board->theseus.row == board->minotaurs[i].row && board->theseus.col == board->minotaurs[i].col) {
+			flush_frame();
+			return 3;
+		}
 	}
 
 	// Draw Theseus to the new WINDOW
-	win_draw_image(win_grid[theseus_pos].win, theseus_image, THESEUS_SIZE, THESEUS_PAIR, *win_pair);
-	doupdate();
+	win_draw_sprite(win_grid[theseus_pos].win, SPRITE_THESEUS, *win_pair);
+	flush_frame();
 
 	return 1;
 }
 
+// Check if the square next to Minotaur 'index' in a direction is occupied by another Minotaur
+static bool square_taken(const struct stats *board, int index, short move) {
+	cell_pos target = board->minotaurs[index];
+
+	switch (move) {
+		case LEFT:
+			target.col--;
+			break;
+
+		case RIGHT:
+			target.col++;
+			break;
+
+		case UP:
+			target.row--;
+			break;
+
+		case DOWN:
+			target.row++;
+			break;
+	}
+
+	for(int i = 0; i < board->num_minotaurs; i++)
+		if (i != index && board->minotaurs[i].row == target.row && board->minotaurs[i].col == target.col) return true;
+
+	return false;
+}
+
 /**
  * Given statistics of the board and possible moves for each of the board's squares, check
- * if the Minotaur can make any moves, and if so then move him to that square and display the
- * move to the screen. Note that the Minotaur will only move if there is a valid move in the
- * direction of Theseus.
+ * if one of the Minotaurs can make any moves, and if so then move him to that square and display
+ * the move to the screen. Note that the Minotaur will only move if there is a valid move in the
+ * direction of Theseus, and never onto another Minotaur's square. Horizontal moves are tried
+ * before vertical moves, unless the rules of the level say otherwise.
  *
  * 'board' holds information about the board.
  * 'win_grid' specifies an array containing a WINDOW and possible moves for each square on the board.
- * 'win_pair' specifies the color pair of the current WINDOW occupied by the Minotaur.
+ * 'index' specifies which Minotaur to move (in level order).
+ * 'win_pair' specifies the color pair of the current WINDOW occupied by that Minotaur.
  *
  * Return Values:
  *	0 - No move was made.
  *	1 - A move was made, but Theseus was not caught.
  *	2 - A move was made and Theseus has been caught.
  */
-int move_minotaur(struct stats *board, board_square *win_grid, short *win_pair) {
-	int minotaur_pos = (board->minotaur.row * board->size.num_cols) + board->minotaur.col;
-	bool move_made = false;
-	bool theseus_caught = false;
-	
-	// Loop through all different moves possible on a board
-	for(int i = 0; i < NUM_MOVES; i++) {
-
-		// Check if move can be made by the Minotaur
-		if (win_grid[minotaur_pos].move_mask & moves[i]) {
-
-			// Don't move unless toward Theseus
-			switch (i) {
-				case LEFT:
-					if (board->minotaur.col > board->theseus.col) {
-						win_draw_image(win_grid[minotaur_pos].win, eraser, ERASER_SIZE, *win_pair, *win_pair);
-
-						*win_pair = (*win_pair == PAIR_1) ? PAIR_2 : PAIR_1;	/* Adjust the color pair value for the next WINDOW to be occupied by the Minotaur */
-						board->minotaur.col--;
-						minotaur_pos--;
-
-						if (board->minotaur.row == board->theseus.row
-						    && board->minotaur.col == board->theseus.col) {
-							win_draw_image(win_grid[minotaur_pos].win, eraser, ERASER_SIZE, *win_pair, *win_pair);
-							theseus_caught = true;
-						}
+int move_minotaur(struct stats *board, board_square *win_grid, int index, short *win_pair) {
+	cell_pos *minotaur = &board->minotaurs[index];
+	int minotaur_pos = (minotaur->row * board->size.num_cols) + minotaur->col;
+	unsigned char mask = win_grid[minotaur_pos].move_mask;
 
-						win_draw_image(win_grid[minotaur_pos].win, minotaur_image, MINOTAUR_SIZE, MINOTAUR_PAIR, *win_pair);
-						doupdate();
-						move_made = true;
-					}
-					break;
+	// A move onto another Minotaur's square is treated like a wall
+	for(int i = 0; i < NUM_MOVES; i++)
+		if (square_taken(board, index, i)) mask &= ~moves[i];
 
-				case RIGHT:
-					if (board->minotaur.col < board->theseus.col) {
-						win_draw_image(win_grid[minotaur_pos].win, eraser, ERASER_SIZE, *win_pair, *win_pair);
+	// Look the step up in the table shared with the engine (toward Theseus, in the order of the level's rules)
+	int dx = (board->theseus.col > minotaur->col) - (board->theseus.col < minotaur->col);
+	int dy = (board->theseus.row > minotaur->row) - (board->theseus.row < minotaur->row);
+	int move = minotaur_choice(mask, dx, dy, board->rules.vertical_first);
+	if (move == NO_MOVE) return 0;
 
-						*win_pair = (*win_pair == PAIR_1) ? PAIR_2 : PAIR_1;
-						board->minotaur.col++;
-						minotaur_pos++;
+	win_draw_sprite(win_grid[minotaur_pos].win, SPRITE_ERASER, *win_pair);
 
-						if (board->minotaur.row == board->theseus.row
-						    && board->minotaur.col == board->theseus.col) {
-							win_draw_image(win_grid[minotaur_pos].win, eraser, ERASER_SIZE, *win_pair, *win_pair);
-							theseus_caught = true;
-						}
+	*win_pair = (*win_pair == PAIR_1) ? PAIR_2 : PAIR_1;	/* Adjust the color pair value for the next WINDOW to be occupied by the Minotaur */
+	minotaur->row += move_rows[move];
+	minotaur->col += move_cols[move];
+	minotaur_pos = (minotaur->row * board->size.num_cols) + minotaur->col;
 
-						win_draw_image(win_grid[minotaur_pos].win, minotaur_image, MINOTAUR_SIZE, MINOTAUR_PAIR, *win_pair);
-						doupdate();
-						move_made = true;
-					}
-					break;
+	bool theseus_caught = (minotaur->row == board->theseus.row && minotaur->col == board->theseus.col);
+	if (theseus_caught) win_draw_sprite(win_grid[minotaur_pos].win, SPRITE_ERASER, *win_pair);
 
-				case UP:
-					if (board->minotaur.row > board->theseus.row) {
-						win_draw_image(win_grid[minotaur_pos].win, eraser, ERASER_SIZE, *win_pair, *win_pair);
-
-						*win_pair = (*win_pair == PAIR_1) ? PAIR_2 : PAIR_1;
-						board->minotaur.row--;
-						minotaur_pos -= board->size.num_cols;
-
-						if (board->minotaur.row == board->theseus.row
-						    && board->minotaur.col == board->theseus.col) {
-							win_draw_image(win_grid[minotaur_pos].win, eraser, ERASER_SIZE, *win_pair, *win_pair);
-							theseus_caught = true;
-						}
-
-						win_draw_image(win_grid[minotaur_pos].win, minotaur_image, MINOTAUR_SIZE, MINOTAUR_PAIR, *win_pair);
-						doupdate();
-						move_made = true;
-					}
-					break;
-
-				case DOWN:
-					if (board->minotaur.row < board->theseus.row) {
-						win_draw_image(win_grid[minotaur_pos].win, eraser, ERASER_SIZE, *win_pair, *win_pair);
-
-						*win_pair = (*win_pair == PAIR_1) ? PAIR_2 : PAIR_1;
-						board->minotaur.row++;
-						minotaur_pos += board->size.num_cols;
-
-						if (board->minotaur.row == board->theseus.row
-						    && board->minotaur.col == board->theseus.col) {
-							win_draw_image(win_grid[minotaur_pos].win, eraser, ERASER_SIZE, *win_pair, *win_pair);
-							theseus_caught = true;
-						}
-
-						win_draw_image(win_grid[minotaur_pos].win, minotaur_image, MINOTAUR_SIZE, MINOTAUR_PAIR, *win_pair);
-						doupdate();
-						move_made = true;
-					}
-					break;
-			}
-		}
-
-		if (theseus_caught) return 2;
-		if (move_made) return 1;
-	}
+	win_draw_sprite(win_grid[minotaur_pos].win, SPRITE_MINOTAUR, *win_pair);
+	flush_frame();
 
-	return 0;
+	return theseus_caught ? 2 : 1;
 }
@@ -0,0 +1,332 @@
+#include "pipeline.h"
+
+#define SPIN_LIMIT 64		/* Failed attempts spent spinning before yielding the CPU */
+#define YIELD_LIMIT 256		/* Failed attempts spent yielding before sleeping */
+#define BACKOFF_SLEEP 50000	/* Nanoseconds slept per attempt once spinning and yielding have failed */
+
+// Structure to hold one slot of a bounded queue
+struct queue_cell {
+	size_t sequence;		/* Tells whether the slot is free or holds an item for the current lap */
+	void *item;
+};
+
+/*
+ * Structure to hold a bounded lock-free queue for any number of producers and consumers.
+ * Every slot carries a sequence number, so a producer (or consumer) claims a position with
+ * one compare-and-swap and then only touches its own slot.
+ */
+struct bounded_queue {
+	struct queue_cell cells[PIPELINE_QUEUE];
+	char pad1[64];
+	size_t tail;			/* Next position to put an item at */
+	char pad2[64];
+	size_t head;			/* Next position to take an item from */
+	char pad3[64];
+};
+
+// Structure to hold one level on its way through the pipeline
+struct stream_level {
+	long seq;			/* Position of the level in the stream (from 0) */
+	char name[PIPELINE_NAME_LENGTH];
+	int status;			/* 0 if the level was parsed, else the code of read_level_stream() */
+	struct engine_level level;
+	struct solution sol;
+	bool solved;
+	bool cached;
+	unsigned long long elapsed;	/* Microseconds spent solving the level */
+};
+
+// Structure to hold the state shared by the stages of the pipeline
+struct pipeline {
+	struct bounded_queue parsed;	/* Parser -> solvers */
+	struct bounded_queue solved;	/* Solvers -> printer */
+
+	search_method method;
+	struct result_cache *cache;
+	int num_solvers;
+
+	long total;			/* Levels in the stream (set once the parser is done) */
+	bool parsed_all;
+	long printed;			/* Levels printed so far */
+};
+
+// Wait a little after a failed attempt, more and more politely as the attempts pile up
+static void backoff(int *attempts) {
+	if (++*attempts < SPIN_LIMIT) return;
+	if (*attempts < YIELD_LIMIT) sched_yield();
+	else {
+		struct timespec pause = {0, BACKOFF_SLEEP};
+		nanosleep(&pause, NULL);
+	}
+}
+
+// Set up an empty bounded queue
+static void queue_init(struct bounded_queue *queue) {
+	for(size_t i = 0; i < PIPELINE_QUEUE; i++)
+		queue->cells[i].sequence = i;
+	queue->head = queue->tail = 0;
+}
+
+// Try to put an item into a queue: returns false if the queue is full
+static bool queue_try_push(struct bounded_queue *queue, void *item) {
+	size_t position = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+
+	while (true) {
+		struct queue_cell *cell = &queue->cells[position & (PIPELINE_QUEUE - 1)];
+		size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+		intptr_t lap = (intptr_t)sequence - (intptr_t)position;
+
+		if (lap == 0) {
+			if (__atomic_compare_exchange_n(&queue->tail, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				cell->item = item;
+				__atomic_store_n(&cell->sequence, position + 1, __ATOMIC_RELEASE);
+				return true;
+			}
+		}
+		else if (lap < 0) return false;
+		else position = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+	}
+}
+
+// Try to take an item from a queue: returns false if the queue is empty
+static bool queue_try_pop(struct bounded_queue *queue, void **item) {
+	size_t position = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+
+	while (true) {
+		struct queue_cell *cell = &queue->cells[position & (PIPELINE_QUEUE - 1)];
+		size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+		intptr_t lap = (intptr_t)sequence - (intptr_t)(position + 1);
+
+		if (lap == 0) {
+			if (__atomic_compare_exchange_n(&queue->head, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				*item = cell->item;
+				__atomic_store_n(&cell->sequence, position + PIPELINE_QUEUE, __ATOMIC_RELEASE);
+				return true;
+			}
+		}
+		else if (lap < 0) return false;
+		else position = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+	}
+}
+
+// Put an item into a queue, waiting for room
+static void queue_push(struct bounded_queue *queue, void *item) {
+	int attempts = 0;
+
+	while (!queue_try_push(queue, item))
+		backoff(&attempts);
+}
+
+// Parse one level record and hand it to the solvers (waiting until the printer is close enough behind)
+static bool emit_record(struct pipeline *pipe, long seq, const char *name, char *text, size_t length) {
+	struct stream_level *record = calloc(1, sizeof(struct stream_level));
+	if (record == NULL) return false;
+
+	record->seq = seq;
+	if (name[0] != '\0') snprintf(record->name, sizeof(record->name), "%s", name);
+	else snprintf(record->name, sizeof(record->name), "%ld", seq + 1);
+
+	struct stats board;
+	FILE *stream = fmemopen(text, length, "r");
+
+	board.walls = NULL;
+	record->status = (stream != NULL) ? read_level_stream(stream, &board) : 7;
+	if (record->status == 0) {
+		if (!engine_load(&record->level, &board)) record->status = 7;
+		free_walls(board.walls);
+	}
+
+	int attempts = 0;
+	while (seq - __atomic_load_n(&pipe->printed, __ATOMIC_ACQUIRE) >= PIPELINE_WINDOW)
+		backoff(&attempts);
+	queue_push(&pipe->parsed, record);
+
+	return true;
+}
+
+// Parser stage: split the standard input into level records and parse each one
+static void *parser_stage(void *arg) {
+	struct pipeline *pipe = arg;
+	char *line = NULL, *text = NULL;
+	size_t line_size = 0, length = 0, capacity = 0;
+	char name[PIPELINE_NAME_LENGTH] = "", next_name[PIPELINE_NAME_LENGTH] = "";
+	bool has_level = false, ok = true;
+	long seq = 0;
+	ssize_t read;
+
+	while (ok) {
+		read = getline(&line, &line_size, stdin);
+
+		// A separator line (or the end of the stream) ends the current level
+		if (read < 0 || line[0] == '%') {
+			if (read >= 0) {
+				char *start = line + 1 + strspn(line + 1, " \t");
+				start[strcspn(start, "\r\n")] = '\0';
+				snprintf(next_name, sizeof(next_name), "%s", start);
+			}
+			if (has_level) ok = emit_record(pipe, seq++, name, text, length);
+
+			has_level = false;
+			length = 0;
+			memcpy(name, next_name, sizeof(name));
+			next_name[0] = '\0';
+			if (read < 0) break;
+			continue;
+		}
+
+		// Keep the level's lines until its separator (a level without any numbers is skipped)
+		if (length + read + 1 > capacity) {
+			capacity = (length + read + 1) * 2;
+			char *larger = realloc(text, capacity);
+			if (larger == NULL) {
+				ok = false;
+				break;
+			}
+			text = larger;
+		}
+		memcpy(text + length, line, read);
+		length += read;
+		text[length] = '\0';
+		if (line[strspn(line, " \t\r\n")] != '\0') has_level = true;
+	}
+	if (!ok) fprintf(stderr, "theseus: out of memory while reading levels\n");
+	free(line);
+	free(text);
+
+	// Tell the printer how many levels there are, and stop every solver
+	__atomic_store_n(&pipe->total, seq, __ATOMIC_RELAXED);
+	__atomic_store_n(&pipe->parsed_all, true, __ATOMIC_RELEASE);
+	for(int i = 0; i < pipe->num_solvers; i++)
+		queue_push(&pipe->parsed, NULL);
+
+	return NULL;
+}
+
+// Solver stage: solve parsed levels until the parser says there are no more
+static void *solver_stage(void *arg) {
+	struct pipeline *pipe = arg;
+
+	while (true) {
+		void *item;
+		int attempts = 0;
+
+		while (!queue_try_pop(&pipe->parsed, &item))
+			backoff(&attempts);
+		if (item == NULL) break;
+
+		struct stream_level *record = item;
+		if (record->status == 0) {
+			unsigned long long start_time = lat_now();
+
+			record->solved = cache_solve(pipe->cache, &record->level, pipe->method, &record->sol, &record->cached);
+			record->elapsed = lat_now() - start_time;
+			engine_free(&record->level);
+		}
+		queue_push(&pipe->solved, record);
+	}
+
+	return NULL;
+}
+
+// Print the result of a level (the printer stage's formatting): returns false if the level failed
+static bool print_record(struct stream_level *record) {
+	if (record->status != 0) {
+		fflush(stdout);
+		fprintf(stderr, "theseus: %s: invalid level\n", record->name);
+		return false;
+	}
+	if (!record->solved) {
+		fflush(stdout);
+		fprintf(stderr, "theseus: %s: out of memory\n", record->name);
+		return false;
+	}
+
+	print_solution(stdout, record->name, &record->sol, record->cached, record->elapsed);
+	free_solution(&record->sol);
+
+	return true;
+}
+
+int run_solve_stream(search_method method, const char *cache_path, int num_threads) {
+	struct pipeline *pipe = calloc(1, sizeof(struct pipeline));
+	struct stream_level **window = calloc(PIPELINE_WINDOW, sizeof(struct stream_level *));
+	struct result_cache cache;
+	int result = 0;
+
+	if (pipe == NULL || window == NULL) {
+		fprintf(stderr, "theseus: out of memory\n");
+		free(pipe);
+		free(window);
+		return 1;
+	}
+
+	queue_init(&pipe->parsed);
+	queue_init(&pipe->solved);
+	pipe->method = method;
+	pipe->num_solvers = (num_threads > 0) ? num_threads : 1;
+	if (cache_path != NULL) {
+		if (cache_open(&cache, cache_path)) pipe->cache = &cache;
+		else fprintf(stderr, "theseus: %s: could not open the result cache, solving without it\n", cache_path);
+	}
+
+	// Start the solvers, then the parser (which stops as many solvers as were started)
+	pthread_t parser, solvers[pipe->num_solvers];
+	int started = 0;
+
+	for(; started < pipe->num_solvers; started++)
+		if (pthread_create(&solvers[started], NULL, solver_stage, pipe) != 0) break;
+	pipe->num_solvers = started;
+
+	// The printer must run on this thread, so the pipeline can't do without solver or parser threads
+	bool parsing = (started > 0 && pthread_create(&parser, NULL, parser_stage, pipe) == 0);
+	if (!parsing) {
+		fprintf(stderr, "theseus: could not start the pipeline\n");
+		for(int i = 0; i < started; i++)
+			queue_push(&pipe->parsed, NULL);
+		for(int i = 0; i < started; i++)
+			pthread_join(solvers[i], NULL);
+
+		if (pipe->cache != NULL) cache_close(pipe->cache);
+		free(pipe);
+		free(window);
+		return 1;
+	}
+
+	// Printer stage: put the results back in stream order and print each one when its turn comes
+	long next = 0;
+	int attempts = 0;
+
+	while (!__atomic_load_n(&pipe->parsed_all, __ATOMIC_ACQUIRE) || next < __atomic_load_n(&pipe->total, __ATOMIC_RELAXED)) {
+		void *item;
+
+		if (window[next % PIPELINE_WINDOW] != NULL) {
+			struct stream_level *record = window[next % PIPELINE_WINDOW];
+
+			window[next % PIPELINE_WINDOW] = NULL;
+			if (!print_record(record)) result = 1;
+			free(record);
+			__atomic_store_n(&pipe->printed, ++next, __ATOMIC_RELEASE);
+			attempts = 0;
+		}
+		else if (queue_try_pop(&pipe->solved, &item)) {
+			struct stream_level *record = item;
+
+			window[record->seq % PIPELINE_WINDOW] = record;
+			attempts = 0;
+		}
+		else {
+			fflush(stdout);
+			backoff(&attempts);
+		}
+	}
+
+	pthread_join(parser, NULL);
+	for(int i = 0; i < started; i++)
+		pthread_join(solvers[i], NULL);
+
+	if (pipe->cache != NULL) cache_close(pipe->cache);
+	free(pipe);
+	free(window);
+
+	return result;
+}
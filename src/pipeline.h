@@ -0,0 +1,50 @@
+#ifndef _PIPELINE_H
+#define _PIPELINE_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cache.h"
+#include "engine.h"
+#include "latency.h"
+#include "loader.h"
+#include "solver.h"
+
+#define PIPELINE_QUEUE 64		/* Slots of each queue between two stages (a power of two) */
+#define PIPELINE_WINDOW 256		/* Most levels between the one being parsed and the next one printed */
+#define PIPELINE_NAME_LENGTH 128	/* Longest level name kept from a separator line */
+
+/**
+ * Solve a stream of levels read from the standard input, and print one result line per
+ * level in the order the levels came in (the same lines as run_solver(), with the level's
+ * name in place of a file path). The levels are level files written one after the other,
+ * each one ended by a separator line that starts with '%'; the rest of a separator line
+ * names the level that follows it (levels without a name are numbered from 1). The last
+ * level doesn't need a separator.
+ *
+ * The work runs as a pipeline: one thread reads and parses the levels, a pool of threads
+ * solves them, and the calling thread formats and prints the results in order. The stages
+ * are connected by bounded lock-free queues, and the parser never gets more than
+ * PIPELINE_WINDOW levels ahead of the output, so a stream of any length is solved in
+ * bounded memory.
+ *
+ * 'method' specifies the search method (see solve_level()).
+ * 'cache_path' specifies the file path of the result cache (NULL for none).
+ * 'num_threads' specifies the number of threads solving levels.
+ *
+ * Return Values:
+ *	0 - Every level of the stream was solved (whether Theseus can escape or not).
+ *	1 - A level could not be read or solved, or the pipeline could not be started.
+ */
+int run_solve_stream(search_method method, const char *cache_path, int num_threads);
+
+#endif	    // _PIPELINE_H
@@ -0,0 +1,352 @@
+#include "playout.h"
+
+#define PLAYOUT_SEED 0x9E3779B97F4A7C15ULL	/* Seed of run_playouts() (the same results on every run) */
+
+// Structure to hold the work of one playout thread
+struct playout_thread {
+	pthread_t thread;
+	const struct engine_level *level;
+	const int *distance;		/* Moves from each cell to escape (see compute_exit_distances()) */
+	long count;			/* Playouts to play */
+	uint64_t epsilon_limit;		/* A random number up to this picks a random move */
+	uint64_t random;		/* State of the thread's xorshift64* generator (never 0) */
+	struct playout_stats stats;
+};
+
+// Next number of a xorshift64* generator (never 0)
+static inline uint64_t next_random(uint64_t *state) {
+	uint64_t x = *state;
+
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+// Turn a random number into a number below 'limit' (with a multiplication instead of a division)
+static inline int random_below(uint64_t random, int limit) {
+	return (int)(((random >> 32) * (uint64_t)limit) >> 32);
+}
+
+// Spread a seed over all the bits of a generator's state (splitmix64): never returns 0
+static uint64_t mix_seed(uint64_t seed) {
+	seed += 0x9E3779B97F4A7C15ULL;
+	seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+	seed ^= seed >> 31;
+
+	return (seed != 0) ? seed : 1;
+}
+
+// Pick the player's next move: a random valid move, or the greedy one (see playout_level())
+static short choose_move(const struct playout_thread *work, const struct engine_state *state, uint64_t *random) {
+	const struct engine_level *level = work->level;
+	short valid[NUM_MOVES + 1], best[NUM_MOVES + 1];
+	int num_valid = 0, num_best = 0, best_distance = 0;
+
+	for(short move = 0; move < NUM_MOVES; move++)
+		if (level->masks[state->theseus] & moves[move]) valid[num_valid++] = move;
+	valid[num_valid++] = SKIP_MOVE;
+
+	if (next_random(random) <= work->epsilon_limit)
+		return valid[random_below(next_random(random), num_valid)];
+
+	// Leave out the moves that get Theseus caught, and keep the ones that end closest to the exit
+	for(int i = 0; i < num_valid; i++) {
+		struct engine_state after = *state;
+		engine_result result = engine_turn(level, &after, valid[i]);
+
+		if (result == ENGINE_ESCAPED) return valid[i];
+		if (result == ENGINE_CAUGHT) continue;
+
+		int distance = work->distance[after.theseus];
+		if (distance < 0) distance = level->num_cells + 1;
+
+		if (num_best == 0 || distance < best_distance) {
+			best_distance = distance;
+			num_best = 0;
+		}
+		if (distance == best_distance) best[num_best++] = valid[i];
+	}
+
+	// Every move loses: any of them will do
+	if (num_best == 0) return valid[random_below(next_random(random), num_valid)];
+
+	return best[random_below(next_random(random), num_best)];
+}
+
+// Playout thread: play a share of the playouts of a level, counting into the thread's own stats
+static void *playout_worker(void *arg) {
+	struct playout_thread *work = arg;
+	const struct engine_level *level = work->level;
+	struct playout_stats stats = work->stats;	/* Counted on this thread's stack, away from the other threads' cache lines */
+	uint64_t random = work->random;
+
+	for(long n = 0; n < work->count; n++) {
+		struct engine_state state;
+		engine_result result = ENGINE_MOVED;
+		int turns = 0;
+
+		engine_reset(level, &state);
+		while (turns < PLAYOUT_MAX_TURNS) {
+			result = engine_turn(level, &state, choose_move(work, &state, &random));
+			if (result == ENGINE_ESCAPED || result == ENGINE_CAUGHT) {
+				turns++;
+				break;
+			}
+			if (state.actions == 0) turns++;
+		}
+
+		if (result == ENGINE_ESCAPED) {
+			stats.wins++;
+			stats.win_turns += turns;
+		}
+		else if (result == ENGINE_CAUGHT) {
+			stats.losses++;
+			stats.loss_turns += turns;
+			stats.catches[state.theseus]++;
+		}
+		else stats.timeouts++;
+		stats.playouts++;
+	}
+
+	work->stats = stats;
+	work->random = random;
+
+	return NULL;
+}
+
+/**
+ * Play a level over and over with an epsilon-greedy player, to estimate how hard it is for
+ * a person rather than for the solver. On each move the player picks a random valid move
+ * with probability 'epsilon' (so 1 plays at random); otherwise he leaves out the moves that
+ * get him caught right away and takes the one that brings him closest to the exit, ignoring
+ * the Minotaur. The playouts are split between threads, each with its own random number
+ * generator and counters, and played on the render-free engine.
+ *
+ * 'level' specifies the level.
+ * 'count' specifies the number of playouts.
+ * 'epsilon' specifies the probability of a random move (0 to 1).
+ * 'num_threads' specifies the number of threads.
+ * 'seed' specifies the seed of the random number generators.
+ * 'stats' receives the results (free them with free_playout_stats()).
+ *
+ * Return Values:
+ *	true - The level was played.
+ *	false - Memory for the playouts could not be allocated.
+ */
+bool playout_level(const struct engine_level *level, long count, double epsilon, int num_threads, uint64_t seed, struct playout_stats *stats) {
+	if (num_threads < 1) num_threads = 1;
+	if (count < num_threads) num_threads = (count > 0) ? (int)count : 1;
+
+	memset(stats, 0, sizeof(struct playout_stats));
+	stats->catches = calloc(level->num_cells, sizeof(long));
+
+	int *distance = malloc(sizeof(int) * level->num_cells);
+	struct playout_thread *threads = calloc(num_threads, sizeof(struct playout_thread));
+	bool ok = (stats->catches != NULL && distance != NULL && threads != NULL && compute_exit_distances(level, distance));
+
+	uint64_t epsilon_limit = (epsilon >= 1.0) ? UINT64_MAX : (epsilon <= 0.0) ? 0 : (uint64_t)(epsilon * 18446744073709551616.0);
+	for(int t = 0; ok && t < num_threads; t++) {
+		struct playout_thread *work = &threads[t];
+
+		work->level = level;
+		work->distance = distance;
+		work->count = ((count * (t + 1)) / num_threads) - ((count * t) / num_threads);
+		work->epsilon_limit = epsilon_limit;
+		work->random = mix_seed(seed + t);
+		work->stats.catches = calloc(level->num_cells, sizeof(long));
+		ok = (work->stats.catches != NULL);
+	}
+
+	// Play on a pool of threads (the calling thread is one of them, and plays the shares of the threads that didn't start)
+	if (ok) {
+		int started = 1;
+
+		for(; started < num_threads; started++)
+			if (pthread_create(&threads[started].thread, NULL, playout_worker, &threads[started]) != 0) break;
+		playout_worker(&threads[0]);
+		for(int t = started; t < num_threads; t++)
+			playout_worker(&threads[t]);
+		for(int t = 1; t < started; t++)
+			pthread_join(threads[t].thread, NULL);
+	}
+
+	// Add up the counts of every thread
+	for(int t = 0; threads != NULL && t < num_threads; t++) {
+		const struct playout_stats *share = &threads[t].stats;
+
+		if (ok) {
+			stats->playouts += share->playouts;
+			stats->wins += share->wins;
+			stats->losses += share->losses;
+			stats->timeouts += share->timeouts;
+			stats->win_turns += share->win_turns;
+			stats->loss_turns += share->loss_turns;
+			for(int cell = 0; cell < level->num_cells; cell++)
+				stats->catches[cell] += share->catches[cell];
+		}
+		free(share->catches);
+	}
+	free(threads);
+	free(distance);
+	if (!ok) free_playout_stats(stats);
+
+	return ok;
+}
+
+/**
+ * Free the memory held by a playout_stats structure.
+ */
+void free_playout_stats(struct playout_stats *stats) {
+	free(stats->catches);
+	stats->catches = NULL;
+
+	return;
+}
+
+// Structure to hold the win rate of one level of a list (to order the list)
+struct playout_rank {
+	double win_rate;
+	int turns;		/* Turns of the shortest way out (INT_MAX if unsolvable): fewer breaks ties */
+	double loss_turns;	/* Mean turns to a loss (surviving longer breaks the remaining ties) */
+	int index;		/* Position of the level in the list */
+};
+
+/*
+ * Order levels from the highest win rate to the lowest, then from the fewest turns needed to
+ * escape to the most, then from the longest mean turns to a loss, then by position in the list.
+ * At a high epsilon most levels are never won, and the shortest way out then tells them apart.
+ */
+static int compare_ranks(const void *a, const void *b) {
+	const struct playout_rank *x = a, *y = b;
+
+	if (x->win_rate != y->win_rate) return (x->win_rate > y->win_rate) ? -1 : 1;
+	if (x->turns != y->turns) return (x->turns < y->turns) ? -1 : 1;
+	if (x->loss_turns != y->loss_turns) return (x->loss_turns > y->loss_turns) ? -1 : 1;
+	return x->index - y->index;
+}
+
+// Write the squares where Theseus was caught most, as "(row,col) percent" separated by commas
+static void format_catch_spots(const struct engine_level *level, const struct playout_stats *stats, char *text, size_t size) {
+	int spots[PLAYOUT_CATCH_SPOTS], num_spots = 0;
+
+	for(int cell = 0; cell < level->num_cells; cell++) {
+		if (stats->catches[cell] == 0) continue;
+
+		// Keep the spots sorted, most catches first
+		int at = num_spots;
+		while (at > 0 && stats->catches[spots[at - 1]] < stats->catches[cell]) at--;
+		if (at >= PLAYOUT_CATCH_SPOTS) continue;
+		if (num_spots < PLAYOUT_CATCH_SPOTS) num_spots++;
+		memmove(&spots[at + 1], &spots[at], sizeof(int) * (num_spots - 1 - at));
+		spots[at] = cell;
+	}
+
+	size_t used = 0;
+	text[0] = '\0';
+	for(int i = 0; i < num_spots && used < size; i++)
+		used += snprintf(text + used, size - used, "%s(%d,%d) %.0f%%", (i > 0) ? ", " : "", (spots[i] / level->num_cols) + 1,
+				 (spots[i] % level->num_cols) + 1, 100.0 * stats->catches[spots[i]] / stats->losses);
+	if (num_spots == 0) snprintf(text, size, "-");
+
+	return;
+}
+
+int run_playouts(const char *list_path, long count, double epsilon, int num_threads) {
+	struct level_list list;
+	int result = 0;
+
+	if (read_level_list(list_path, &list) != 0) {
+		fprintf(stderr, "theseus: %s: could not read level list\n", list_path);
+		return 1;
+	}
+
+	struct playout_rank *ranks = malloc(sizeof(struct playout_rank) * (list.num_levels + 1));
+	int num_ranked = 0;
+	if (ranks == NULL) {
+		fprintf(stderr, "theseus: out of memory\n");
+		free_level_list(&list);
+		return 1;
+	}
+
+	printf("%ld playouts per level, %.0f%% random moves\n\n", count, 100.0 * epsilon);
+	printf("%-30s %9s %9s %8s %8s %7s %6s  %s\n", "level", "playouts", "win rate", "to win", "to loss", "gave up", "turns", "caught at (row,col)");
+
+	for(int i = 0; i < list.num_levels; i++) {
+		struct stats board;
+		struct engine_level level;
+		struct playout_stats stats;
+
+		board.walls = NULL;
+		int status = read_level_file(list.paths[i], &board);
+		if (status != 0) {
+			fprintf(stderr, "theseus: %s: %s\n", list.paths[i], (status == 1) ? "could not open level file" : "invalid level file");
+			result = 1;
+			continue;
+		}
+		bool loaded = engine_load(&level, &board);
+		free_walls(board.walls);
+		if (!loaded || !playout_level(&level, count, epsilon, num_threads, PLAYOUT_SEED + i, &stats)) {
+			if (loaded) engine_free(&level);
+			fprintf(stderr, "theseus: %s: out of memory\n", list.paths[i]);
+			result = 1;
+			continue;
+		}
+
+		// The shortest way out, to order the levels the playouts can't tell apart
+		struct solution sol;
+		if (!solve_level(&level, SEARCH_ASTAR, &sol)) {
+			fprintf(stderr, "theseus: %s: out of memory\n", list.paths[i]);
+			free_playout_stats(&stats);
+			engine_free(&level);
+			result = 1;
+			continue;
+		}
+		int turns = sol.solvable ? sol.turns : INT_MAX;
+		free_solution(&sol);
+
+		char spots[PLAYOUT_CATCH_SPOTS * 24], turns_text[16];
+		double win_rate = (stats.playouts > 0) ? (double)stats.wins / stats.playouts : 0.0;
+		double loss_turns = (stats.losses > 0) ? (double)stats.loss_turns / stats.losses : 0.0;
+
+		format_catch_spots(&level, &stats, spots, sizeof(spots));
+		if (turns != INT_MAX) snprintf(turns_text, sizeof(turns_text), "%d", turns);
+		else snprintf(turns_text, sizeof(turns_text), "-");
+		printf("%-30s %9ld %8.2f%% %8.1f %8.1f %6.1f%% %6s  %s\n", list.paths[i], stats.playouts, 100.0 * win_rate,
+		       (stats.wins > 0) ? (double)stats.win_turns / stats.wins : 0.0,
+		       loss_turns,
+		       (stats.playouts > 0) ? 100.0 * stats.timeouts / stats.playouts : 0.0, turns_text, spots);
+		fflush(stdout);
+
+		ranks[num_ranked].win_rate = win_rate;
+		ranks[num_ranked].turns = turns;
+		ranks[num_ranked].loss_turns = loss_turns;
+		ranks[num_ranked].index = i;
+		num_ranked++;
+
+		free_playout_stats(&stats);
+		engine_free(&level);
+	}
+
+	// The levels the player wins most often come first
+	qsort(ranks, num_ranked, sizeof(struct playout_rank), compare_ranks);
+	printf("\nLevels by win rate (easiest first):\n");
+	for(int i = 0; i < num_ranked; i++)
+		printf("%s\n", list.paths[ranks[i].index]);
+
+	// Say so when the win rates leave levels tied, since the ordering then rests on the tie-breaks
+	int num_tied = 0;
+	for(int i = 0; i < num_ranked; i++)
+		if ((i > 0 && ranks[i].win_rate == ranks[i - 1].win_rate) || (i + 1 < num_ranked && ranks[i].win_rate == ranks[i + 1].win_rate)) num_tied++;
+	if (num_tied > 0)
+		printf("\nNote: %d of %d levels have the same win rate as another level, and are ordered by the turns of their\n"
+		       "shortest way out; a lower --epsilon or more --count may tell them apart.\n", num_tied, num_ranked);
+
+	free(ranks);
+	free_level_list(&list);
+
+	return result;
+}
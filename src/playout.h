@@ -0,0 +1,81 @@
+#ifndef _PLAYOUT_H
+#define _PLAYOUT_H
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "loader.h"
+#include "solver.h"
+
+#define PLAYOUT_COUNT 1000000		/* Default number of playouts per level */
+#define PLAYOUT_EPSILON 0.25		/* Default share of random moves of the greedy player */
+#define PLAYOUT_MAX_TURNS 200		/* Playouts still going after this many turns are given up */
+#define PLAYOUT_CATCH_SPOTS 3		/* Squares where Theseus is caught most, reported per level */
+
+// Structure to hold the results of the playouts of a level
+struct playout_stats {
+	long playouts;
+	long wins;
+	long losses;
+	long timeouts;			/* Playouts given up after PLAYOUT_MAX_TURNS turns */
+	long long win_turns;		/* Turns of every win, added up */
+	long long loss_turns;		/* Turns of every loss, added up */
+	long *catches;			/* Times Theseus was caught on each cell ('num_cells' entries) */
+};
+
+/**
+ * Play a level over and over with an epsilon-greedy player, to estimate how hard it is for
+ * a person rather than for the solver. On each move the player picks a random valid move
+ * with probability 'epsilon' (so 1 plays at random); otherwise he leaves out the moves that
+ * get him caught right away and takes the one that brings him closest to the exit, ignoring
+ * the Minotaur. The playouts are split between threads, each with its own random number
+ * generator and counters, and played on the render-free engine.
+ *
+ * 'level' specifies the level.
+ * 'count' specifies the number of playouts.
+ * 'epsilon' specifies the probability of a random move (0 to 1).
+ * 'num_threads' specifies the number of threads.
+ * 'seed' specifies the seed of the random number generators.
+ * 'stats' receives the results (free them with free_playout_stats()).
+ *
+ * Return Values:
+ *	true - The level was played.
+ *	false - Memory for the playouts could not be allocated.
+ */
+bool playout_level(const struct engine_level *level, long count, double epsilon, int num_threads, uint64_t seed, struct playout_stats *stats);
+
+/**
+ * Free the memory held by a playout_stats structure.
+ */
+void free_playout_stats(struct playout_stats *stats);
+
+/**
+ * Play out every level of a level list (see playout_level()) and print a table with, for
+ * each level, the win rate, the mean turns to a win and to a loss, the share of playouts
+ * given up, the turns of the shortest way out (see solve_level()) and the squares where Theseus
+ * is caught most. The levels are then listed from the highest win rate to the lowest, as an
+ * ordering for the level list: levels with the same win rate (often none won at all, with
+ * many random moves) are ordered by their shortest way out, then by the longest mean turns
+ * to a loss, and a note says how many levels the win rates left tied.
+ *
+ * 'list_path' specifies the file path of the level list.
+ * 'count' specifies the number of playouts per level.
+ * 'epsilon' specifies the probability of a random move.
+ * 'num_threads' specifies the number of threads.
+ *
+ * Return Values:
+ *	0 - Every level was played.
+ *	1 - The list or a level could not be read, or memory could not be allocated.
+ */
+int run_playouts(const char *list_path, long count, double epsilon, int num_threads);
+
+#endif	    // _PLAYOUT_H
@@ -1,7 +1,66 @@
 #include "loader.h"
-#include "movement.h"
+#include "engine.h"
 #include "scans.h"
 
+/**
+ * Scan the optional header lines of a level (rules and number of Minotaurs) from
+ * the given file into the correct members of the inputted stats structure.
+ */
+int scan_header(FILE *level, struct stats *board) {
+	char keyword[16], preference;
+	int c;
+
+	// Levels without header lines use the original rules and one Minotaur
+	board->rules.minotaur_steps = DEFAULT_MINOTAUR_STEPS;
+	board->rules.theseus_steps = DEFAULT_THESEUS_STEPS;
+	board->rules.vertical_first = false;
+	board->num_minotaurs = 1;
+
+	// Header lines start with a keyword, the rest of the level with a number
+	while (fscanf(level, " ") != EOF && (c = fgetc(level)) != EOF) {
+		ungetc(c, level);
+		if (c < 'a' || c > 'z') return 0;
+
+		if (fscanf(level, "%15s ", keyword) != 1) {
+			fclose(level);
+			return 1;
+		}
+
+		// Scan a rules header line from the file into memory
+		if (strcmp(keyword, "rules") == 0) {
+			if (fscanf(level, "%hd %c %hd ", &board->rules.minotaur_steps, &preference, &board->rules.theseus_steps) != 3) {
+				fclose(level);
+				return 1;
+			}
+			if (board->rules.minotaur_steps < 1 || board->rules.minotaur_steps > MAX_MINOTAUR_STEPS
+			    || board->rules.theseus_steps < 1 || board->rules.theseus_steps > MAX_THESEUS_STEPS
+			    || (preference != 'h' && preference != 'v')) {
+				fclose(level);
+				return 1;
+			}
+			board->rules.vertical_first = (preference == 'v');
+		}
+
+		// Scan a minotaurs header line from the file into memory
+		else if (strcmp(keyword, "minotaurs") == 0) {
+			if (fscanf(level, "%hd ", &board->num_minotaurs) != 1) {
+				fclose(level);
+				return 1;
+			}
+			if (board->num_minotaurs < 1 || board->num_minotaurs > MAX_MINOTAURS) {
+				fclose(level);
+				return 1;
+			}
+		}
+		else {
+			fclose(level);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
 /**
  * Scan the dimensions for a board from the given file into the correct
  * members of the inputted stats structure.
@@ -98,24 +157,36 @@ int scan_theseus(FILE *level, struct stats *board) {
 }
 
 /**
- * Scan the board position of the Minotaur from the given file into the correct
+ * Scan the board positions of the Minotaurs from the given file into the correct
  * members of the inputted stats structure.
  */
 int scan_minotaur(FILE *level, struct stats *board) {
 
-	// Scan the starting position of the Minotaur on the board from the file into memory
-	if (fscanf(level, " %hd %hd ", &board->minotaur.row, &board->minotaur.col) != 2) {
-		fclose(level);
-		return 1;
-	}
-	if (board->minotaur.row < 0 || board->minotaur.row >= board->size.num_rows
-	    || board->minotaur.col < 0 || board->minotaur.col >= board->size.num_cols) {
-		fclose(level);
-		return 1;
-	}
-	else if (board->minotaur.row == board->theseus.row && board->minotaur.col == board->theseus.col) {
-		fclose(level);
-		return 1;
+	// Scan the starting position of each Minotaur on the board from the file into memory
+	for(int i = 0; i < board->num_minotaurs; i++) {
+		cell_pos *minotaur = &board->minotaurs[i];
+
+		if (fscanf(level, " %hd %hd ", &minotaur->row, &minotaur->col) != 2) {
+			fclose(level);
+			return 1;
+		}
+		if (minotaur->row < 0 || minotaur->row >= board->size.num_rows
+		    || minotaur->col < 0 || minotaur->col >= board->size.num_cols) {
+			fclose(level);
+			return 1;
+		}
+		else if (minotaur->row == board->theseus.row && minotaur->col == board->theseus.col) {
+			fclose(level);
+			return 1;
+		}
+
+		// No two Minotaurs may start on the same square
+		for(int j = 0; j < i; j++) {
+			if (minotaur->row == board->minotaurs[j].row && minotaur->col == board->minotaurs[j].col) {
+				fclose(level);
+				return 1;
+			}
+		}
 	}
 
 	return 0;
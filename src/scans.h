@@ -3,10 +3,11 @@
 
 #include <stdio.h>
 
-#define NUM_SCANS 5
+#define NUM_SCANS 6
 
 // Enumerated values to represent scanner functions
-enum {
+typedef enum {
+	HEADER,
 	DIMENSIONS,
 	EXIT,
 	THESEUS,
@@ -15,6 +16,12 @@ enum {
 }
 scanner_funcs;
 
+/**
+ * Scan the optional header lines of a level (rules and number of Minotaurs) from
+ * the given file into the correct members of the inputted stats structure.
+ */
+int scan_header(FILE *level, struct stats *board);
+
 /**
  * Scan the dimensions for a board from the given file into the correct
  * members of the inputted stats structure.
@@ -34,7 +41,7 @@ int scan_exit(FILE *level, struct stats *board);
 int scan_theseus(FILE *level, struct stats *board);
 
 /**
- * Scan the board position of the Minotaur from the given file into the correct
+ * Scan the board positions of the Minotaurs from the given file into the correct
  * members of the inputted stats structure.
  */
 int scan_minotaur(FILE *level, struct stats *board);
@@ -0,0 +1,518 @@
+#include "server.h"
+
+#define SERVER_MAX_PENDING 65536	/* Stop reading from a session with this much unsent output */
+
+// Structure to hold one game session (one client connection)
+struct session {
+	int fd;
+
+	char in[SERVER_MAX_LINE];		/* Partial command line received so far */
+	size_t in_len;
+	bool discarding;			/* Skipping the rest of a line that was too long */
+
+	char *out;				/* Replies waiting to be sent */
+	size_t out_len, out_sent, out_cap;
+	bool failed;				/* A reply was lost for want of memory: the session is closed */
+
+	const struct engine_level *level;	/* Shared with other sessions (NULL until LOAD) */
+	struct engine_state state;
+	engine_result outcome;			/* ENGINE_MOVED while the game goes on */
+	int turns;
+
+	struct engine_state *history;		/* States before each turn (for UNDO) */
+	int hist_len, hist_cap;
+
+	struct session *prev, *next;		/* Links in the list of open sessions */
+};
+
+// Structure to hold a level file kept loaded by the server (levels are never changed once loaded)
+struct cached_level {
+	char *path;
+	struct engine_level level;
+};
+
+static const struct level_list *server_levels = NULL;	/* The only levels sessions may load */
+static struct cached_level level_cache[SERVER_MAX_LEVELS];
+static int num_cached = 0;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct session *open_sessions = NULL;
+static pthread_mutex_t sessions_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int listen_fd = -1;
+static int epoll_fd = -1;
+static int reserve_fd = -1;		/* Spare descriptor, given up to turn a connection away when none are left */
+static volatile sig_atomic_t server_stop = 0;
+
+static unsigned long long sessions_served = 0;
+static unsigned long long commands_served = 0;
+
+// Names for the outcome of a session's game
+static const char *status_name(engine_result result) {
+	switch (result) {
+		case ENGINE_BLOCKED:
+			return "BLOCKED";
+
+		case ENGINE_ESCAPED:
+			return "ESCAPED";
+
+		case ENGINE_CAUGHT:
+			return "CAUGHT";
+
+		default:
+			return "PLAYING";
+	}
+}
+
+// Stop the server on SIGINT or SIGTERM
+static void stop_handler(int signum) {
+	(void)signum;
+	server_stop = 1;
+
+	return;
+}
+
+/**
+ * Find a level in the server's cache of loaded levels, loading it from its file if
+ * it isn't there yet. Loaded levels are shared (read-only) by all sessions. Only the
+ * levels of the server's level list are loaded, never another file a client names.
+ *
+ * 'path' specifies the file path of the level, as written in the level list.
+ * 'error' receives a description of the problem when the level can't be loaded.
+ *
+ * Return Value:
+ *	The function returns the loaded level, or NULL if it could not be loaded.
+ */
+static const struct engine_level *load_cached_level(const char *path, const char **error) {
+	const struct engine_level *level = NULL;
+
+	pthread_mutex_lock(&cache_lock);
+
+	for(int i = 0; i < num_cached && level == NULL; i++) {
+		if (strcmp(level_cache[i].path, path) == 0)
+			level = &level_cache[i].level;
+	}
+
+	// Only paths of the level list are read (the list's own string, so that packed levels are found)
+	int index = -1;
+	for(int i = 0; i < server_levels->num_levels && index < 0 && level == NULL; i++)
+		if (strcmp(server_levels->paths[i], path) == 0) index = i;
+
+	if (level == NULL && index < 0) *error = "level is not in the server's level list";
+	else if (level == NULL) {
+		struct stats board;
+		board.walls = NULL;
+
+		int result = read_level(server_levels->paths[index], &board);
+		if (result == 1) *error = "level file could not be opened";
+		else if (result != 0) *error = "level file contains invalid data";
+		else if (num_cached >= SERVER_MAX_LEVELS) *error = "too many levels loaded";
+		else if (!engine_load(&level_cache[num_cached].level, &board)) *error = "out of memory";
+		else {
+			level_cache[num_cached].path = strdup(path);
+			level = &level_cache[num_cached++].level;
+		}
+
+		if (result == 0) free_walls(board.walls);
+	}
+
+	pthread_mutex_unlock(&cache_lock);
+
+	return level;
+}
+
+// Append a formatted reply line to a session's output buffer (a reply that doesn't fit in memory fails the session)
+static void reply(struct session *sess, const char *format, ...) {
+	char line[SERVER_MAX_LINE];
+	va_list args;
+
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line) - 1, format, args);
+	va_end(args);
+
+	if (length < 0) return;
+	if (length > (int)sizeof(line) - 2) length = sizeof(line) - 2;
+	line[length++] = '\n';
+
+	// Grow the output buffer if needed
+	if (sess->out_len + length > sess->out_cap) {
+		size_t new_cap = (sess->out_cap) ? sess->out_cap * 2 : 256;
+		while (new_cap < sess->out_len + length) new_cap *= 2;
+
+		char *new_out = realloc(sess->out, new_cap);
+		if (new_out == NULL) {
+			sess->failed = true;
+			return;
+		}
+
+		sess->out = new_out;
+		sess->out_cap = new_cap;
+	}
+	memcpy(sess->out + sess->out_len, line, length);
+	sess->out_len += length;
+
+	return;
+}
+
+// Write the positions of a session's characters as "T <row> <col> M <row> <col> ..." (one M per Minotaur)
+static void format_positions(const struct session *sess, char *buffer, size_t size) {
+	int ncols = sess->level->num_cols;
+	int length = snprintf(buffer, size, "T %d %d", sess->state.theseus / ncols, sess->state.theseus % ncols);
+
+	for(int i = 0; i < sess->level->num_minotaurs; i++)
+		length += snprintf(buffer + length, size - length, " M %d %d", sess->state.minotaurs[i] / ncols, sess->state.minotaurs[i] % ncols);
+
+	return;
+}
+
+// Append the reply describing the current state of a session's game
+static void reply_state(struct session *sess, engine_result status) {
+	char positions[16 * (MAX_MINOTAURS + 1)];
+
+	format_positions(sess, positions, sizeof(positions));
+	reply(sess, "OK %s %s %d", status_name(status), positions, sess->turns);
+
+	return;
+}
+
+/**
+ * Carry out one command line received from a session and queue the reply.
+ *
+ * 'sess' specifies the session the command came from.
+ * 'line' specifies the command line (without the newline).
+ *
+ * Return Values:
+ *	true - The session stays open.
+ *	false - The session asked to be closed.
+ */
+static bool handle_command(struct session *sess, char *line) {
+	char *command = strtok(line, " \t\r");
+	char *argument = strtok(NULL, " \t\r");
+
+	__atomic_fetch_add(&commands_served, 1, __ATOMIC_RELAXED);
+
+	if (command == NULL) {
+		reply(sess, "ERR empty command");
+	}
+	else if (strcmp(command, "LOAD") == 0) {
+		const char *error = NULL;
+		const struct engine_level *level;
+
+		if (argument == NULL) reply(sess, "ERR missing level file");
+		else if ((level = load_cached_level(argument, &error)) == NULL) reply(sess, "ERR %s", error);
+		else {
+			sess->level = level;
+			sess->outcome = ENGINE_MOVED;
+			sess->turns = 0;
+			sess->hist_len = 0;
+			engine_reset(level, &sess->state);
+
+			char positions[16 * (MAX_MINOTAURS + 1)];
+			format_positions(sess, positions, sizeof(positions));
+			reply(sess, "OK %d %d %s 0", level->num_rows, level->num_cols, positions);
+		}
+	}
+	else if (strcmp(command, "QUIT") == 0) {
+		reply(sess, "BYE");
+		return false;
+	}
+	else if (sess->level == NULL) {
+		reply(sess, "ERR no level loaded");
+	}
+	else if (strcmp(command, "MOVE") == 0) {
+		const char *directions = "LRUDS";	/* Same order as the moves_t values, then skip */
+		char *found = (argument != NULL && argument[0] != '\0') ? strchr(directions, argument[0]) : NULL;
+
+		if (found == NULL) reply(sess, "ERR unknown direction");
+		else if (sess->outcome != ENGINE_MOVED) reply(sess, "ERR game over");
+		else {
+			struct engine_state before = sess->state;
+			engine_result result = engine_turn(sess->level, &sess->state, (short)(found - directions));
+
+			if (result != ENGINE_BLOCKED) {
+
+				// Remember the state before this turn so it can be undone
+				if (sess->hist_len == sess->hist_cap) {
+					int new_cap = (sess->hist_cap) ? sess->hist_cap * 2 : 64;
+					struct engine_state *new_history = realloc(sess->history, sizeof(struct engine_state) * new_cap);
+
+					if (new_history != NULL) {
+						sess->history = new_history;
+						sess->hist_cap = new_cap;
+					}
+				}
+				if (sess->hist_len < sess->hist_cap)
+					sess->history[sess->hist_len++] = before;
+
+				sess->outcome = result;
+				sess->turns++;
+			}
+			reply_state(sess, result);
+		}
+	}
+	else if (strcmp(command, "UNDO") == 0) {
+		if (sess->hist_len == 0) reply(sess, "ERR nothing to undo");
+		else {
+			sess->state = sess->history[--sess->hist_len];
+			sess->outcome = ENGINE_MOVED;
+			sess->turns--;
+			reply_state(sess, sess->outcome);
+		}
+	}
+	else if (strcmp(command, "STATE") == 0) {
+		reply_state(sess, sess->outcome);
+	}
+	else reply(sess, "ERR unknown command");
+
+	return true;
+}
+
+// Remove a session from the list of open sessions and free it
+static void close_session(struct session *sess) {
+	pthread_mutex_lock(&sessions_lock);
+	if (sess->prev) sess->prev->next = sess->next;
+	else open_sessions = sess->next;
+	if (sess->next) sess->next->prev = sess->prev;
+	pthread_mutex_unlock(&sessions_lock);
+
+	close(sess->fd);		/* Also removes the descriptor from the epoll set */
+	free(sess->out);
+	free(sess->history);
+	free(sess);
+
+	return;
+}
+
+/**
+ * Handle the events for one session: read and carry out every complete command line,
+ * send as much of the pending output as possible, and re-arm the session in the epoll
+ * set (sessions are registered one-shot, so only one worker handles a session at once).
+ *
+ * 'sess' specifies the session to handle.
+ * 'events' specifies the epoll events that were reported for the session.
+ */
+static void handle_session(struct session *sess, unsigned int events) {
+	bool open = !(events & EPOLLERR);
+	char buffer[4096];
+	ssize_t length;
+
+	// Read and carry out commands (unless the client isn't reading its replies, or a reply was lost)
+	while (open && !sess->failed && (sess->out_len - sess->out_sent) < SERVER_MAX_PENDING) {
+		if ((length = read(sess->fd, buffer, sizeof(buffer))) <= 0) {
+			if (length == 0 || (errno != EAGAIN && errno != EINTR)) open = false;
+			break;
+		}
+
+		for(ssize_t i = 0; i < length && open && !sess->failed; i++) {
+			if (buffer[i] == '\n') {
+				sess->in[sess->in_len] = '\0';
+				if (sess->discarding) reply(sess, "ERR line too long");
+				else open = handle_command(sess, sess->in);
+
+				sess->in_len = 0;
+				sess->discarding = false;
+			}
+			else if (sess->in_len < SERVER_MAX_LINE - 1) sess->in[sess->in_len++] = buffer[i];
+			else sess->discarding = true;
+		}
+	}
+
+	// Send the queued replies
+	while (sess->out_sent < sess->out_len) {
+		length = send(sess->fd, sess->out + sess->out_sent, sess->out_len - sess->out_sent, MSG_NOSIGNAL);
+		if (length < 0) {
+			if (errno != EAGAIN && errno != EINTR) open = false;
+			break;
+		}
+		sess->out_sent += length;
+	}
+	if (sess->out_sent == sess->out_len) sess->out_len = sess->out_sent = 0;
+
+	// The client would wait forever for a reply that was lost, so the session ends after the replies before it
+	if (!open || sess->failed) {
+		close_session(sess);
+		return;
+	}
+
+	// Wait for more input, and for room to send if there's still output pending
+	struct epoll_event event;
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	if (sess->out_len) event.events |= EPOLLOUT;
+	event.data.ptr = sess;
+	epoll_ctl(epoll_fd, EPOLL_CTL_MOD, sess->fd, &event);
+
+	return;
+}
+
+/*
+ * Accept every pending connection as a new session, then re-arm the listening socket. The
+ * listening socket stays readable as long as a connection is pending, so a connection that
+ * can't be accepted for want of descriptors is accepted with the reserve descriptor and
+ * closed at once, and after any other failure the worker pauses before re-arming it.
+ */
+static void accept_sessions(void) {
+	int fd;
+
+	while (true) {
+		if ((fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+
+			// Out of descriptors: turn the connection away with the reserve one
+			if ((errno == EMFILE || errno == ENFILE) && reserve_fd >= 0) {
+				close(reserve_fd);
+				if ((fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC)) >= 0) close(fd);
+				reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+				if (fd >= 0) continue;
+			}
+
+			struct timespec pause = {0, SERVER_ACCEPT_PAUSE_MS * 1000000L};
+			nanosleep(&pause, NULL);
+			break;
+		}
+
+		struct session *sess = calloc(1, sizeof(struct session));
+		if (sess == NULL) {
+			close(fd);
+			continue;
+		}
+		sess->fd = fd;
+		sess->outcome = ENGINE_MOVED;
+
+		pthread_mutex_lock(&sessions_lock);
+		sess->next = open_sessions;
+		if (open_sessions) open_sessions->prev = sess;
+		open_sessions = sess;
+		pthread_mutex_unlock(&sessions_lock);
+
+		__atomic_fetch_add(&sessions_served, 1, __ATOMIC_RELAXED);
+
+		struct epoll_event event;
+		event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+		event.data.ptr = sess;
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+	}
+
+	struct epoll_event event;
+	event.events = EPOLLIN | EPOLLONESHOT;
+	event.data.ptr = NULL;				/* NULL marks the listening socket */
+	epoll_ctl(epoll_fd, EPOLL_CTL_MOD, listen_fd, &event);
+
+	return;
+}
+
+// Worker thread: wait for events on any session and handle them
+static void *server_worker(void *arg) {
+	struct epoll_event events[SERVER_MAX_EVENTS];
+	(void)arg;
+
+	while (!server_stop) {
+		int num_events = epoll_wait(epoll_fd, events, SERVER_MAX_EVENTS, 200);
+
+		for(int i = 0; i < num_events; i++) {
+			if (events[i].data.ptr == NULL) accept_sessions();
+			else handle_session(events[i].data.ptr, events[i].events);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Run a game server that hosts any number of concurrent game sessions on the render-free
+ * engine. Each connection to the Unix domain socket is one session, and all sessions are
+ * multiplexed with epoll over a small fixed pool of worker threads. Sessions speak a
+ * line-based protocol (one reply line per command line):
+ *
+ *	LOAD <level file>	->  OK <rows> <cols> <state>
+ *	MOVE <L|R|U|D|S>	->  OK <status> <state>
+ *	UNDO			->  OK <status> <state>
+ *	STATE			->  OK <status> <state>
+ *	QUIT			->  BYE
+ *
+ * where <status> is one of PLAYING, BLOCKED, ESCAPED or CAUGHT, and <state> is
+ * "T <row> <col> M <row> <col> <turns>" (one "M <row> <col>" per Minotaur, in level
+ * order). Errors are reported as "ERR <reason>". Only the levels of the level list the
+ * server was started with can be loaded: any other file path is refused, so a client
+ * can't make the server open files of its choosing.
+ * The server runs until it receives SIGINT or SIGTERM.
+ *
+ * 'socket_path' specifies the file path of the Unix domain socket to listen on.
+ * 'levels' specifies the level list whose levels can be loaded (see read_level()).
+ * 'num_threads' specifies the number of worker threads.
+ *
+ * Return Values:
+ *	0 - The server was shut down normally.
+ *	1 - The server could not be started.
+ */
+int run_server(const char *socket_path, const struct level_list *levels, int num_threads) {
+	struct sockaddr_un address;
+
+	server_levels = levels;
+
+	if (num_threads < 1) num_threads = 1;
+	if (strlen(socket_path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "theseus: socket path is too long: %s\n", socket_path);
+		return 1;
+	}
+
+	// Create the listening socket (replacing a stale socket file from an earlier run)
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socket_path);
+	unlink(socket_path);
+
+	listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(listen_fd, SOMAXCONN) < 0) {
+		perror("theseus: could not listen on socket");
+		return 1;
+	}
+
+	reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event event;
+	event.events = EPOLLIN | EPOLLONESHOT;
+	event.data.ptr = NULL;
+	if (epoll_fd < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) < 0) {
+		perror("theseus: could not create epoll instance");
+		return 1;
+	}
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stop_handler;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	fprintf(stderr, "theseus: serving on %s with %d threads\n", socket_path, num_threads);
+
+	// Run the worker threads until the server is told to stop
+	pthread_t workers[num_threads];
+	for(int i = 0; i < num_threads; i++)
+		pthread_create(&workers[i], NULL, server_worker, NULL);
+	for(int i = 0; i < num_threads; i++)
+		pthread_join(workers[i], NULL);
+
+	// Close everything down
+	while (open_sessions) close_session(open_sessions);
+	for(int i = 0; i < num_cached; i++) {
+		engine_free(&level_cache[i].level);
+		free(level_cache[i].path);
+	}
+	num_cached = 0;
+	close(epoll_fd);
+	close(listen_fd);
+	if (reserve_fd >= 0) close(reserve_fd);
+	unlink(socket_path);
+
+	// Report how much work was done per CPU second
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	double cpu_time = usage.ru_utime.tv_sec + (usage.ru_utime.tv_usec / 1e6) + usage.ru_stime.tv_sec + (usage.ru_stime.tv_usec / 1e6);
+
+	fprintf(stderr, "theseus: %llu sessions, %llu commands, %.2f CPU seconds (%.0f commands per CPU second)\n",
+		sessions_served, commands_served, cpu_time, (cpu_time > 0) ? commands_served / cpu_time : 0.0);
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+#ifndef _SERVER_H
+#define _SERVER_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "engine.h"
+#include "latency.h"
+#include "levelpack.h"
+#include "loader.h"
+
+#define SERVER_THREADS 4	/* Default number of worker threads */
+#define SERVER_MAX_LINE 512	/* Longest accepted protocol line (including the newline) */
+#define SERVER_MAX_EVENTS 64	/* Events taken from epoll per wake-up */
+#define SERVER_MAX_LEVELS 256	/* Distinct level files kept loaded by the server */
+#define SERVER_ACCEPT_PAUSE_MS 10	/* Pause before accepting again after accept() fails for want of resources */
+
+#define LOADGEN_SESSIONS 64	/* Default number of sessions opened by the load generator */
+#define LOADGEN_COMMANDS 100000	/* Default number of commands sent by the load generator */
+
+/**
+ * Run a game server that hosts any number of concurrent game sessions on the render-free
+ * engine. Each connection to the Unix domain socket is one session, and all sessions are
+ * multiplexed with epoll over a small fixed pool of worker threads. Sessions speak a
+ * line-based protocol (one reply line per command line):
+ *
+ *	LOAD <level file>	->  OK <rows> <cols> <state>
+ *	MOVE <L|R|U|D|S>	->  OK <status> <state>
+ *	UNDO			->  OK <status> <state>
+ *	STATE			->  OK <status> <state>
+ *	QUIT			->  BYE
+ *
+ * where <status> is one of PLAYING, BLOCKED, ESCAPED or CAUGHT, and <state> is
+ * "T <row> <col> M <row> <col> <turns>" (one "M <row> <col>" per Minotaur, in level
+ * order). Errors are reported as "ERR <reason>". Only the levels of the level list the
+ * server was started with can be loaded: any other file path is refused, so a client
+ * can't make the server open files of its choosing.
+ * The server runs until it receives SIGINT or SIGTERM.
+ *
+ * 'socket_path' specifies the file path of the Unix domain socket to listen on.
+ * 'levels' specifies the level list whose levels can be loaded (see read_level()).
+ * 'num_threads' specifies the number of worker threads.
+ *
+ * Return Values:
+ *	0 - The server was shut down normally.
+ *	1 - The server could not be started.
+ */
+int run_server(const char *socket_path, const struct level_list *levels, int num_threads);
+
+/**
+ * Drive a game server with a local load generator. A number of sessions are opened
+ * over the server's Unix domain socket, and each one loads the given level and then
+ * keeps sending a mix of MOVE, UNDO and STATE commands (one command in flight per
+ * session) until the total number of commands has been sent. The throughput and the
+ * latency distribution of the commands are printed when done.
+ *
+ * 'socket_path' specifies the file path of the server's Unix domain socket.
+ * 'level_path' specifies the level file the sessions play (as seen by the server).
+ * 'num_sessions' specifies how many sessions to open.
+ * 'num_commands' specifies the total number of commands to send.
+ * 'num_threads' specifies the number of threads driving the sessions.
+ *
+ * Return Values:
+ *	0 - The load was generated successfully.
+ *	1 - The server could not be reached or returned an error.
+ */
+int run_loadgen(const char *socket_path, const char *level_path, int num_sessions, long num_commands, int num_threads);
+
+#endif	    // _SERVER_H
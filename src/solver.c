@@ -0,0 +1,1227 @@
+#include "solver.h"
+#include "cache.h"
+#include "kernels.h"
+#include "latency.h"
+
+#define TURN_CODE_BASE (NUM_MOVES + 1)		/* A turn's moves are stored as digits in this base */
+
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL	/* Fibonacci hashing of the packed states */
+#define INITIAL_SLOTS 4096			/* Slots of the hashed search's table to start with (a power of two) */
+#define ASTAR_BUCKETS 4				/* Ring of open lists of A* (pending f values span at most 3) */
+#define LIST_CHUNK 1024				/* Smallest capacity of a state list */
+#define CANCEL_INTERVAL 1024			/* States expanded between checks of a level's cancel flag (a power of two) */
+
+// Structure to hold the visited set of the hashed search: an open-addressing table of packed
+// states, and the nodes (the states in the order they were found, which is also the BFS queue)
+struct hashed_search {
+	uint64_t *slots;		/* Packed state + 1 in each slot (0 marks an empty slot) */
+	long capacity;			/* Number of slots (a power of two, at most half full) */
+	int shift;			/* 64 - log2(capacity), to take the top bits of the hash */
+
+	uint64_t *keys;			/* Packed state of each node */
+	int *parent;			/* Node each node was first reached from */
+	unsigned char *via;		/* Moves of the turn that reached each node */
+	long num_nodes;
+	long node_capacity;
+};
+
+// Structure to hold a growable list of states (a frontier or an open list)
+struct state_list {
+	int *items;
+	long length;
+	long capacity;
+};
+
+// Structure to hold the memory of the bounded breadth-first search (reused by every pass)
+struct bounded_search {
+	unsigned char *visited;		/* One bit per (Theseus, Minotaur) state */
+	size_t visited_bytes;
+	struct state_list frontier[2];	/* Current and next layer, as (state, middle state) pairs */
+	long visited_count;		/* States visited by the last pass */
+	long expanded;			/* States expanded by every pass */
+};
+
+// Structure to hold where a pass of the bounded search ended
+struct layer_hit {
+	int depth;			/* Turns from the source (-1 if nothing was found) */
+	int state;			/* State found */
+	int middle;			/* State the path to it went through at the middle layer */
+	int code;			/* Moves of the escape (escape searches only) */
+	int moves;			/* Number of moves of the escape */
+};
+
+// Structure to hold a stretch of a solution that is still to be recovered
+struct path_stretch {
+	int from;
+	int to;
+	int length;			/* Turns from 'from' to 'to' */
+	int turn;			/* Turn of the solution the stretch starts at */
+};
+
+// Letters for the moves of a solution (indexed by move, SKIP_MOVE last)
+static const char move_letters[] = "LRUDS";
+
+// Whether the search of a level has been called off by another thread (see 'cancel' in engine_level)
+static inline bool search_cancelled(const struct engine_level *level) {
+	return level->cancel != NULL && __atomic_load_n(level->cancel, __ATOMIC_RELAXED);
+}
+
+// Write the letters of one turn's moves into a solution
+static void write_turn(struct solution *sol, int turn, int code, int count, int theseus_steps) {
+	for(int i = 0; i < count; i++, code /= TURN_CODE_BASE)
+		sol->moves[(turn * theseus_steps) + i] = move_letters[code % TURN_CODE_BASE];
+
+	return;
+}
+
+// Allocate the string of moves of a solution with a given number of turns (the last one cut to 'last_moves')
+static bool alloc_moves(struct solution *sol, int turns, int last_moves, int theseus_steps) {
+	int length = ((turns - 1) * theseus_steps) + last_moves;
+
+	sol->moves = malloc(length + 1);
+	if (sol->moves == NULL) return false;
+	sol->moves[length] = '\0';
+	sol->turns = turns;
+
+	return true;
+}
+
+// Turn the chain of parents from the final state back into a string of moves
+static bool build_solution(struct solution *sol, const int *parent, const unsigned char *via, int start, int last,
+			   int last_code, int last_moves, int theseus_steps) {
+	int turns = 1;
+
+	for(int s = last; s != start; s = parent[s])
+		turns++;
+	if (!alloc_moves(sol, turns, last_moves, theseus_steps)) return false;
+
+	// Fill in the turns from the last one back to the first
+	write_turn(sol, turns - 1, last_code, last_moves, theseus_steps);
+	for(int s = last, turn = turns - 2; s != start; s = parent[s], turn--)
+		write_turn(sol, turn, via[s], theseus_steps, theseus_steps);
+
+	return true;
+}
+
+// Append a state to a state list
+static bool list_push(struct state_list *list, int state) {
+	if (list->length == list->capacity) {
+		long capacity = (list->capacity > 0) ? list->capacity * 2 : LIST_CHUNK;
+
+		int *items = realloc(list->items, sizeof(int) * capacity);
+		if (items == NULL) return false;
+
+		list->items = items;
+		list->capacity = capacity;
+	}
+	list->items[list->length++] = state;
+
+	return true;
+}
+
+/**
+ * Compute the number of moves Theseus needs to escape from every cell, ignoring the Minotaur,
+ * with one breadth-first search from the exit over the move masks (-1 for cells he can't
+ * escape from). Moves are symmetric apart from the exit, so searching out from the exit gives
+ * the distances to it.
+ *
+ * 'level' specifies the level.
+ * 'distance' receives the moves for each cell (counting the move through the exit).
+ *
+ * Return Values:
+ *	true - The distances were computed.
+ *	false - Memory for the search could not be allocated.
+ */
+bool compute_exit_distances(const struct engine_level *level, int *distance) {
+	int *queue = malloc(sizeof(int) * level->num_cells);
+	if (queue == NULL) return false;
+
+	for(int i = 0; i < level->num_cells; i++)
+		distance[i] = -1;
+
+	int head = 0, tail = 0;
+	distance[level->exit_cell] = 1;
+	queue[tail++] = level->exit_cell;
+
+	while (head < tail) {
+		int cell = queue[head++];
+
+		for(int move = 0; move < NUM_MOVES; move++) {
+			int next = theseus_step(level, cell, move);
+
+			if (next >= 0 && distance[next] < 0) {
+				distance[next] = distance[cell] + 1;
+				queue[tail++] = next;
+			}
+		}
+	}
+	free(queue);
+
+	return true;
+}
+
+// Find the first turn (in code order) that lets Theseus escape from a state: returns its number of moves (0 if none)
+KERNEL_INLINE int find_escape(const struct engine_level *level, int theseus, int minotaur, int theseus_steps, int *escape_code) {
+	int num_codes = (theseus_steps > 1) ? TURN_CODE_BASE * TURN_CODE_BASE : TURN_CODE_BASE;
+
+	for(int code = 0; code < num_codes; code++) {
+		int cell = theseus, rest = code;
+
+		for(int i = 0; i < theseus_steps; i++, rest /= TURN_CODE_BASE) {
+			int next = theseus_step(level, cell, rest % TURN_CODE_BASE);
+
+			if (next == THESEUS_BLOCKED || next == minotaur) break;
+			if (next == THESEUS_ESCAPED) {
+				*escape_code = code;
+				return i + 1;
+			}
+			cell = next;
+		}
+	}
+
+	return 0;
+}
+
+// Find the cell Theseus must have come from to reach 'cell' with a move (THESEUS_BLOCKED if there is none)
+KERNEL_INLINE int theseus_unstep(const struct engine_level *level, int cell, int move) {
+	int prev;
+
+	switch (move) {
+		case LEFT:
+			prev = cell + 1;
+			break;
+
+		case RIGHT:
+			prev = cell - 1;
+			break;
+
+		case UP:
+			prev = cell + level->num_cols;
+			break;
+
+		case DOWN:
+			prev = cell - level->num_cols;
+			break;
+
+		default:
+			return cell;
+	}
+
+	// Checking the move forward rules out walls, wrapping around rows and the exit
+	if (prev < 0 || prev >= level->num_cells || theseus_step(level, prev, move) != cell) return THESEUS_BLOCKED;
+
+	return prev;
+}
+
+// Check the bit of a state in a visited bitmap
+KERNEL_INLINE bool is_visited(const unsigned char *visited, int state) {
+	return visited[state >> 3] & (1 << (state & 7));
+}
+
+// Set the bit of a state in a visited bitmap
+KERNEL_INLINE void set_visited(unsigned char *visited, int state) {
+	visited[state >> 3] |= 1 << (state & 7);
+
+	return;
+}
+
+// Find the moves of a turn that takes the game from one state to another (-1 if there are none)
+KERNEL_INLINE int find_turn(const struct engine_level *level, int from, int to, int minotaur_steps, bool vertical_first, int theseus_steps) {
+	int num_cells = level->num_cells;
+	int num_codes = (theseus_steps > 1) ? TURN_CODE_BASE * TURN_CODE_BASE : TURN_CODE_BASE;
+	int theseus = from / num_cells, minotaur = from % num_cells;
+
+	for(int code = 0; code < num_codes; code++) {
+		int cell = theseus, rest = code;
+		bool alive = true;
+
+		for(int i = 0; i < theseus_steps && alive; i++, rest /= TURN_CODE_BASE) {
+			int next = theseus_step(level, cell, rest % TURN_CODE_BASE);
+
+			if (next < 0 || next == minotaur) alive = false;
+			else cell = next;
+		}
+
+		if (alive && (cell * num_cells) + minotaur_turn(level, cell, minotaur, minotaur_steps, vertical_first) == to) return code;
+	}
+
+	return -1;
+}
+
+/*
+ * One pass of the bounded breadth-first search, from 'source' until 'target' is reached (or,
+ * if 'target' is negative, until a state Theseus can escape from is expanded). The frontier
+ * entries are pairs of states: the state itself and, from layer 'middle' on, the state it
+ * went through at that layer, so that the middle of the path is known once the search ends.
+ */
+KERNEL_INLINE bool layer_search(const struct engine_level *level, struct bounded_search *search, int source, int target, int middle,
+				struct layer_hit *hit, int minotaur_steps, bool vertical_first, int theseus_steps) {
+	int num_cells = level->num_cells;
+	int num_codes = (theseus_steps > 1) ? TURN_CODE_BASE * TURN_CODE_BASE : TURN_CODE_BASE;
+	struct state_list *current = &search->frontier[0], *next = &search->frontier[1];
+
+	memset(search->visited, 0, search->visited_bytes);
+	set_visited(search->visited, source);
+	search->visited_count = 1;
+	hit->depth = -1;
+	hit->state = hit->middle = source;
+	hit->code = 0;
+	hit->moves = 0;
+
+	current->length = 0;
+	if (!list_push(current, source) || !list_push(current, source)) return false;
+
+	for(int depth = 0; current->length > 0; depth++) {
+		if (search_cancelled(level)) return false;
+		next->length = 0;
+
+		for(long k = 0; k < current->length; k += 2) {
+			int state = current->items[k];
+			int via_middle = (depth == middle) ? state : current->items[k + 1];
+			int theseus = state / num_cells, minotaur = state % num_cells;
+			search->expanded++;
+
+			// Try every sequence of moves Theseus can make in one turn (skips included)
+			for(int code = 0; code < num_codes; code++) {
+				int cell = theseus, moves_made = 0, rest = code;
+				bool alive = true;
+
+				for(int i = 0; i < theseus_steps && alive; i++, rest /= TURN_CODE_BASE) {
+					int step = theseus_step(level, cell, rest % TURN_CODE_BASE);
+
+					moves_made++;
+					if (step == THESEUS_BLOCKED || step == minotaur) alive = false;
+					else if (step == THESEUS_ESCAPED) {
+						if (target < 0) {
+							hit->depth = depth;
+							hit->state = state;
+							hit->middle = via_middle;
+							hit->code = code;
+							hit->moves = moves_made;
+							return true;
+						}
+						alive = false;
+					}
+					else cell = step;
+				}
+				if (!alive) continue;
+
+				int next_minotaur = minotaur_turn(level, cell, minotaur, minotaur_steps, vertical_first);
+				if (next_minotaur == cell) continue;
+
+				int next_state = (cell * num_cells) + next_minotaur;
+				if (is_visited(search->visited, next_state)) continue;
+				set_visited(search->visited, next_state);
+				search->visited_count++;
+
+				int next_middle = (depth + 1 == middle) ? next_state : via_middle;
+				if (next_state == target) {
+					hit->depth = depth + 1;
+					hit->state = next_state;
+					hit->middle = next_middle;
+					return true;
+				}
+				if (!list_push(next, next_state) || !list_push(next, next_middle)) return false;
+			}
+		}
+
+		struct state_list *swap = current;
+		current = next;
+		next = swap;
+	}
+
+	return true;
+}
+
+/*
+ * Breadth-first search over whole turns for a given rule variant (the variant arguments are
+ * constants where inlined), bounded in memory: the visited states are one bit each, and the
+ * frontier is the current and next layer only, with no parents kept. The first pass finds how
+ * many turns are needed and the state Theseus escapes from; the turns leading to that state
+ * are then recovered by divide and conquer, searching again between the two ends of a stretch
+ * of the path to find its middle state, until every stretch is a single turn.
+ */
+KERNEL_INLINE bool bfs_kernel(const struct engine_level *level, struct solution *sol, int minotaur_steps, bool vertical_first, int theseus_steps) {
+	int num_cells = level->num_cells;
+	long num_states = (long)num_cells * num_cells;
+	struct bounded_search search = {NULL, (num_states + 7) / 8, {{NULL, 0, 0}, {NULL, 0, 0}}, 0, 0};
+	struct layer_hit hit;
+
+	search.visited = malloc(search.visited_bytes);
+	bool ok = (search.visited != NULL);
+
+	sol->solvable = false;
+	sol->turns = 0;
+	sol->moves = NULL;
+	sol->states = 0;
+	sol->expanded = 0;
+	sol->memory = 0;
+
+	if (ok) {
+		int start = (level->theseus_start * num_cells) + level->minotaur_starts[0];
+
+		ok = layer_search(level, &search, start, -1, -1, &hit, minotaur_steps, vertical_first, theseus_steps);
+		sol->states = search.visited_count;
+
+		if (ok && hit.depth >= 0) {
+			struct path_stretch stretches[2 * 32];
+			int top = 0;
+
+			sol->solvable = true;
+			ok = alloc_moves(sol, hit.depth + 1, hit.moves, theseus_steps);
+			if (ok) write_turn(sol, hit.depth, hit.code, hit.moves, theseus_steps);
+
+			// Split the path from the start to the escape into halves until single turns are left
+			if (hit.depth > 0) stretches[top++] = (struct path_stretch){start, hit.state, hit.depth, 0};
+
+			while (top > 0 && ok) {
+				struct path_stretch stretch = stretches[--top];
+
+				if (stretch.length == 1) {
+					int code = find_turn(level, stretch.from, stretch.to, minotaur_steps, vertical_first, theseus_steps);
+					write_turn(sol, stretch.turn, code, theseus_steps, theseus_steps);
+					continue;
+				}
+
+				int half = stretch.length / 2;
+				ok = layer_search(level, &search, stretch.from, stretch.to, half, &hit, minotaur_steps, vertical_first, theseus_steps)
+				     && hit.depth == stretch.length;
+				if (!ok) break;
+
+				stretches[top++] = (struct path_stretch){stretch.from, hit.middle, half, stretch.turn};
+				stretches[top++] = (struct path_stretch){hit.middle, stretch.to, stretch.length - half, stretch.turn + half};
+			}
+		}
+
+		sol->expanded = search.expanded;
+		sol->memory = search.visited_bytes + (sizeof(int) * (search.frontier[0].capacity + search.frontier[1].capacity));
+	}
+
+	free(search.visited);
+	free(search.frontier[0].items);
+	free(search.frontier[1].items);
+
+	return ok;
+}
+
+// One specialized copy of the search per rule variant
+#define DEFINE_SOLVER(NAME, MSTEPS, VFIRST, TSTEPS) \
+	static bool solve_##NAME(const struct engine_level *level, struct solution *sol) { \
+		return bfs_kernel(level, sol, MSTEPS, VFIRST, TSTEPS); \
+	}
+RULE_VARIANTS(DEFINE_SOLVER)
+
+// Replace the table of the hashed search with an empty one of a given size, then put every node back in
+static bool resize_table(struct hashed_search *search, long capacity) {
+	uint64_t *slots = calloc(capacity, sizeof(uint64_t));
+	if (slots == NULL) return false;
+
+	free(search->slots);
+	search->slots = slots;
+	search->capacity = capacity;
+	search->shift = 64;
+	for(long c = capacity; c > 1; c >>= 1)
+		search->shift--;
+
+	for(long n = 0; n < search->num_nodes; n++) {
+		long slot = (long)((search->keys[n] * HASH_MULTIPLIER) >> search->shift);
+
+		while (slots[slot] != 0)
+			slot = (slot + 1) & (capacity - 1);
+		slots[slot] = search->keys[n] + 1;
+	}
+
+	return true;
+}
+
+// Add a state to the hashed search unless it was seen before: returns 1 if added, 0 if seen, -1 if out of memory
+static int visit_state(struct hashed_search *search, uint64_t key, int parent, int code) {
+	long slot = (long)((key * HASH_MULTIPLIER) >> search->shift);
+
+	// Linear probing until the state or an empty slot is found
+	while (search->slots[slot] != 0) {
+		if (search->slots[slot] == key + 1) return 0;
+		slot = (slot + 1) & (search->capacity - 1);
+	}
+
+	if (search->num_nodes == search->node_capacity) {
+		long capacity = search->node_capacity * 2;
+
+		uint64_t *keys = realloc(search->keys, sizeof(uint64_t) * capacity);
+		if (keys == NULL) return -1;
+		search->keys = keys;
+
+		int *parents = realloc(search->parent, sizeof(int) * capacity);
+		if (parents == NULL) return -1;
+		search->parent = parents;
+
+		unsigned char *via = realloc(search->via, capacity);
+		if (via == NULL) return -1;
+		search->via = via;
+
+		search->node_capacity = capacity;
+	}
+
+	long node = search->num_nodes++;
+	search->keys[node] = key;
+	search->parent[node] = parent;
+	search->via[node] = code;
+	search->slots[slot] = key + 1;
+
+	// Keep the table at most half full so that probe sequences stay short
+	if (search->num_nodes * 2 > search->capacity && !resize_table(search, search->capacity * 2)) return -1;
+
+	return 1;
+}
+
+// Breadth-first search over whole turns with several Minotaurs, for a given rule variant (see bfs_kernel())
+KERNEL_INLINE bool hashed_bfs_kernel(const struct engine_level *level, struct solution *sol, int minotaur_steps, bool vertical_first, int theseus_steps) {
+	struct hashed_search search = {NULL, 0, 0, NULL, NULL, NULL, 0, INITIAL_SLOTS / 2};
+	int count = level->num_minotaurs;
+	int bits = 1;
+
+	// Each state is packed into one word: Theseus' cell, then each Minotaur's cell, 'bits' bits apiece
+	while ((1 << bits) < level->num_cells)
+		bits++;
+	uint64_t cell_mask = ((uint64_t)1 << bits) - 1;
+
+	search.keys = malloc(sizeof(uint64_t) * search.node_capacity);
+	search.parent = malloc(sizeof(int) * search.node_capacity);
+	search.via = malloc(search.node_capacity);
+	bool ok = (search.keys != NULL && search.parent != NULL && search.via != NULL && resize_table(&search, INITIAL_SLOTS));
+
+	sol->solvable = false;
+	sol->turns = 0;
+	sol->moves = NULL;
+	sol->states = 0;
+	sol->expanded = 0;
+	sol->memory = 0;
+
+	if (ok) {
+		uint64_t start = level->theseus_start;
+		long head = 0;
+		int goal = -1, goal_code = 0, goal_moves = 0;
+		int num_codes = (theseus_steps > 1) ? TURN_CODE_BASE * TURN_CODE_BASE : TURN_CODE_BASE;
+
+		for(int k = 0; k < count; k++)
+			start |= (uint64_t)level->minotaur_starts[k] << (bits * (k + 1));
+		visit_state(&search, start, 0, 0);
+
+		while (head < search.num_nodes && goal < 0 && ok) {
+			int node = head++;
+			if ((node & (CANCEL_INTERVAL - 1)) == 0 && search_cancelled(level)) {
+				ok = false;
+				break;
+			}
+			uint64_t key = search.keys[node];
+			int theseus = key & cell_mask;
+			int minotaurs[MAX_MINOTAURS];
+
+			for(int k = 0; k < count; k++)
+				minotaurs[k] = (key >> (bits * (k + 1))) & cell_mask;
+
+			// Try every sequence of moves Theseus can make in one turn (skips included)
+			for(int code = 0; code < num_codes && goal < 0 && ok; code++) {
+				int cell = theseus, moves_made = 0, rest = code;
+				bool alive = true;
+
+				for(int i = 0; i < theseus_steps && alive; i++, rest /= TURN_CODE_BASE) {
+					int next = theseus_step(level, cell, rest % TURN_CODE_BASE);
+
+					moves_made++;
+					if (next == THESEUS_BLOCKED || on_minotaur(minotaurs, count, next)) alive = false;
+					else if (next == THESEUS_ESCAPED) {
+						goal = node;
+						goal_code = code;
+						goal_moves = moves_made;
+						alive = false;
+					}
+					else cell = next;
+				}
+				if (!alive) continue;
+
+				int next_minotaurs[MAX_MINOTAURS];
+				memcpy(next_minotaurs, minotaurs, sizeof(int) * count);
+				if (minotaurs_turn(level, cell, next_minotaurs, count, minotaur_steps, vertical_first)) continue;
+
+				uint64_t next_key = cell;
+				for(int k = 0; k < count; k++)
+					next_key |= (uint64_t)next_minotaurs[k] << (bits * (k + 1));
+				if (visit_state(&search, next_key, node, code) < 0) ok = false;
+			}
+		}
+
+		sol->states = search.num_nodes;
+		sol->expanded = head;
+		sol->memory = (sizeof(uint64_t) * search.capacity) + ((sizeof(uint64_t) + sizeof(int) + 1) * search.node_capacity);
+		if (ok && goal >= 0) {
+			sol->solvable = true;
+			ok = build_solution(sol, search.parent, search.via, 0, goal, goal_code, goal_moves, theseus_steps);
+		}
+	}
+
+	free(search.slots);
+	free(search.keys);
+	free(search.parent);
+	free(search.via);
+
+	return ok;
+}
+
+// One specialized copy of the hashed search per rule variant
+#define DEFINE_HASHED_SOLVER(NAME, MSTEPS, VFIRST, TSTEPS) \
+	static bool solve_hashed_##NAME(const struct engine_level *level, struct solution *sol) { \
+		return hashed_bfs_kernel(level, sol, MSTEPS, VFIRST, TSTEPS); \
+	}
+RULE_VARIANTS(DEFINE_HASHED_SOLVER)
+
+// A* search over whole turns for a given rule variant, guided by Theseus' distance to the exit
+KERNEL_INLINE bool astar_kernel(const struct engine_level *level, struct solution *sol, int minotaur_steps, bool vertical_first, int theseus_steps) {
+	int num_cells = level->num_cells;
+	long num_states = (long)num_cells * num_cells;
+
+	// The pages of the tables are only touched (and zeroed) as states are reached
+	int *cost = calloc(num_states, sizeof(int));		/* Turns to reach each state + 1, negated once expanded (0 if never reached) */
+	int *parent = malloc(sizeof(int) * num_states);
+	unsigned char *via = malloc(num_states);
+	int *distance = malloc(sizeof(int) * num_cells);	/* Moves from each cell to escape (see compute_exit_distances()) */
+	struct state_list open[ASTAR_BUCKETS] = {{NULL, 0, 0}};	/* States waiting to be expanded, by f value (modulo ASTAR_BUCKETS) */
+	bool ok = (cost != NULL && parent != NULL && via != NULL && distance != NULL && compute_exit_distances(level, distance));
+
+	sol->solvable = false;
+	sol->turns = 0;
+	sol->moves = NULL;
+	sol->states = 0;
+	sol->expanded = 0;
+	sol->memory = ((sizeof(int) * 2) + 1) * num_states;
+
+	// The heuristic (turns Theseus needs to escape, ignoring the Minotaur) never overestimates and
+	// drops by at most one per turn, so the first state expanded is reached by a shortest path
+	#define HEURISTIC(cell) ((distance[cell] + theseus_steps - 1) / theseus_steps)
+
+	if (ok && distance[level->theseus_start] > 0) {
+		int start = (level->theseus_start * num_cells) + level->minotaur_starts[0];
+		int goal = -1, goal_code = 0, goal_moves = 0;
+		int num_codes = (theseus_steps > 1) ? TURN_CODE_BASE * TURN_CODE_BASE : TURN_CODE_BASE;
+		int f = HEURISTIC(level->theseus_start);
+		long pending = 1;
+
+		cost[start] = 1;
+		ok = list_push(&open[f % ASTAR_BUCKETS], start);
+		sol->states = 1;
+
+		while (pending > 0 && goal < 0 && ok) {
+
+			// Take a state with the lowest f value (the last one added, to go deep on ties)
+			while (open[f % ASTAR_BUCKETS].length == 0)
+				f++;
+			int state = open[f % ASTAR_BUCKETS].items[--open[f % ASTAR_BUCKETS].length];
+			pending--;
+
+			// Skip states that were found again by a shorter path and already expanded
+			if (cost[state] < 0) continue;
+			int turns = cost[state];
+			cost[state] = -turns;
+			if ((++sol->expanded & (CANCEL_INTERVAL - 1)) == 0 && search_cancelled(level)) {
+				ok = false;
+				break;
+			}
+
+			int theseus = state / num_cells, minotaur = state % num_cells;
+
+			// Try every sequence of moves Theseus can make in one turn (skips included)
+			for(int code = 0; code < num_codes && goal < 0 && ok; code++) {
+				int cell = theseus, moves_made = 0, rest = code;
+				bool alive = true;
+
+				for(int i = 0; i < theseus_steps && alive; i++, rest /= TURN_CODE_BASE) {
+					int next = theseus_step(level, cell, rest % TURN_CODE_BASE);
+
+					moves_made++;
+					if (next == THESEUS_BLOCKED || next == minotaur) alive = false;
+					else if (next == THESEUS_ESCAPED) {
+						goal = state;
+						goal_code = code;
+						goal_moves = moves_made;
+						alive = false;
+					}
+					else cell = next;
+				}
+				if (!alive) continue;
+
+				int next_minotaur = minotaur_turn(level, cell, minotaur, minotaur_steps, vertical_first);
+				if (next_minotaur == cell) continue;
+
+				int next_state = (cell * num_cells) + next_minotaur;
+				if (cost[next_state] == 0 || cost[next_state] > turns + 1) {
+					if (cost[next_state] == 0) sol->states++;
+					cost[next_state] = turns + 1;
+					parent[next_state] = state;
+					via[next_state] = code;
+
+					ok = list_push(&open[(turns + HEURISTIC(cell)) % ASTAR_BUCKETS], next_state);
+					pending++;
+				}
+			}
+		}
+
+		if (ok && goal >= 0) {
+			sol->solvable = true;
+			ok = build_solution(sol, parent, via, start, goal, goal_code, goal_moves, theseus_steps);
+		}
+	}
+
+	#undef HEURISTIC
+
+	for(int i = 0; i < ASTAR_BUCKETS; i++)
+		free(open[i].items);
+	free(cost);
+	free(parent);
+	free(via);
+	free(distance);
+
+	return ok;
+}
+
+// One specialized copy of the A* search per rule variant
+#define DEFINE_ASTAR_SOLVER(NAME, MSTEPS, VFIRST, TSTEPS) \
+	static bool solve_astar_##NAME(const struct engine_level *level, struct solution *sol) { \
+		return astar_kernel(level, sol, MSTEPS, VFIRST, TSTEPS); \
+	}
+RULE_VARIANTS(DEFINE_ASTAR_SOLVER)
+
+/*
+ * Bidirectional breadth-first search over whole turns for a given rule variant. The forward
+ * side starts from the start state; the backward side starts from every state Theseus can
+ * escape from in one turn, and steps back through the turns: Theseus' moves are undone, and
+ * the Minotaur can only have come from a cell within his steps of where he is. Whole layers
+ * are expanded at a time, always on the side with the smaller frontier, and the search ends
+ * with the layer in which the two sides first meet.
+ */
+KERNEL_INLINE bool bidirectional_kernel(const struct engine_level *level, struct solution *sol, int minotaur_steps, bool vertical_first, int theseus_steps) {
+	int num_cells = level->num_cells, ncols = level->num_cols;
+	long num_states = (long)num_cells * num_cells;
+
+	// The pages of the tables are only touched (and zeroed) as states are reached
+	int *fcost = calloc(num_states, sizeof(int));		/* Turns from the start to each state + 1 (0 if not reached) */
+	int *fparent = malloc(sizeof(int) * num_states);
+	unsigned char *fvia = malloc(num_states);
+	int *bcost = calloc(num_states, sizeof(int));		/* Turns from each state to an escape + 1 (0 if not reached) */
+	int *bnext = malloc(sizeof(int) * num_states);		/* State each state leads to on the way to the escape */
+	unsigned char *bvia = malloc(num_states);		/* Moves of the turn to 'bnext' (or of the escape) */
+	int *distance = malloc(sizeof(int) * num_cells);
+	struct state_list frontier[2][2] = {{{NULL, 0, 0}, {NULL, 0, 0}}, {{NULL, 0, 0}, {NULL, 0, 0}}};	/* Current and next layer, forward then backward */
+	bool ok = (fcost != NULL && fparent != NULL && fvia != NULL && bcost != NULL && bnext != NULL && bvia != NULL
+		   && distance != NULL && compute_exit_distances(level, distance));
+
+	sol->solvable = false;
+	sol->turns = 0;
+	sol->moves = NULL;
+	sol->states = 0;
+	sol->expanded = 0;
+	sol->memory = (((sizeof(int) * 2) + 1) * 2) * num_states;
+
+	if (ok) {
+		int start = (level->theseus_start * num_cells) + level->minotaur_starts[0];
+		int meet = -1, best = 0;
+		int fdepth = 0, bdepth = 0;
+		int num_codes = (theseus_steps > 1) ? TURN_CODE_BASE * TURN_CODE_BASE : TURN_CODE_BASE;
+		struct state_list *forward = frontier[0], *backward = frontier[1];
+
+		fcost[start] = 1;
+		ok = list_push(&forward[0], start);
+		sol->states++;
+
+		// Start the backward side from every state Theseus can escape from in one turn
+		for(int theseus = 0; theseus < num_cells && ok; theseus++) {
+			if (distance[theseus] < 0 || distance[theseus] > theseus_steps) continue;
+
+			for(int minotaur = 0; minotaur < num_cells && ok; minotaur++) {
+				int code, state = (theseus * num_cells) + minotaur;
+				if (minotaur == theseus || find_escape(level, theseus, minotaur, theseus_steps, &code) == 0) continue;
+
+				bcost[state] = 1;
+				bvia[state] = code;
+				ok = list_push(&backward[0], state);
+				sol->states++;
+			}
+		}
+		if (bcost[start] > 0) {
+			meet = start;
+			best = 1;
+		}
+
+		while (meet < 0 && forward[0].length > 0 && backward[0].length > 0 && ok) {
+			if (search_cancelled(level)) {
+				ok = false;
+				break;
+			}
+
+			if (forward[0].length <= backward[0].length) {
+
+				// Expand a whole forward layer
+				forward[1].length = 0;
+				for(long k = 0; k < forward[0].length && ok; k++) {
+					int state = forward[0].items[k];
+					int theseus = state / num_cells, minotaur = state % num_cells;
+					sol->expanded++;
+
+					for(int code = 0; code < num_codes && ok; code++) {
+						int cell = theseus, rest = code;
+						bool alive = true;
+
+						for(int i = 0; i < theseus_steps && alive; i++, rest /= TURN_CODE_BASE) {
+							int next = theseus_step(level, cell, rest % TURN_CODE_BASE);
+
+							// Escapes are found by the backward side
+							if (next < 0 || next == minotaur) alive = false;
+							else cell = next;
+						}
+						if (!alive) continue;
+
+						int next_minotaur = minotaur_turn(level, cell, minotaur, minotaur_steps, vertical_first);
+						if (next_minotaur == cell) continue;
+
+						int next_state = (cell * num_cells) + next_minotaur;
+						if (fcost[next_state] != 0) continue;
+
+						fcost[next_state] = fdepth + 2;
+						fparent[next_state] = state;
+						fvia[next_state] = code;
+						ok = list_push(&forward[1], next_state);
+						sol->states++;
+
+						if (bcost[next_state] > 0 && (meet < 0 || (fdepth + 1) + bcost[next_state] < best)) {
+							meet = next_state;
+							best = (fdepth + 1) + bcost[next_state];
+						}
+					}
+				}
+
+				struct state_list swap = forward[0];
+				forward[0] = forward[1];
+				forward[1] = swap;
+				fdepth++;
+			}
+			else {
+
+				// Expand a whole backward layer
+				backward[1].length = 0;
+				for(long k = 0; k < backward[0].length && ok; k++) {
+					int state = backward[0].items[k];
+					int theseus = state / num_cells, minotaur = state % num_cells;
+					int m_row = minotaur / ncols, m_col = minotaur % ncols;
+					int sources[(2 * MAX_MINOTAUR_STEPS + 1) * (2 * MAX_MINOTAUR_STEPS + 1)];
+					int num_sources = 0;
+					sol->expanded++;
+
+					// Find the cells the Minotaur could have started the turn from
+					for(int dr = -minotaur_steps; dr <= minotaur_steps; dr++) {
+						int span = minotaur_steps - abs(dr);
+
+						for(int dc = -span; dc <= span; dc++) {
+							int row = m_row + dr, col = m_col + dc;
+							if (row < 0 || row >= level->num_rows || col < 0 || col >= ncols) continue;
+
+							int source = (row * ncols) + col;
+							if (source != theseus && minotaur_turn(level, theseus, source, minotaur_steps, vertical_first) == minotaur)
+								sources[num_sources++] = source;
+						}
+					}
+					if (num_sources == 0) continue;
+
+					// Undo every sequence of moves Theseus can make in one turn
+					for(int code = 0; code < num_codes && ok; code++) {
+						int cell = theseus, path[MAX_THESEUS_STEPS];
+
+						for(int i = theseus_steps - 1; i >= 0 && cell >= 0; i--) {
+							int move = code;
+							for(int j = 0; j < i; j++)
+								move /= TURN_CODE_BASE;
+
+							path[i] = cell;
+							cell = theseus_unstep(level, cell, move % TURN_CODE_BASE);
+						}
+						if (cell < 0) continue;
+
+						for(int j = 0; j < num_sources && ok; j++) {
+							int source = sources[j];
+							bool crossed = (source == cell);
+
+							// Theseus can't have walked through the Minotaur's square
+							for(int i = 0; i < theseus_steps; i++)
+								if (path[i] == source) crossed = true;
+							if (crossed) continue;
+
+							int prev_state = (cell * num_cells) + source;
+							if (bcost[prev_state] != 0) continue;
+
+							bcost[prev_state] = bdepth + 2;
+							bnext[prev_state] = state;
+							bvia[prev_state] = code;
+							ok = list_push(&backward[1], prev_state);
+							sol->states++;
+
+							if (fcost[prev_state] > 0 && (meet < 0 || fcost[prev_state] + (bdepth + 1) < best)) {
+								meet = prev_state;
+								best = fcost[prev_state] + (bdepth + 1);
+							}
+						}
+					}
+				}
+
+				struct state_list swap = backward[0];
+				backward[0] = backward[1];
+				backward[1] = swap;
+				bdepth++;
+			}
+		}
+
+		// Join the path from the start to the meeting state with the path from it to the escape
+		if (ok && meet >= 0) {
+			int last = meet, last_code = 0;
+
+			while (bcost[last] > 1)
+				last = bnext[last];
+			int last_moves = find_escape(level, last / num_cells, last % num_cells, theseus_steps, &last_code);
+
+			sol->solvable = true;
+			ok = alloc_moves(sol, best, last_moves, theseus_steps);
+			if (ok) {
+				write_turn(sol, best - 1, last_code, last_moves, theseus_steps);
+				for(int s = meet, turn = fcost[meet] - 2; s != start; s = fparent[s], turn--)
+					write_turn(sol, turn, fvia[s], theseus_steps, theseus_steps);
+				for(int s = meet, turn = fcost[meet] - 1; bcost[s] > 1; s = bnext[s], turn++)
+					write_turn(sol, turn, bvia[s], theseus_steps, theseus_steps);
+			}
+		}
+	}
+
+	for(int i = 0; i < 2; i++) {
+		free(frontier[i][0].items);
+		free(frontier[i][1].items);
+	}
+	free(fcost);
+	free(fparent);
+	free(fvia);
+	free(bcost);
+	free(bnext);
+	free(bvia);
+	free(distance);
+
+	return ok;
+}
+
+// One specialized copy of the bidirectional search per rule variant
+#define DEFINE_BIDIRECTIONAL_SOLVER(NAME, MSTEPS, VFIRST, TSTEPS) \
+	static bool solve_bidirectional_##NAME(const struct engine_level *level, struct solution *sol) { \
+		return bidirectional_kernel(level, sol, MSTEPS, VFIRST, TSTEPS); \
+	}
+RULE_VARIANTS(DEFINE_BIDIRECTIONAL_SOLVER)
+
+// The specialized searches of each search method, indexed by rule variant
+typedef bool (*variant_solver)(const struct engine_level *, struct solution *);
+
+#define BFS_ENTRY(NAME, MSTEPS, VFIRST, TSTEPS) solve_##NAME,
+#define HASHED_ENTRY(NAME, MSTEPS, VFIRST, TSTEPS) solve_hashed_##NAME,
+#define ASTAR_ENTRY(NAME, MSTEPS, VFIRST, TSTEPS) solve_astar_##NAME,
+#define BIDIRECTIONAL_ENTRY(NAME, MSTEPS, VFIRST, TSTEPS) solve_bidirectional_##NAME,
+static const variant_solver bfs_solvers[NUM_RULE_VARIANTS] = {RULE_VARIANTS(BFS_ENTRY)};
+static const variant_solver hashed_solvers[NUM_RULE_VARIANTS] = {RULE_VARIANTS(HASHED_ENTRY)};
+static const variant_solver astar_solvers[NUM_RULE_VARIANTS] = {RULE_VARIANTS(ASTAR_ENTRY)};
+static const variant_solver bidirectional_solvers[NUM_RULE_VARIANTS] = {RULE_VARIANTS(BIDIRECTIONAL_ENTRY)};
+
+/**
+ * Find the shortest way for Theseus to escape a level (in turns). Every search method finds
+ * a shortest solution, but they visit different numbers of states:
+ *
+ *	SEARCH_BFS - A breadth-first search over every position of the characters that can
+ *		be reached. With one Minotaur, the visited states are kept as one bit each and
+ *		only the last two layers of the search are stored, so no parents are kept: the
+ *		moves are recovered by searching again between states found halfway (trading
+ *		time for memory). With more Minotaurs, the states no longer fit a dense table,
+ *		so each one is packed into a 64-bit key and kept in an open-addressing hash table.
+ *	SEARCH_ASTAR - An A* search guided by the number of turns Theseus needs to reach the
+ *		exit if the Minotaur is left out (from one breadth-first search from the exit).
+ *	SEARCH_BIDIRECTIONAL - A breadth-first search from both the start and the states
+ *		Theseus can escape from, meeting in the middle.
+ *
+ * A* and the bidirectional search need a level with one Minotaur; levels with more are
+ * always searched with the hashed breadth-first search. A copy of each search is compiled
+ * for every rule variant, and the one for the level's rules is picked once before searching.
+ *
+ * 'level' specifies the level to solve.
+ * 'method' specifies the search method.
+ * 'sol' receives the solution (free it with free_solution()).
+ *
+ * Return Values:
+ *	true - The level was searched ('sol->solvable' tells whether Theseus can escape).
+ *	false - Memory for the search could not be allocated, or the search was called off
+ *		through the level's cancel flag (see 'cancel' in engine_level).
+ */
+bool solve_level(const struct engine_level *level, search_method method, struct solution *sol) {
+	if (level->num_minotaurs > 1) return hashed_solvers[level->variant](level, sol);
+
+	switch (method) {
+		case SEARCH_ASTAR:
+			return astar_solvers[level->variant](level, sol);
+
+		case SEARCH_BIDIRECTIONAL:
+			return bidirectional_solvers[level->variant](level, sol);
+
+		default:
+			return bfs_solvers[level->variant](level, sol);
+	}
+}
+
+/**
+ * Free the memory held by a solution structure.
+ */
+void free_solution(struct solution *sol) {
+	free(sol->moves);
+	sol->moves = NULL;
+
+	return;
+}
+
+// Read a level file into an engine_level structure: returns 0, or the code of read_level_file() (2 if out of memory)
+static int load_level(const char *level_path, struct engine_level *level) {
+	struct stats board;
+
+	board.walls = NULL;
+	int result = read_level_file(level_path, &board);
+	if (result != 0) return result;
+
+	bool loaded = engine_load(level, &board);
+	free_walls(board.walls);
+
+	return loaded ? 0 : 2;
+}
+
+// Open the result cache if one was asked for: returns the cache, or NULL (with a message) if it couldn't be opened
+static struct result_cache *open_cache(const char *cache_path, struct result_cache *cache) {
+	if (cache_path == NULL) return NULL;
+	if (cache_open(cache, cache_path)) return cache;
+
+	fprintf(stderr, "theseus: %s: could not open the result cache (%s), solving without it\n", cache_path, strerror(errno));
+	return NULL;
+}
+
+/**
+ * Print the result line of a solved level (see run_solver() for the format).
+ *
+ * 'out' specifies the stream to print to.
+ * 'name' specifies the name of the level (its file path).
+ * 'sol' specifies the solution.
+ * 'cached' specifies whether the solution came from the result cache.
+ * 'elapsed' specifies the time taken to solve the level, in microseconds.
+ */
+void print_solution(FILE *out, const char *name, const struct solution *sol, bool cached, unsigned long long elapsed) {
+	double rate = (elapsed > 0) ? (sol->states * 1e6) / elapsed : 0;
+	size_t kilobytes = (sol->memory + 1023) / 1024;
+	char details[96];
+
+	if (cached) snprintf(details, sizeof(details), "cached");
+	else snprintf(details, sizeof(details), "%ld states, %zu KB, %.0f states/s", sol->states, kilobytes, rate);
+
+	if (sol->solvable) fprintf(out, "%s: solvable in %d turns: %s (%s)\n", name, sol->turns, sol->moves, details);
+	else fprintf(out, "%s: unsolvable (%s)\n", name, details);
+
+	return;
+}
+
+/**
+ * Solve a level file and print the result as one line to the standard output:
+ *
+ *	<file>: solvable in <turns> turns: <moves> (<states> states, <KB> KB, <rate> states/s)
+ *	<file>: unsolvable (<states> states, <KB> KB, <rate> states/s)
+ *
+ * where <KB> is the memory used by the search's tables and <rate> the states visited per
+ * second. A result found in the cache is printed with "(cached)" instead.
+ *
+ * 'level_path' specifies the file path of the level.
+ * 'method' specifies the search method (see solve_level()).
+ * 'cache_path' specifies the file path of the result cache (NULL for none).
+ *
+ * Return Values:
+ *	0 - The level was solved (whether Theseus can escape or not).
+ *	1 - The level could not be read or solved.
+ */
+int run_solver(const char *level_path, search_method method, const char *cache_path) {
+	struct engine_level level;
+	struct result_cache cache_storage;
+	struct solution sol;
+	bool cached;
+
+	int result = load_level(level_path, &level);
+	if (result != 0) {
+		fprintf(stderr, "theseus: %s: %s\n", level_path, (result == 1) ? "could not open level file" : "invalid level file");
+		return 1;
+	}
+
+	struct result_cache *cache = open_cache(cache_path, &cache_storage);
+	unsigned long long start_time = lat_now();
+	bool solved = cache_solve(cache, &level, method, &sol, &cached);
+	unsigned long long elapsed = lat_now() - start_time;
+
+	if (cache != NULL) cache_close(cache);
+	engine_free(&level);
+	if (!solved) {
+		fprintf(stderr, "theseus: %s: out of memory\n", level_path);
+		return 1;
+	}
+
+	print_solution(stdout, level_path, &sol, cached, elapsed);
+	free_solution(&sol);
+
+	return 0;
+}
+
+// Structure to hold the canonical key of one level of a pack (to find duplicates)
+struct pack_entry {
+	uint64_t key;
+	int index;		/* Position of the level in the list */
+	const char *path;	/* Points into the level list */
+};
+
+// Order pack entries by key, then by position in the list
+static int compare_pack_entries(const void *a, const void *b) {
+	const struct pack_entry *x = a, *y = b;
+
+	if (x->key != y->key) return (x->key < y->key) ? -1 : 1;
+	return x->index - y->index;
+}
+
+// Check whether two levels of a pack with the same canonical key are really the same level (up to symmetry)
+static bool same_pack_level(const struct pack_entry *x, const struct pack_entry *y, bool *failed) {
+	struct engine_level first, second;
+	bool same = false;
+
+	if (load_level(x->path, &first) != 0) {
+		*failed = true;
+		return false;
+	}
+	if (load_level(y->path, &second) == 0) {
+		same = cache_same_level(&first, &second);
+		engine_free(&second);
+	}
+	else *failed = true;
+	engine_free(&first);
+
+	return same;
+}
+
+/*
+ * Report the levels of a pack that are the same as an earlier level (up to symmetry): returns
+ * their number. Levels with equal keys are loaded again and compared, so that two different
+ * levels whose keys collide are not taken for each other ('failed' is set if one can't be loaded).
+ */
+static int report_duplicates(struct pack_entry *entries, int count, bool *failed) {
+	int num_duplicates = 0;
+
+	// Equal keys end up next to each other, the first level of the list leading
+	qsort(entries, count, sizeof(struct pack_entry), compare_pack_entries);
+	for(int i = 1, first = 0; i < count; i++) {
+		if (entries[i].key != entries[first].key) {
+			first = i;
+			continue;
+		}
+
+		for(int j = first; j < i; j++) {
+			if (same_pack_level(&entries[j], &entries[i], failed)) {
+				fprintf(stderr, "theseus: %s: same level as %s (up to symmetry)\n", entries[i].path, entries[j].path);
+				num_duplicates++;
+				break;
+			}
+		}
+	}
+
+	return num_duplicates;
+}
+
+/**
+ * Check every level of a pack (a level list like Levels/levellist.txt: one level file
+ * path per line). Each level must load and be solvable, and no level may be the same
+ * as another one, or a mirror image or a rotation of it (see cache_canonical_key()).
+ * Every problem is printed to the standard error, followed by one summary line on the
+ * standard output:
+ *
+ *	<list>: <levels> levels, <solvable> solvable, <unsolvable> unsolvable, <invalid> invalid, <duplicates> duplicates (<cached> cached)
+ *
+ * 'list_path' specifies the file path of the level list.
+ * 'method' specifies the search method (see solve_level()).
+ * 'cache_path' specifies the file path of the result cache (NULL for none).
+ *
+ * Return Values:
+ *	0 - Every level of the pack is valid, solvable and different from the others.
+ *	1 - The list could not be read, or a level is invalid, unsolvable or a duplicate.
+ */
+int run_verify_pack(const char *list_path, search_method method, const char *cache_path) {
+	struct level_list list;
+	if (read_level_list(list_path, &list) != 0) {
+		fprintf(stderr, "theseus: %s: could not read level list\n", list_path);
+		return 1;
+	}
+
+	struct result_cache cache_storage;
+	struct result_cache *cache = open_cache(cache_path, &cache_storage);
+	int num_levels = 0, num_solvable = 0, num_unsolvable = 0, num_invalid = 0, num_cached = 0;
+	struct pack_entry *entries = malloc(sizeof(struct pack_entry) * (list.num_levels + 1));
+	int num_entries = 0;
+	bool out_of_memory = (entries == NULL);
+
+	for(int k = 0; k < list.num_levels && !out_of_memory; k++) {
+		const char *path = list.paths[k];
+		struct engine_level level;
+		struct solution sol;
+		bool cached;
+
+		num_levels++;
+		int result = load_level(path, &level);
+		if (result != 0) {
+			fprintf(stderr, "theseus: %s: %s\n", path, (result == 1) ? "could not open level file" : "invalid level file");
+			num_invalid++;
+			continue;
+		}
+
+		// Keep the level's canonical key, to look for mirror images and rotations of it
+		entries[num_entries].key = cache_canonical_key(&level);
+		entries[num_entries].index = num_levels;
+		entries[num_entries].path = path;
+		if (entries[num_entries].key == 0) {
+			fprintf(stderr, "theseus: %s: out of memory\n", path);
+			engine_free(&level);
+			out_of_memory = true;
+			break;
+		}
+		num_entries++;
+
+		bool solved = cache_solve(cache, &level, method, &sol, &cached);
+		engine_free(&level);
+		if (!solved) {
+			fprintf(stderr, "theseus: %s: out of memory\n", path);
+			out_of_memory = true;
+			break;
+		}
+
+		num_cached += cached;
+		if (sol.solvable) num_solvable++;
+		else {
+			fprintf(stderr, "theseus: %s: unsolvable\n", path);
+			num_unsolvable++;
+		}
+		free_solution(&sol);
+	}
+	if (cache != NULL) cache_close(cache);
+
+	bool reload_failed = false;
+	int num_duplicates = report_duplicates(entries, num_entries, &reload_failed);
+	if (reload_failed) fprintf(stderr, "theseus: %s: a level could not be read again to compare it\n", list_path);
+	free(entries);
+	free_level_list(&list);
+
+	printf("%s: %d levels, %d solvable, %d unsolvable, %d invalid, %d duplicates (%d cached)\n",
+	       list_path, num_levels, num_solvable, num_unsolvable, num_invalid, num_duplicates, num_cached);
+
+	return (num_solvable == num_levels && num_duplicates == 0 && !out_of_memory && !reload_failed) ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#ifndef _SOLVER_H
+#define _SOLVER_H
+
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "loader.h"
+
+// Enumerated values representing the search methods of the solver
+typedef enum {
+	SEARCH_BFS,		/* Breadth-first search */
+	SEARCH_ASTAR,		/* A* search toward the exit */
+	SEARCH_BIDIRECTIONAL	/* Breadth-first search from both ends */
+}
+search_method;
+
+// Structure to hold the result of solving a level
+struct solution {
+	bool solvable;
+	int turns;		/* Turns needed to escape (the last one may be cut short by the escape) */
+	char *moves;		/* Theseus' moves as a string of L, R, U, D and S (skip), NULL if unsolvable */
+	long states;		/* Number of states visited by the search */
+	long expanded;		/* Number of states whose successors were generated */
+	size_t memory;		/* Bytes used by the search's tables */
+};
+
+/**
+ * Find the shortest way for Theseus to escape a level (in turns). Every search method finds
+ * a shortest solution, but they visit different numbers of states:
+ *
+ *	SEARCH_BFS - A breadth-first search over every position of the characters that can
+ *		be reached. With one Minotaur, the visited states are kept as one bit each and
+ *		only the last two layers of the search are stored, so no parents are kept: the
+ *		moves are recovered by searching again between states found halfway (trading
+ *		time for memory). With more Minotaurs, the states no longer fit a dense table,
+ *		so each one is packed into a 64-bit key and kept in an open-addressing hash table.
+ *	SEARCH_ASTAR - An A* search guided by the number of turns Theseus needs to reach the
+ *		exit if the Minotaur is left out (from one breadth-first search from the exit).
+ *	SEARCH_BIDIRECTIONAL - A breadth-first search from both the start and the states
+ *		Theseus can escape from, meeting in the middle.
+ *
+ * A* and the bidirectional search need a level with one Minotaur; levels with more are
+ * always searched with the hashed breadth-first search. A copy of each search is compiled
+ * for every rule variant, and the one for the level's rules is picked once before searching.
+ *
+ * 'level' specifies the level to solve.
+ * 'method' specifies the search method.
+ * 'sol' receives the solution (free it with free_solution()).
+ *
+ * Return Values:
+ *	true - The level was searched ('sol->solvable' tells whether Theseus can escape).
+ *	false - Memory for the search could not be allocated, or the search was called off
+ *		through the level's cancel flag (see 'cancel' in engine_level).
+ */
+bool solve_level(const struct engine_level *level, search_method method, struct solution *sol);
+
+/**
+ * Free the memory held by a solution structure.
+ */
+void free_solution(struct solution *sol);
+
+/**
+ * Compute the number of moves Theseus needs to escape from every cell, ignoring the Minotaur,
+ * with one breadth-first search from the exit over the move masks (-1 for cells he can't
+ * escape from). Moves are symmetric apart from the exit, so searching out from the exit gives
+ * the distances to it.
+ *
+ * 'level' specifies the level.
+ * 'distance' receives the moves for each cell (counting the move through the exit).
+ *
+ * Return Values:
+ *	true - The distances were computed.
+ *	false - Memory for the search could not be allocated.
+ */
+bool compute_exit_distances(const struct engine_level *level, int *distance);
+
+/**
+ * Print the result line of a solved level (see run_solver() for the format).
+ *
+ * 'out' specifies the stream to print to.
+ * 'name' specifies the name of the level (its file path).
+ * 'sol' specifies the solution.
+ * 'cached' specifies whether the solution came from the result cache.
+ * 'elapsed' specifies the time taken to solve the level, in microseconds.
+ */
+void print_solution(FILE *out, const char *name, const struct solution *sol, bool cached, unsigned long long elapsed);
+
+/**
+ * Solve a level file and print the result as one line to the standard output:
+ *
+ *	<file>: solvable in <turns> turns: <moves> (<states> states, <KB> KB, <rate> states/s)
+ *	<file>: unsolvable (<states> states, <KB> KB, <rate> states/s)
+ *
+ * where <KB> is the memory used by the search's tables and <rate> the states visited per
+ * second. A result found in the cache is printed with "(cached)" instead.
+ *
+ * 'level_path' specifies the file path of the level.
+ * 'method' specifies the search method (see solve_level()).
+ * 'cache_path' specifies the file path of the result cache (NULL for none).
+ *
+ * Return Values:
+ *	0 - The level was solved (whether Theseus can escape or not).
+ *	1 - The level could not be read or solved.
+ */
+int run_solver(const char *level_path, search_method method, const char *cache_path);
+
+/**
+ * Check every level of a pack (a level list like Levels/levellist.txt: one level file
+ * path per line). Each level must load and be solvable, and no level may be the same
+ * as another one, or a mirror image or a rotation of it (see cache_canonical_key()).
+ * Every problem is printed to the standard error, followed by one summary line on the
+ * standard output:
+ *
+ *	<list>: <levels> levels, <solvable> solvable, <unsolvable> unsolvable, <invalid> invalid, <duplicates> duplicates (<cached> cached)
+ *
+ * 'list_path' specifies the file path of the level list.
+ * 'method' specifies the search method (see solve_level()).
+ * 'cache_path' specifies the file path of the result cache (NULL for none).
+ *
+ * Return Values:
+ *	0 - Every level of the pack is valid, solvable and different from the others.
+ *	1 - The list could not be read, or a level is invalid, unsolvable or a duplicate.
+ */
+int run_verify_pack(const char *list_path, search_method method, const char *cache_path);
+
+#endif	    // _SOLVER_H
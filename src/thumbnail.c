@@ -0,0 +1,243 @@
+#include "thumbnail.h"
+#include "levelpack.h"
+
+/**
+ * Render the mini-map of a level: every square is one character, inside a border of '+',
+ * '-' and '|'. A square with a wall on its right side is drawn as '|', and a square with a
+ * wall on its lower side is underlined. Theseus' start is 'T', the Minotaurs' starts are
+ * 'M' and the exit is a '*' in the border.
+ *
+ * 'level' specifies the level.
+ * 'thumb' receives the mini-map.
+ */
+void render_thumbnail(const struct engine_level *level, struct thumbnail *thumb) {
+	int rows = level->num_rows, cols = level->num_cols;
+
+	thumb->height = rows + 2;
+	thumb->width = cols + 2;
+
+	// Border
+	for(int x = 0; x < thumb->width; x++)
+		thumb->cells[0][x] = thumb->cells[rows + 1][x] = (x == 0 || x == cols + 1) ? '+' : '-';
+	for(int y = 1; y <= rows; y++)
+		thumb->cells[y][0] = thumb->cells[y][cols + 1] = '|';
+
+	// Squares, with their right and lower walls (the walls on the other sides belong to the neighbors)
+	for(int cell = 0; cell < level->num_cells; cell++) {
+		int row = cell / cols, col = cell % cols;
+		chtype square = ((col < cols - 1) && !(level->masks[cell] & moves[RIGHT])) ? '|' : '.';
+
+		if ((row < rows - 1) && !(level->masks[cell] & moves[DOWN])) square |= A_UNDERLINE;
+		thumb->cells[row + 1][col + 1] = square;
+	}
+
+	// Starting positions and the exit
+	for(int i = 0; i < level->num_minotaurs; i++) {
+		int cell = level->minotaur_starts[i];
+		thumb->cells[(cell / cols) + 1][(cell % cols) + 1] = 'M' | A_BOLD;
+	}
+	thumb->cells[(level->theseus_start / cols) + 1][(level->theseus_start % cols) + 1] = 'T' | A_BOLD;
+
+	int exit_y = (level->exit_cell / cols) + 1, exit_x = (level->exit_cell % cols) + 1;
+	switch (level->exit_dir) {
+		case LEFT:
+			exit_x = 0;
+			break;
+
+		case RIGHT:
+			exit_x = cols + 1;
+			break;
+
+		case UP:
+			exit_y = 0;
+			break;
+
+		case DOWN:
+			exit_y = rows + 1;
+			break;
+	}
+	thumb->cells[exit_y][exit_x] = '*' | A_BOLD;
+
+	return;
+}
+
+// Read a level file (or a level of the compiled-in pack) and render its mini-map: returns false if the file could not be read
+static bool load_thumbnail(const char *level_path, struct thumbnail *thumb) {
+	struct engine_level level;
+
+	if (!load_level_engine(&level, level_path)) return false;
+
+	render_thumbnail(&level, thumb);
+	engine_free(&level);
+
+	return true;
+}
+
+// Find the slot holding a level's mini-map (NULL if there is none), with the cache locked
+static struct thumb_slot *find_slot(struct thumb_cache *cache, int level) {
+	for(int i = 0; i < THUMB_SLOTS; i++)
+		if (cache->slots[i].level == level) return &cache->slots[i];
+
+	return NULL;
+}
+
+// Pick the slot to render a mini-map into: a free one, else the least recently used one that isn't wanted or being rendered
+static struct thumb_slot *claim_slot(struct thumb_cache *cache) {
+	struct thumb_slot *oldest = NULL;
+
+	for(int i = 0; i < THUMB_SLOTS; i++) {
+		struct thumb_slot *slot = &cache->slots[i];
+		bool wanted = false;
+
+		if (slot->level < 0) return slot;
+		if (slot->state == THUMB_PENDING) continue;
+
+		for(int w = 0; w < cache->num_wanted && !wanted; w++)
+			wanted = (cache->wanted[w] == slot->level);
+		if (!wanted && (oldest == NULL || slot->last_used < oldest->last_used)) oldest = slot;
+	}
+
+	return oldest;
+}
+
+// Render the mini-maps of the wanted levels (most wanted first) until the cache is stopped
+static void *thumb_worker(void *arg) {
+	struct thumb_cache *cache = arg;
+
+	pthread_mutex_lock(&cache->lock);
+	while (!cache->stopping) {
+		struct thumb_slot *slot = NULL;
+		int level = -1;
+
+		for(int w = 0; w < cache->num_wanted && level < 0; w++)
+			if (find_slot(cache, cache->wanted[w]) == NULL) level = cache->wanted[w];
+		if (level >= 0) slot = claim_slot(cache);
+
+		if (slot == NULL) {
+			pthread_cond_wait(&cache->wake, &cache->lock);
+			continue;
+		}
+
+		// Read and render the level without holding the lock (a pending slot is never replaced)
+		slot->level = level;
+		slot->state = THUMB_PENDING;
+		slot->last_used = ++cache->tick;
+		pthread_mutex_unlock(&cache->lock);
+
+		struct thumbnail thumb;
+		bool loaded = load_thumbnail(cache->level_list[level], &thumb);
+
+		pthread_mutex_lock(&cache->lock);
+		if (loaded) slot->thumb = thumb;
+		slot->state = loaded ? THUMB_READY : THUMB_FAILED;
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	return NULL;
+}
+
+/**
+ * Start the worker threads that render the mini-maps of a level list. The workers parse
+ * the level files and render the mini-maps of the wanted levels (see thumb_want()), so
+ * the calling thread never reads a level file.
+ *
+ * 'cache' specifies the mini-map cache to set up.
+ * 'level_list' specifies the level file paths (must stay valid until thumb_stop()).
+ * 'num_levels' is the number of level file paths in 'level_list'.
+ *
+ * Return Values:
+ *	true - The cache was set up (even if no worker could be started).
+ *	false - The cache's lock could not be set up.
+ */
+bool thumb_start(struct thumb_cache *cache, char **level_list, int num_levels) {
+	cache->level_list = level_list;
+	cache->num_levels = num_levels;
+	cache->tick = 0;
+	cache->num_wanted = 0;
+	cache->num_workers = 0;
+	cache->stopping = false;
+	for(int i = 0; i < THUMB_SLOTS; i++) {
+		cache->slots[i].level = -1;
+		cache->slots[i].state = THUMB_MISSING;
+	}
+
+	if (pthread_mutex_init(&cache->lock, NULL) != 0) return false;
+	if (pthread_cond_init(&cache->wake, NULL) != 0) {
+		pthread_mutex_destroy(&cache->lock);
+		return false;
+	}
+
+	while (cache->num_workers < THUMB_WORKERS && pthread_create(&cache->workers[cache->num_workers], NULL, thumb_worker, cache) == 0)
+		cache->num_workers++;
+
+	return true;
+}
+
+/**
+ * Stop the worker threads of a mini-map cache and wait for them to finish.
+ */
+void thumb_stop(struct thumb_cache *cache) {
+	pthread_mutex_lock(&cache->lock);
+	cache->stopping = true;
+	pthread_cond_broadcast(&cache->wake);
+	pthread_mutex_unlock(&cache->lock);
+
+	for(int i = 0; i < cache->num_workers; i++)
+		pthread_join(cache->workers[i], NULL);
+
+	pthread_cond_destroy(&cache->wake);
+	pthread_mutex_destroy(&cache->lock);
+	cache->num_workers = 0;
+
+	return;
+}
+
+/**
+ * Tell the workers which mini-maps to render next, replacing the levels asked for before.
+ * Levels that already have a mini-map are kept from being replaced.
+ *
+ * 'cache' specifies the mini-map cache.
+ * 'levels' specifies the indexes of the levels, most wanted first.
+ * 'count' is the number of indexes in 'levels' (only the first THUMB_WANTED are used).
+ */
+void thumb_want(struct thumb_cache *cache, const int *levels, int count) {
+	if (count > THUMB_WANTED) count = THUMB_WANTED;
+
+	pthread_mutex_lock(&cache->lock);
+	cache->num_wanted = 0;
+	for(int i = 0; i < count; i++) {
+		if (levels[i] < 0 || levels[i] >= cache->num_levels) continue;
+
+		struct thumb_slot *slot = find_slot(cache, levels[i]);
+		if (slot != NULL) slot->last_used = ++cache->tick;
+		cache->wanted[cache->num_wanted++] = levels[i];
+	}
+	pthread_cond_broadcast(&cache->wake);
+	pthread_mutex_unlock(&cache->lock);
+
+	return;
+}
+
+/**
+ * Get the mini-map of a level if it has been rendered. This never reads the level file.
+ *
+ * 'cache' specifies the mini-map cache.
+ * 'level' specifies the index of the level.
+ * 'thumb' receives a copy of the mini-map if it is ready.
+ *
+ * Return Value:
+ *	The function returns the state of the level's mini-map.
+ */
+thumb_state thumb_get(struct thumb_cache *cache, int level, struct thumbnail *thumb) {
+	thumb_state state = THUMB_MISSING;
+
+	pthread_mutex_lock(&cache->lock);
+	struct thumb_slot *slot = find_slot(cache, level);
+	if (slot != NULL) {
+		state = slot->state;
+		if (state == THUMB_READY) *thumb = slot->thumb;
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	return state;
+}
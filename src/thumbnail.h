@@ -0,0 +1,115 @@
+#ifndef _THUMBNAIL_H
+#define _THUMBNAIL_H
+
+#include <ncurses.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "loader.h"
+
+#define THUMB_HEIGHT (MAX_BOARD_Y + 2)	/* Rows of a mini-map (the largest board and its border) */
+#define THUMB_WIDTH (MAX_BOARD_X + 2)	/* Columns of a mini-map */
+#define THUMB_SLOTS 128			/* Mini-maps kept rendered (least recently used ones are replaced) */
+#define THUMB_WANTED 16			/* Most levels asked for at once */
+#define THUMB_WORKERS 2			/* Threads rendering mini-maps */
+
+// Enumerated values representing the state of a level's mini-map
+typedef enum {
+	THUMB_MISSING,		/* Not rendered yet (or replaced since) */
+	THUMB_PENDING,		/* Being rendered by a worker */
+	THUMB_READY,
+	THUMB_FAILED		/* The level file could not be read */
+}
+thumb_state;
+
+// Structure to hold the mini-map of a level: one character per square, inside a border
+struct thumbnail {
+	short height;			/* Rows used (the board's rows and the border) */
+	short width;			/* Columns used */
+	chtype cells[THUMB_HEIGHT][THUMB_WIDTH];
+};
+
+// Structure to hold one slot of the mini-map cache
+struct thumb_slot {
+	int level;			/* Index of the level in the list (-1 if the slot is free) */
+	thumb_state state;
+	unsigned long last_used;	/* Tick of the last time the slot was asked for */
+	struct thumbnail thumb;
+};
+
+// Structure to hold the mini-maps of a level list, rendered ahead of time by worker threads
+struct thumb_cache {
+	char **level_list;
+	int num_levels;
+
+	pthread_mutex_t lock;
+	pthread_cond_t wake;		/* Signalled when the wanted levels change or the workers stop */
+	struct thumb_slot slots[THUMB_SLOTS];
+	unsigned long tick;
+
+	int wanted[THUMB_WANTED];	/* Levels to render, most wanted first */
+	int num_wanted;
+
+	pthread_t workers[THUMB_WORKERS];
+	int num_workers;
+	bool stopping;
+};
+
+/**
+ * Render the mini-map of a level: every square is one character, inside a border of '+',
+ * '-' and '|'. A square with a wall on its right side is drawn as '|', and a square with a
+ * wall on its lower side is underlined. Theseus' start is 'T', the Minotaurs' starts are
+ * 'M' and the exit is a '*' in the border.
+ *
+ * 'level' specifies the level.
+ * 'thumb' receives the mini-map.
+ */
+void render_thumbnail(const struct engine_level *level, struct thumbnail *thumb);
+
+/**
+ * Start the worker threads that render the mini-maps of a level list. The workers parse
+ * the level files and render the mini-maps of the wanted levels (see thumb_want()), so
+ * the calling thread never reads a level file.
+ *
+ * 'cache' specifies the mini-map cache to set up.
+ * 'level_list' specifies the level file paths (must stay valid until thumb_stop()).
+ * 'num_levels' is the number of level file paths in 'level_list'.
+ *
+ * Return Values:
+ *	true - The cache was set up (even if no worker could be started).
+ *	false - The cache's lock could not be set up.
+ */
+bool thumb_start(struct thumb_cache *cache, char **level_list, int num_levels);
+
+/**
+ * Stop the worker threads of a mini-map cache and wait for them to finish.
+ */
+void thumb_stop(struct thumb_cache *cache);
+
+/**
+ * Tell the workers which mini-maps to render next, replacing the levels asked for before.
+ * Levels that already have a mini-map are kept from being replaced.
+ *
+ * 'cache' specifies the mini-map cache.
+ * 'levels' specifies the indexes of the levels, most wanted first.
+ * 'count' is the number of indexes in 'levels' (only the first THUMB_WANTED are used).
+ */
+void thumb_want(struct thumb_cache *cache, const int *levels, int count);
+
+/**
+ * Get the mini-map of a level if it has been rendered. This never reads the level file.
+ *
+ * 'cache' specifies the mini-map cache.
+ * 'level' specifies the index of the level.
+ * 'thumb' receives a copy of the mini-map if it is ready.
+ *
+ * Return Value:
+ *	The function returns the state of the level's mini-map.
+ */
+thumb_state thumb_get(struct thumb_cache *cache, int level, struct thumbnail *thumb);
+
+#endif	    // _THUMBNAIL_H
@@ -47,9 +47,11 @@ int show_menu(int height, int width, const char *title, int size_array, char **o
 	}
 	va_end(extra_items);
 	wrefresh(menu);
+	lat_startup_phase("first menu painted", true);
 
 	// Allow user to select any of the options from the menu
 	while ((key = getch()) != '\n') {
+		lat_mark();
 		
 		switch (key) {
 			case KEY_UP:
@@ -58,6 +60,7 @@ int show_menu(int height, int width, const char *title, int size_array, char **o
 
 				mvwchgat(menu, cur_choice + 3, PADDING_LEFT, strlen(item_options[cur_choice]), A_REVERSE, 0, NULL);
 				wrefresh(menu);
+				lat_record(LAT_MENU);
 				break;
 
 			case KEY_DOWN:
@@ -66,6 +69,7 @@ int show_menu(int height, int width, const char *title, int size_array, char **o
 
 				mvwchgat(menu, cur_choice + 3, PADDING_LEFT, strlen(item_options[cur_choice]), A_REVERSE, 0, NULL);
 				wrefresh(menu);
+				lat_record(LAT_MENU);
 				break;
 		}
 	}
@@ -75,6 +79,400 @@ int show_menu(int height, int width, const char *title, int size_array, char **o
 	return cur_choice;
 }
 
+// Orders in which the level menu lists the levels, and the filters it applies
+static const char *level_orders[] = {"Sort: list order", "Sort: easiest first", "Sort: hardest first"};
+static const char *level_filters[] = {"Show: all levels", "Show: easy levels", "Show: medium levels", "Show: hard levels"};
+
+static int level_order = 0, level_filter = 0;
+
+// Views of the level list the level menu pages through (built once for a list, when first needed)
+static struct level_views views;
+
+// Mini-maps of the levels of the list, rendered by worker threads ahead of the cursor
+static struct thumb_cache thumbs;
+static bool thumbs_started = false;
+
+static const struct catalog_entry **sort_entries;	/* Catalog entry of each level, while sorting */
+static const char **sort_names;				/* File name of each level, while sorting */
+static int sort_order;					/* Order the levels are sorted in */
+
+// Order levels by difficulty (unsolvable levels last), then by position in the list
+static int compare_difficulty(const void *a, const void *b) {
+	int x = *(const int *)a, y = *(const int *)b;
+	double dx = (sort_entries[x] != NULL) ? sort_entries[x]->metrics.difficulty : -1;
+	double dy = (sort_entries[y] != NULL) ? sort_entries[y]->metrics.difficulty : -1;
+
+	if (dx != dy) {
+		if (dx < 0 || dy < 0) return (dx < 0) ? 1 : -1;
+		return ((dx < dy) == (sort_order == 1)) ? -1 : 1;
+	}
+
+	return x - y;
+}
+
+// Order levels by file name, then by position in the list
+static int compare_names(const void *a, const void *b) {
+	int x = *(const int *)a, y = *(const int *)b;
+	int order = strcmp(sort_names[x], sort_names[y]);
+
+	return (order != 0) ? order : x - y;
+}
+
+// Order catalog entries by level file path
+static int compare_paths(const void *a, const void *b) {
+	return strcmp((*(const struct catalog_entry * const *)a)->path, (*(const struct catalog_entry * const *)b)->path);
+}
+
+// Find the band of difficulty (1 easy, 2 medium, 3 hard) of a level, 0 if it isn't known or it's unsolvable
+static int difficulty_band(const struct catalog_entry *entry) {
+	if (entry == NULL || !entry->metrics.solvable) return 0;
+	if (entry->metrics.difficulty < EASY_DIFFICULTY) return 1;
+
+	return (entry->metrics.difficulty < HARD_DIFFICULTY) ? 2 : 3;
+}
+
+// Index a level list for the level menu: each level's file name and catalog entry
+static bool index_levels(char **level_list, int num_levels, const struct catalog_entry *catalog, int catalog_size) {
+	free_level_menu();
+
+	views.level_list = level_list;
+	views.num_levels = num_levels;
+	views.catalog = catalog;
+	views.names = malloc(sizeof(char *) * (num_levels + 1));
+	views.entries = calloc(num_levels + 1, sizeof(struct catalog_entry *));
+	if (views.names == NULL || views.entries == NULL) return false;
+
+	for(int i = 0; i < num_levels; i++) {
+		const char *name = strrchr(level_list[i], '/');
+		views.names[i] = (name != NULL) ? name + 1 : level_list[i];
+	}
+
+	// Match the levels with the catalog by binary search over its entries sorted by path
+	if (catalog != NULL && catalog_size > 0) {
+		const struct catalog_entry **by_path = malloc(sizeof(struct catalog_entry *) * catalog_size);
+		if (by_path == NULL) return false;
+
+		for(int c = 0; c < catalog_size; c++)
+			by_path[c] = &catalog[c];
+		qsort(by_path, catalog_size, sizeof(struct catalog_entry *), compare_paths);
+
+		for(int i = 0; i < num_levels; i++) {
+			int low = 0, high = catalog_size;
+
+			while (low < high) {
+				int mid = low + (high - low) / 2;
+
+				if (strcmp(by_path[mid]->path, level_list[i]) < 0) low = mid + 1;
+				else high = mid;
+			}
+			if (low < catalog_size && strcmp(by_path[low]->path, level_list[i]) == 0) views.entries[i] = by_path[low];
+		}
+		free(by_path);
+	}
+	thumbs_started = thumb_start(&thumbs, level_list, num_levels);
+
+	return true;
+}
+
+// Get the levels passing a filter in one order (or by name if 'order' is LEVEL_ORDERS), building the view if needed
+static int *level_view(int order, int filter, int *size) {
+	int **view = (order < LEVEL_ORDERS) ? &views.by_order[order][filter] : &views.by_name[filter];
+	int *view_size = (order < LEVEL_ORDERS) ? &views.order_sizes[order][filter] : &views.name_sizes[filter];
+
+	if (*view == NULL) {
+		int *levels = malloc(sizeof(int) * (views.num_levels + 1));
+		int count = 0;
+
+		if (levels == NULL) {
+			*size = 0;
+			return NULL;
+		}
+		for(int i = 0; i < views.num_levels; i++)
+			if (filter == 0 || difficulty_band(views.entries[i]) == filter) levels[count++] = i;
+
+		sort_entries = views.entries;
+		sort_names = views.names;
+		sort_order = order;
+		if (order == LEVEL_ORDERS) qsort(levels, count, sizeof(int), compare_names);
+		else if (order != 0) qsort(levels, count, sizeof(int), compare_difficulty);
+
+		*view = levels;
+		*view_size = count;
+	}
+	*size = *view_size;
+
+	return *view;
+}
+
+// Find the first level of a view sorted by name whose name comes after 'prefix' (or starts with it, if 'inclusive')
+static int find_prefix(const int *levels, int count, const char *prefix, bool inclusive) {
+	size_t length = strlen(prefix);
+	int low = 0, high = count;
+
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+		int order = strncmp(views.names[levels[mid]], prefix, length);
+
+		if (order < 0 || (order == 0 && !inclusive)) low = mid + 1;
+		else high = mid;
+	}
+
+	return low;
+}
+
+// Write the menu label of a level
+static void level_label(int level, char *label, size_t size) {
+	static const char *band_names[] = {"unsolvable", "easy", "medium", "hard"};
+	const struct catalog_entry *entry = views.entries[level];
+	const char *name = views.names[level];
+
+	if (views.catalog == NULL) snprintf(label, size, "%s", views.level_list[level]);
+	else if (entry == NULL) snprintf(label, size, "%-*.*s", LEVEL_NAME_LENGTH, LEVEL_NAME_LENGTH, name);
+	else if (!entry->metrics.solvable) snprintf(label, size, "%-*.*s %9s  unsolvable", LEVEL_NAME_LENGTH, LEVEL_NAME_LENGTH, name, "");
+	else snprintf(label, size, "%-*.*s %3d turns  %s", LEVEL_NAME_LENGTH, LEVEL_NAME_LENGTH, name,
+		      entry->metrics.turns, band_names[difficulty_band(entry)]);
+}
+
+// Ask for the mini-maps of the chosen level and of the levels around it in the view, and draw the chosen one's
+static thumb_state draw_minimap(WINDOW *menu, int start_x, int rows, const int *levels, int count, int choice) {
+	struct thumbnail thumb;
+	thumb_state state = THUMB_MISSING;
+	int wanted[THUMB_WANTED], num_wanted = 0;
+
+	// The levels after the chosen one come first, since that's the way lists are mostly scrolled
+	if (choice < count) {
+		for(int i = choice; i < count && num_wanted < THUMB_WANTED - THUMB_BEHIND; i++)
+			wanted[num_wanted++] = levels[i];
+		for(int i = choice - 1; i >= 0 && num_wanted < THUMB_WANTED; i--)
+			wanted[num_wanted++] = levels[i];
+		thumb_want(&thumbs, wanted, num_wanted);
+
+		state = thumb_get(&thumbs, levels[choice], &thumb);
+	}
+
+	if (rows > THUMB_HEIGHT) rows = THUMB_HEIGHT;
+	for(int y = 0; y < rows; y++) {
+		mvwprintw(menu, y + 3, start_x, "%*s", THUMB_WIDTH, "");
+		if (state == THUMB_READY && y < thumb.height)
+			mvwaddchnstr(menu, y + 3, start_x, thumb.cells[y], thumb.width);
+	}
+	if (state == THUMB_FAILED) mvwprintw(menu, 3, start_x, "(unreadable level)");
+	else if (choice < count && state != THUMB_READY) mvwprintw(menu, 3, start_x, "(loading)");
+
+	return state;
+}
+
+// Draw one line of the level menu (an item, highlighted if chosen, padded to the width of the menu)
+static void draw_menu_line(WINDOW *menu, int row, const char *text, bool chosen) {
+	int length = strlen(text);
+	if (length > MAX_OPT_LENGTH) length = MAX_OPT_LENGTH;
+
+	if (chosen) wattron(menu, A_REVERSE);
+	mvwprintw(menu, row, PADDING_LEFT, "%.*s", length, text);
+	if (chosen) wattroff(menu, A_REVERSE);
+	wprintw(menu, "%*s", MAX_OPT_LENGTH - length, "");
+}
+
+/**
+ * Show the "Choose Level File" menu for the levels of a level list. The menu only draws
+ * the page of levels that fits on the screen, so it works the same for lists of any size.
+ * Typing filters the levels down to the ones whose file name starts with the typed text
+ * (listed by name, and found with a binary search, so a key press costs the same however
+ * many levels there are); backspace takes the last character back. Page Up, Page Down,
+ * Home and End move a page or to either end of the list. If the screen is wide enough,
+ * the mini-map of the chosen level (see render_thumbnail()) is shown next to the list.
+ * The mini-maps are rendered by worker threads for the levels around the cursor, so level
+ * files are never read while the menu waits for keys.
+ *
+ * If the list has a catalog (see run_catalog()), every level is shown with its optimal
+ * number of turns and its difficulty, and two extra menu items sort the levels (in list
+ * order, easiest first or hardest first) and filter them (all, easy, medium or hard
+ * levels). The order and the filter are kept for the next time the menu is shown. The
+ * views of the list are built the first time they are needed, and kept until
+ * free_level_menu() is called.
+ *
+ * 'level_list' specifies the level file paths, in list order.
+ * 'num_levels' is the number of level file paths in 'level_list'.
+ * 'catalog' specifies the catalog entries of the list (NULL if there is no catalog).
+ * 'catalog_size' is the number of entries in 'catalog'.
+ *
+ * Return Value:
+ *	The function returns the index of the chosen level in 'level_list', or
+ *	'num_levels' if the user chose to go back.
+ */
+int show_level_menu(char **level_list, int num_levels, const struct catalog_entry *catalog, int catalog_size) {
+	const char *title = "Choose Level File";
+	int num_extra = (catalog != NULL) ? 3 : 1;
+	char prefix[MAX_OPT_LENGTH + 1] = "";
+	char label[MAX_OPT_LENGTH + 1];
+	size_t prefix_length = 0;
+
+	if ((views.level_list != level_list || views.num_levels != num_levels || views.catalog != catalog || views.names == NULL)
+	    && !index_levels(level_list, num_levels, catalog, catalog_size)) {
+		free_level_menu();
+		return num_levels;
+	}
+	if (catalog == NULL) level_order = level_filter = 0;
+
+	// Size the menu to the screen: the levels that don't fit are scrolled through a page at a time
+	int page = LINES - num_extra - MIN_HEIGHT - 2;
+	if (page > num_levels) page = num_levels;
+	if (page < 1) page = 1;
+
+	int height = page + num_extra + MIN_HEIGHT, width = MAX_OPT_LENGTH + (2 * PADDING_LEFT);
+	int choice = 0, top = 0, key = 0;
+
+	// Make room for the chosen level's mini-map on the right if the screen is wide enough
+	int map_x = PADDING_LEFT + MAX_OPT_LENGTH + 1;
+	bool show_map = thumbs_started && (map_x + THUMB_WIDTH + 2 <= COLS);
+	if (show_map) width = map_x + THUMB_WIDTH + 2;
+
+	refresh();
+	WINDOW *menu = newwin(height, width, (LINES - height) / 2, (COLS - width) / 2);
+	keypad(menu, TRUE);
+	box(menu, 0, 0);
+	mvwprintw(menu, 1, (width - strlen(title)) / 2, "%s", title);
+
+	while (true) {
+		int count, first = 0;
+		const int *levels;
+
+		// Find the levels shown: a range of the view by name when searching, else the whole view
+		if (prefix_length > 0) {
+			levels = level_view(LEVEL_ORDERS, level_filter, &count);
+			first = find_prefix(levels, count, prefix, true);
+			count = find_prefix(levels, count, prefix, false) - first;
+		}
+		else levels = level_view(level_order, level_filter, &count);
+		if (levels == NULL) count = 0;
+
+		// Keep the chosen item on the page
+		if (choice > count + num_extra - 1) choice = count + num_extra - 1;
+		if (choice < count) {
+			if (choice < top) top = choice;
+			if (choice >= top + page) top = choice - page + 1;
+		}
+		if (top > count - page) top = count - page;
+		if (top < 0) top = 0;
+
+		// Draw the search line, the page of levels and the extra items
+		if (prefix_length > 0) snprintf(label, sizeof(label), "Search: %s_", prefix);
+		else snprintf(label, sizeof(label), "Type to search");
+		mvwprintw(menu, 2, PADDING_LEFT, "%-*.*s%6d of %-6d", MAX_OPT_LENGTH - 16, MAX_OPT_LENGTH - 16, label,
+			  (choice < count) ? choice + 1 : count, count);
+
+		for(int row = 0; row < page; row++) {
+			if (top + row < count) level_label(levels[first + top + row], label, sizeof(label));
+			else label[0] = '\0';
+			draw_menu_line(menu, row + 3, label, top + row == choice);
+		}
+
+		draw_menu_line(menu, page + 3, (catalog != NULL) ? level_orders[level_order] : "Back", choice == count);
+		if (catalog != NULL) {
+			draw_menu_line(menu, page + 4, level_filters[level_filter], choice == count + 1);
+			draw_menu_line(menu, page + 5, "Back", choice == count + 2);
+		}
+
+		// Until the chosen level's mini-map is ready, wake up now and then to draw it
+		thumb_state map_state = show_map ? draw_minimap(menu, map_x, page + num_extra, levels + first, count, choice) : THUMB_READY;
+		wtimeout(menu, (map_state == THUMB_MISSING || map_state == THUMB_PENDING) ? THUMB_POLL_MS : -1);
+
+		wrefresh(menu);
+		if (key != 0) lat_record(LAT_MENU);
+
+		if ((key = wgetch(menu)) == ERR) {
+			key = 0;
+			continue;
+		}
+		lat_mark();
+
+		switch (key) {
+			case '\n':
+				if (choice < count) {
+					choice = levels[first + choice];
+					delwin(menu);
+					clear();
+					return choice;
+				}
+				if (choice == count + num_extra - 1) {
+					delwin(menu);
+					clear();
+					return num_levels;
+				}
+
+				// Sort or filter the levels, and go back to the top of the list
+				if (choice == count) level_order = (level_order + 1) % LEVEL_ORDERS;
+				else level_filter = (level_filter + 1) % LEVEL_FILTERS;
+				top = 0;
+				break;
+
+			case KEY_UP:
+				choice = (choice == 0) ? count + num_extra - 1 : choice - 1;
+				break;
+
+			case KEY_DOWN:
+				choice = (choice + 1) % (count + num_extra);
+				break;
+
+			case KEY_PPAGE:
+				choice = (choice >= page) ? choice - page : 0;
+				top = (top >= page) ? top - page : 0;
+				break;
+
+			case KEY_NPAGE:
+				if (choice < count) {
+					choice = (choice + page < count) ? choice + page : count - 1;
+					top += page;
+				}
+				break;
+
+			case KEY_HOME:
+				choice = top = 0;
+				break;
+
+			case KEY_END:
+				choice = (count > 0) ? count - 1 : 0;
+				break;
+
+			case KEY_BACKSPACE:
+			case 127:
+			case '\b':
+				if (prefix_length > 0) {
+					prefix[--prefix_length] = '\0';
+					choice = top = 0;
+				}
+				break;
+
+			default:
+				if (key > ' ' && key < 127 && prefix_length < MAX_OPT_LENGTH - 26) {
+					prefix[prefix_length++] = (char)key;
+					prefix[prefix_length] = '\0';
+					choice = top = 0;
+				}
+				break;
+		}
+	}
+}
+
+/**
+ * Free the views of the level list kept by show_level_menu().
+ */
+void free_level_menu(void) {
+	if (thumbs_started) thumb_stop(&thumbs);
+	thumbs_started = false;
+
+	for(int o = 0; o < LEVEL_ORDERS; o++)
+		for(int f = 0; f < LEVEL_FILTERS; f++)
+			free(views.by_order[o][f]);
+	for(int f = 0; f < LEVEL_FILTERS; f++)
+		free(views.by_name[f]);
+	free(views.names);
+	free(views.entries);
+	memset(&views, 0, sizeof(views));
+
+	return;
+}
+
 /**
  * Show a manual page for how to play the Theseus and the Minotaur Game, depending on
  * the page number entered as an argument.
@@ -144,16 +542,18 @@ int show_manual(int page) {
 	// Show Manual Page #3
 	else if (page == 3) {
 		const char *title = "Controls";
-		height = 16;
+		height = 17;
 		width = 80;
 
-		manual_page = create_window(height, width, 3, 9,
+		manual_page = create_window(height, width, 3, 11,
 				"Move Theseus through the maze using the arrow keys. You can skip a turn",
 				"by pressing the space bar, which is actually quite useful at times.",
 				"",
 				"To return to the Main Menu:     Press \"m\".",
 				"To quit the game:               Press \"q\".",
 				"To restart the level:           Press \"r\".",
+				"To show latency statistics:     Press \"h\".",
+				"To edit the level:              Press \"e\".",
 				"",
 				"Ok, so it looks like you know everything to play the game. Now go",
 				"help Theseus escape from the Minotaur!"
@@ -258,6 +658,7 @@ int add_options(WINDOW *win, int num_options, ...) {
 	// If there's more than one menu option, let user select one
 	if (num_options != 1) {
 		while ((key = getch()) != '\n') {
+			lat_mark();
 		
 			switch (key) {
 				case KEY_LEFT:
@@ -267,6 +668,7 @@ int add_options(WINDOW *win, int num_options, ...) {
 
 						mvwchgat(win, max_y - 2, opt_positions[cur_choice], opt_lengths[cur_choice], A_REVERSE, 0, NULL);
 						wrefresh(win);
+						lat_record(LAT_MENU);
 					}
 					break;
 
@@ -277,6 +679,7 @@ int add_options(WINDOW *win, int num_options, ...) {
 
 						mvwchgat(win, max_y - 2, opt_positions[cur_choice], opt_lengths[cur_choice], A_REVERSE, 0, NULL);
 						wrefresh(win);
+						lat_record(LAT_MENU);
 					}
 					break;
 			}
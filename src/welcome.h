@@ -7,16 +7,41 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "analysis.h"
+#include "latency.h"
+#include "thumbnail.h"
+
 #define MIN_HEIGHT 5
 #define MAX_OPT_LENGTH 50
 #define PADDING_LEFT 3
 
 #define MAX_TITLE_LENGTH 50
+#define LEVEL_NAME_LENGTH 20	/* Level file names are cut to this length in the level menu */
+
+#define LEVEL_ORDERS 3		/* Orders the level menu can list the levels in */
+#define LEVEL_FILTERS 4		/* Filters the level menu can apply (all, easy, medium or hard levels) */
+#define THUMB_BEHIND 4		/* Mini-maps of the levels before the chosen one that are rendered ahead */
+#define THUMB_POLL_MS 30	/* How often the level menu checks for the chosen level's mini-map */
 
 #define MIN_MAN_OPTIONS 1
 #define MAX_MAN_OPTIONS 3
 #define NUM_MAN_PAGES 3
 
+// Structure to hold the views of a level list that the level menu pages through
+struct level_views {
+	char **level_list;			/* The list the views were built for */
+	int num_levels;
+	const struct catalog_entry *catalog;
+
+	const char **names;			/* File name of each level (without its directory) */
+	const struct catalog_entry **entries;	/* Catalog entry of each level (NULL if it has none) */
+
+	int *by_order[LEVEL_ORDERS][LEVEL_FILTERS];	/* Levels passing each filter in each order */
+	int order_sizes[LEVEL_ORDERS][LEVEL_FILTERS];
+	int *by_name[LEVEL_FILTERS];			/* Levels passing each filter, sorted by name */
+	int name_sizes[LEVEL_FILTERS];
+};
+
 /**
  * Draw a menu WINDOW to the screen with any number of menu items to choose from.
  * Highlight the current menu item as the user presses the up and down arrow keys.
@@ -34,6 +59,40 @@
  */
 int show_menu(int height, int width, const char *title, int size_array, char **opt_strings, int num_extra, ...);
 
+/**
+ * Show the "Choose Level File" menu for the levels of a level list. The menu only draws
+ * the page of levels that fits on the screen, so it works the same for lists of any size.
+ * Typing filters the levels down to the ones whose file name starts with the typed text
+ * (listed by name, and found with a binary search, so a key press costs the same however
+ * many levels there are); backspace takes the last character back. Page Up, Page Down,
+ * Home and End move a page or to either end of the list. If the screen is wide enough,
+ * the mini-map of the chosen level (see render_thumbnail()) is shown next to the list.
+ * The mini-maps are rendered by worker threads for the levels around the cursor, so level
+ * files are never read while the menu waits for keys.
+ *
+ * If the list has a catalog (see run_catalog()), every level is shown with its optimal
+ * number of turns and its difficulty, and two extra menu items sort the levels (in list
+ * order, easiest first or hardest first) and filter them (all, easy, medium or hard
+ * levels). The order and the filter are kept for the next time the menu is shown. The
+ * views of the list are built the first time they are needed, and kept until
+ * free_level_menu() is called.
+ *
+ * 'level_list' specifies the level file paths, in list order.
+ * 'num_levels' is the number of level file paths in 'level_list'.
+ * 'catalog' specifies the catalog entries of the list (NULL if there is no catalog).
+ * 'catalog_size' is the number of entries in 'catalog'.
+ *
+ * Return Value:
+ *	The function returns the index of the chosen level in 'level_list', or
+ *	'num_levels' if the user chose to go back.
+ */
+int show_level_menu(char **level_list, int num_levels, const struct catalog_entry *catalog, int catalog_size);
+
+/**
+ * Free the views of the level list kept by show_level_menu().
+ */
+void free_level_menu(void);
+
 /**
  * Show a manual page for how to play the Theseus and the Minotaur Game, depending on
  * the page number entered as an argument.
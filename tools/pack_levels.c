@@ -0,0 +1,185 @@
+/**
+ * pack_levels.c
+ *
+ * Level pack compiler for the Theseus and the Minotaur Game, run by 'make' before the game
+ * is built. Every level of a level list is read and checked the way the game reads it (see
+ * read_level_file()), and written out as C data: the rules, the size, the exit, the
+ * starting squares, the walls in file order and the bit-mask of valid moves of every square
+ * (see compute_move_masks()), with the level's metrics if the list has a catalog (see
+ * read_catalog()). The game plays that pack without reading any file (see levelpack.h).
+ * A level that can't be read or is invalid fails the build, and no output is written.
+ *
+ * Usage: pack_levels level_list output_file
+ */
+
+#include "analysis.h"
+#include "engine.h"
+#include "loader.h"
+
+// Write a string as a C string literal
+static void write_string(FILE *out, const char *text) {
+	fputc('"', out);
+	for(const unsigned char *c = (const unsigned char *)text; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') fprintf(out, "\\%c", *c);
+		else if (*c < ' ' || *c > '~') fprintf(out, "\\%03o", *c);
+		else fputc(*c, out);
+	}
+	fputc('"', out);
+
+	return;
+}
+
+// Write the walls and move masks of one level (the arrays its level_pack entry points to)
+static void write_arrays(FILE *out, int index, const struct stats *board) {
+	int nrows = board->size.num_rows, ncols = board->size.num_cols;
+	unsigned char masks[MAX_BOARD_Y * MAX_BOARD_X];
+
+	if (board->walls != NULL) {
+		fprintf(out, "static const struct packed_side walls_%d[] = {\n", index);
+		for(const cell_rel *wall = board->walls; wall != NULL; wall = wall->next)
+			fprintf(out, "\t{%d, %d, %d},\n", wall->relation.row, wall->relation.col, wall->location);
+		fprintf(out, "};\n\n");
+	}
+
+	compute_move_masks(board, masks);
+	fprintf(out, "static const unsigned char masks_%d[] = {\n", index);
+	for(int i = 0; i < nrows; i++) {
+		fputc('\t', out);
+		for(int j = 0; j < ncols; j++)
+			fprintf(out, "%2d,%s", masks[(i * ncols) + j], (j < ncols - 1) ? " " : "\n");
+	}
+	fprintf(out, "};\n\n");
+
+	return;
+}
+
+// Write the level_pack entry of one level
+static void write_entry(FILE *out, int index, const char *path, const struct stats *board, const struct catalog_entry *entry) {
+	int num_walls = 0;
+
+	for(const cell_rel *wall = board->walls; wall != NULL; wall = wall->next)
+		num_walls++;
+
+	fprintf(out, "\t{\n\t\t.path = ");
+	write_string(out, path);
+	fprintf(out, ",\n\t\t.rules = {%d, %d, %s},\n", board->rules.minotaur_steps, board->rules.theseus_steps, board->rules.vertical_first ? "true" : "false");
+	fprintf(out, "\t\t.size = {%d, %d},\n", board->size.num_rows, board->size.num_cols);
+	fprintf(out, "\t\t.exit = {%d, %d, %d},\n", board->exit.relation.row, board->exit.relation.col, board->exit.location);
+	fprintf(out, "\t\t.theseus = {%d, %d},\n\t\t.minotaurs = {", board->theseus.row, board->theseus.col);
+	for(int i = 0; i < board->num_minotaurs; i++)
+		fprintf(out, "%s{%d, %d}", (i > 0) ? ", " : "", board->minotaurs[i].row, board->minotaurs[i].col);
+	fprintf(out, "},\n\t\t.num_minotaurs = %d,\n", board->num_minotaurs);
+
+	if (num_walls > 0) fprintf(out, "\t\t.walls = walls_%d,\n", index);
+	else fprintf(out, "\t\t.walls = NULL,\n");
+	fprintf(out, "\t\t.num_walls = %d,\n\t\t.masks = masks_%d,\n", num_walls, index);
+
+	if (entry != NULL) {
+		const struct level_metrics *m = &entry->metrics;
+
+		fprintf(out, "\t\t.has_metrics = true,\n");
+		fprintf(out, "\t\t.metrics = {%s, %d, %d, %d, %ld, %ld, %.17g, %ld, %.17g}\n", m->solvable ? "true" : "false", m->turns,
+			m->first_moves, m->winning_moves, m->states, m->dead_states, m->branching, m->traps, m->difficulty);
+	}
+	else fprintf(out, "\t\t.has_metrics = false\n");
+	fprintf(out, "\t},\n");
+
+	return;
+}
+
+// Find the catalog entry of a level (NULL if it has none)
+static const struct catalog_entry *find_entry(const struct catalog_entry *catalog, int catalog_size, const char *path) {
+	for(int i = 0; i < catalog_size; i++)
+		if (strcmp(catalog[i].path, path) == 0) return &catalog[i];
+
+	return NULL;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s level_list output_file\n", argv[0]);
+		return 1;
+	}
+	const char *list_path = argv[1], *out_path = argv[2];
+
+	struct level_list list;
+	if (read_level_list(list_path, &list) != 0) {
+		fprintf(stderr, "pack_levels: %s: could not read level list\n", list_path);
+		return 1;
+	}
+	if (list.num_levels == 0) {
+		fprintf(stderr, "pack_levels: %s: the level list is empty\n", list_path);
+		return 1;
+	}
+
+	// Read and check every level before anything is written
+	struct stats *boards = calloc(list.num_levels, sizeof(struct stats));
+	if (boards == NULL) {
+		fprintf(stderr, "pack_levels: out of memory\n");
+		return 1;
+	}
+
+	bool ok = true;
+	for(int k = 0; k < list.num_levels; k++) {
+		int result = read_level_file(list.paths[k], &boards[k]);
+
+		if (result != 0) {
+			fprintf(stderr, "pack_levels: %s: %s (error code %d)\n", list.paths[k], (result == 1) ? "could not open level file" : "invalid level file", result);
+			boards[k].walls = NULL;
+			ok = false;
+		}
+	}
+	if (!ok) return 1;
+
+	struct catalog_entry *catalog = NULL;
+	int catalog_size = read_catalog(list_path, &catalog);
+	if (catalog_size < 0) catalog = NULL;
+
+	// Write the pack to a temporary file that then replaces the output, so a failed build leaves no pack behind
+	size_t tmp_size = strlen(out_path) + 5;
+	char *tmp_path = malloc(tmp_size);
+	if (tmp_path == NULL) {
+		fprintf(stderr, "pack_levels: out of memory\n");
+		return 1;
+	}
+	snprintf(tmp_path, tmp_size, "%s.tmp", out_path);
+
+	FILE *out = fopen(tmp_path, "w");
+	if (out == NULL) {
+		fprintf(stderr, "pack_levels: %s: could not open output file\n", tmp_path);
+		return 1;
+	}
+
+	fprintf(out, "/*\n * levelpack_data.c\n *\n * Generated by tools/pack_levels from %s: do not edit (run 'make' again instead).\n */\n\n", list_path);
+	fprintf(out, "#include \"levelpack.h\"\n\n");
+	for(int k = 0; k < list.num_levels; k++)
+		write_arrays(out, k, &boards[k]);
+
+	int num_metrics = 0;
+	fprintf(out, "const struct packed_level level_pack[] = {\n");
+	for(int k = 0; k < list.num_levels; k++) {
+		const struct catalog_entry *entry = find_entry(catalog, catalog_size, list.paths[k]);
+
+		write_entry(out, k, list.paths[k], &boards[k], entry);
+		num_metrics += (entry != NULL);
+	}
+	fprintf(out, "};\n\nconst int level_pack_size = %d;\n", list.num_levels);
+
+	bool written = !ferror(out);
+	if (fclose(out) != 0) written = false;
+	if (!written || rename(tmp_path, out_path) != 0) {
+		fprintf(stderr, "pack_levels: %s: could not write output file\n", out_path);
+		unlink(tmp_path);
+		return 1;
+	}
+	printf("pack_levels: %d levels from %s packed into %s (%d with metrics)\n", list.num_levels, list_path, out_path, num_metrics);
+
+	for(int k = 0; k < list.num_levels; k++)
+		free_walls(boards[k].walls);
+	free(boards);
+	free(catalog);
+	free(tmp_path);
+	free_level_list(&list);
+
+	return 0;
+}